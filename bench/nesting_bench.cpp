@@ -0,0 +1,129 @@
+// Нагрузочный тест глубокой вложенности: одно выражение глубины 10^3 .. 10^6 проходит
+// разбор, печать дерева, понижение в плоское AST, вычисление деревом и плоским AST и свертку
+// констант. Все эти проходы работают на явных стеках, поэтому время растет линейно, а
+// аварийного завершения из-за переполнения стека нет ни на какой глубине.
+//
+//   mathsol_bench_nesting [MAX_DEPTH]
+//
+// Печатает время каждого прохода в миллисекундах и значение выражения.
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <sstream>
+#include <string>
+#include "ast_printer.hpp"
+#include "constant_folder.hpp"
+#include "environment.hpp"
+#include "flat_ast.hpp"
+#include "flat_evaluator.hpp"
+#include "lexer.hpp"
+#include "parser.hpp"
+#include "source_reader.hpp"
+
+namespace {
+
+// Формы вложенности: скобки, унарные минусы, правоассоциативная степень, правые операнды
+enum class Shape { BRACKETS, NEGATIONS, POWERS, RIGHT_SUMS };
+
+const char* shapeName(Shape shape) {
+    switch (shape) {
+        case Shape::BRACKETS:  return "((..1..))";
+        case Shape::NEGATIONS: return "- - .. 1";
+        case Shape::POWERS:    return "1 ** 1 ..";
+        default:               return "1 + (1 + ..";
+    }
+}
+
+std::string expression(Shape shape, size_t depth) {
+    std::string text;
+    switch (shape) {
+        case Shape::BRACKETS:
+            text.append(depth, '(').append("1").append(depth, ')');
+            break;
+        case Shape::NEGATIONS:
+            for (size_t i = 0; i < depth; ++i) text.append("- ");
+            text.append("1");
+            break;
+        case Shape::POWERS:
+            for (size_t i = 0; i < depth; ++i) text.append("1 ** ");
+            text.append("1");
+            break;
+        case Shape::RIGHT_SUMS:
+            for (size_t i = 0; i < depth; ++i) text.append("1 + (");
+            text.append("1").append(depth, ')');
+            break;
+    }
+    return text.append("\n");
+}
+
+using Clock = std::chrono::steady_clock;
+
+double millisecondsSince(Clock::time_point start) {
+    return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+}
+
+bool run(Shape shape, size_t depth) {
+    std::string source = expression(shape, depth);
+    AstArena arena;
+    ViewReader reader(source);
+    Lexer lex(reader);
+    Parser parser(lex, arena);
+
+    Clock::time_point start = Clock::now();
+    IStatement* statement = parser.parseNext();
+    double parse = millisecondsSince(start);
+    if (!statement || parser.hasError()) {
+        std::fprintf(stderr, "%s depth %zu: parse error\n", shapeName(shape), depth);
+        return false;
+    }
+
+    std::ostringstream tree;
+    start = Clock::now();
+    {
+        AstPrinter printer(tree);
+        printer.print(*statement);
+    }
+    double print = millisecondsSince(start);
+
+    FlatAst flat;
+    start = Clock::now();
+    lowerToFlat(*statement, flat);
+    double lower = millisecondsSince(start);
+
+    Environment env;
+    const IExpression& root = *static_cast<const ExpressionStatement&>(*statement).expression_;
+    start = Clock::now();
+    Value value = root.evaluate(env);
+    double evaluate = millisecondsSince(start);
+
+    FlatEvaluator flatEvaluator(env);
+    start = Clock::now();
+    Value flatValue = flatEvaluator.evaluateStatement(flat, 0);
+    double evaluateFlat = millisecondsSince(start);
+
+    ConstantFolder folder;
+    start = Clock::now();
+    folder.fold(*statement, arena); // Последним: свертка заменяет дерево одним литералом
+    double fold = millisecondsSince(start);
+
+    if (!(value == flatValue)) {
+        std::fprintf(stderr, "%s depth %zu: tree and flat AST disagree\n", shapeName(shape), depth);
+        return false;
+    }
+    std::printf("%-12s %8zu %9.1f %9.1f %9.1f %9.1f %9.1f %9.1f   %s\n", shapeName(shape), depth,
+                parse, print, lower, evaluate, evaluateFlat, fold, formatValue(value).c_str());
+    return true;
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    size_t max_depth = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 1000000;
+    std::printf("%-12s %8s %9s %9s %9s %9s %9s %9s   %s\n", "shape", "depth", "parse", "print",
+                "lower", "evaluate", "flat", "fold", "value");
+    bool ok = true;
+    for (Shape shape : {Shape::BRACKETS, Shape::NEGATIONS, Shape::POWERS, Shape::RIGHT_SUMS}) {
+        for (size_t depth = 1000; depth <= max_depth; depth *= 10) ok = run(shape, depth) && ok;
+    }
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,185 @@
+// Microbenchmark of the lexer run kernels (scan_kernels.hpp) and of the whole lexer.
+//
+//   mathsol_bench_scan [MEGABYTES]
+//
+// Kernels: for every token class and run length, a buffer of runs (each followed by a byte that
+// ends it) is scanned run by run at every SIMD level the CPU supports, after checking that
+// every level finds the same run ends as the scalar code. Results are bytes per cycle (rdtsc
+// reference cycles on x86, nanoseconds elsewhere); the best of several passes is reported.
+// Lexer: Lexer::next() over generated scripts of MEGABYTES (default 8), in million tokens per second.
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+#include "lexer.hpp"
+#include "scan_kernels.hpp"
+#include "source_reader.hpp"
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#define MATHSOL_BENCH_RDTSC 1
+#endif
+
+namespace {
+
+uint64_t ticks() {
+#ifdef MATHSOL_BENCH_RDTSC
+  return __rdtsc();
+#else
+  return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+      std::chrono::steady_clock::now().time_since_epoch()).count());
+#endif
+}
+
+const char* const kTickUnit =
+#ifdef MATHSOL_BENCH_RDTSC
+    "bytes/cycle";
+#else
+    "bytes/ns";
+#endif
+
+enum class TokenClass { BLANK, IDENT, DIGITS, COMMENT };
+
+const char* className(TokenClass token) {
+  switch (token) {
+    case TokenClass::BLANK:  return "blank";
+    case TokenClass::IDENT:  return "ident";
+    case TokenClass::DIGITS: return "digits";
+    default:                 return "comment";
+  }
+}
+
+// Runs of `length` bytes of the class, each ended by a byte outside it, filling about `size` bytes
+std::string runs(TokenClass token, size_t length, size_t size) {
+  static const char kIdent[] = "abcdefghijklmnopqrstuvwxyzABCDEFGHIJKLMNOPQRSTUVWXYZ0123456789_-";
+  std::string text;
+  text.reserve(size + length + 1);
+  size_t i = 0;
+  while (text.size() < size) {
+    for (size_t k = 0; k < length; ++k, ++i) {
+      switch (token) {
+        case TokenClass::BLANK:  text.push_back(i % 5 == 0 ? '\t' : ' '); break;
+        case TokenClass::IDENT:  text.push_back(kIdent[i % (sizeof(kIdent) - 1)]); break;
+        case TokenClass::DIGITS: text.push_back(static_cast<char>('0' + i % 10)); break;
+        default:                 text.push_back(static_cast<char>(' ' + i % 90)); break; // no '\n'
+      }
+    }
+    text.push_back(token == TokenClass::COMMENT ? '\n' : ';');
+  }
+  return text;
+}
+
+const char* scan(const ScanKernels& kernels, TokenClass token, const char* p, const char* end) {
+  switch (token) {
+    case TokenClass::BLANK:  return kernels.skip_blanks(p, end);
+    case TokenClass::IDENT:  return kernels.skip_ident_tail(p, end);
+    case TokenClass::DIGITS: return kernels.skip_digits(p, end);
+    default:                 return kernels.find_char(p, end, '\n');
+  }
+}
+
+// Scans every run of `text`; returns the number of runs so the loop is not optimized away
+size_t scanAll(const ScanKernels& kernels, TokenClass token, const std::string& text) {
+  const char* p = text.data();
+  const char* end = p + text.size();
+  size_t count = 0;
+  while (p < end) {
+    p = scan(kernels, token, p, end) + 1; // Step over the byte that ended the run
+    ++count;
+  }
+  return count;
+}
+
+// Every level must end each run where the scalar kernel does
+bool sameRunEnds(const ScanKernels& kernels, TokenClass token, const std::string& text) {
+  const ScanKernels& scalar = scanKernels(SimdLevel::SCALAR);
+  const char* end = text.data() + text.size();
+  for (const char* p = text.data(); p < end; ++p) {
+    if (scan(kernels, token, p, end) != scan(scalar, token, p, end)) return false;
+  }
+  return true;
+}
+
+void benchKernels() {
+  const size_t kBufferSize = 64 * 1024; // Stays in L2, so the kernels and not memory are measured
+  const int kPasses = 20;
+  std::vector<SimdLevel> levels = {SimdLevel::SCALAR};
+  for (SimdLevel level : {SimdLevel::SSE2, SimdLevel::AVX2}) {
+    if (scanKernels(level).level == level) levels.push_back(level);
+  }
+
+  std::printf("%-8s %6s", "class", "run");
+  for (SimdLevel level : levels) std::printf(" %8s", simdLevelName(level));
+  std::printf("   (%s)\n", kTickUnit);
+
+  for (TokenClass token : {TokenClass::BLANK, TokenClass::IDENT, TokenClass::DIGITS, TokenClass::COMMENT}) {
+    for (size_t length : {8, 16, 64, 256, 1024}) {
+      std::string text = runs(token, length, kBufferSize);
+      std::printf("%-8s %6zu", className(token), length);
+      for (SimdLevel level : levels) {
+        const ScanKernels& kernels = scanKernels(level);
+        if (!sameRunEnds(kernels, token, text)) {
+          std::fprintf(stderr, "\n%s %s kernel disagrees with the scalar one\n", simdLevelName(level), className(token));
+          std::exit(1);
+        }
+        uint64_t best = UINT64_MAX;
+        size_t sink = 0;
+        for (int pass = 0; pass < kPasses; ++pass) {
+          uint64_t start = ticks();
+          sink += scanAll(kernels, token, text);
+          best = std::min(best, ticks() - start);
+        }
+        if (sink == 0) std::printf("?");
+        std::printf(" %8.2f", static_cast<double>(text.size()) / static_cast<double>(std::max<uint64_t>(best, 1)));
+      }
+      std::printf("\n");
+    }
+  }
+}
+
+// Script of about `size` bytes: long names, numbers and comments, or short-token expressions
+std::string script(bool long_tokens, size_t size) {
+  std::string text;
+  text.reserve(size + 256);
+  for (size_t i = 0; text.size() < size; ++i) {
+    std::string n = std::to_string(i);
+    if (long_tokens) {
+      text += "accumulated_total_value_" + n + " = previous_measurement_" + n + " * 1234567.891011    # running sum of the samples\n";
+    } else {
+      text += "x = (a + " + n + ") * b - c / 2\n";
+    }
+  }
+  return text;
+}
+
+void benchLexer(size_t megabytes) {
+  for (bool long_tokens : {true, false}) {
+    std::string text = script(long_tokens, megabytes << 20);
+    double best = 0;
+    size_t tokens = 0;
+    for (int pass = 0; pass < 3; ++pass) {
+      ViewReader reader(text);
+      Lexer lex(reader);
+      tokens = 0;
+      auto start = std::chrono::steady_clock::now();
+      while (lex.next().getType() != TokenType::_EOF) ++tokens;
+      std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+      best = std::max(best, static_cast<double>(tokens) / elapsed.count() / 1e6);
+    }
+    std::printf("lexer %-32s %zu MB, %zu tokens: %.1f Mtok/s\n",
+                long_tokens ? "long names/numbers/comments," : "short-token expressions,", megabytes, tokens, best);
+  }
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+  size_t megabytes = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 8;
+  std::printf("best level: %s\n", simdLevelName(scanKernels().level));
+  benchKernels();
+  benchLexer(megabytes == 0 ? 1 : megabytes);
+  return 0;
+}
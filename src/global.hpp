@@ -2,15 +2,30 @@
 
 #include <iostream>
 #include <fstream>
+#include <cstdlib>
+#include <filesystem>
 #include <string>
 #include <vector>
 
 #include "lexer/include/lexer.hpp"
+#include "lexer/include/source_file.hpp"
 #include "parser/include/parser.hpp"
 #include "parser/include/ast_printer.hpp"
+#include "parser/include/constant_folder.hpp"
+#include "parser/include/environment.hpp"
+#include "parser/include/flat_ast_printer.hpp"
+#include "parser/include/flat_evaluator.hpp"
+#include "parser/include/resolver.hpp"
+#include "parser/include/type_inference.hpp"
+#include "vm/include/aot.hpp"
+#include "vm/include/c_emitter.hpp"
+#include "vm/include/compiler.hpp"
+#include "vm/include/jit.hpp"
+#include "vm/include/script_cache.hpp"
+#include "vm/include/vm.hpp"
 
 // consts
 #define VERSION "0.1.0"
 
-// Chunk buffer size for file reading (in bytes)
-#define CHUNK_BUFFER_SIZE 8
+// Chunk buffer size for stream reading when a file cannot be memory-mapped (in bytes)
+#define CHUNK_BUFFER_SIZE 65536
@@ -1,22 +1,86 @@
 #pragma once
+#include <cstdint>
+#include <memory>
 #include <vector>
 #include <string>
+#include <string_view>
 #include "token.hpp"
+#include "source_buffer.hpp"
+#include "source_reader.hpp"
+#include "scan_kernels.hpp"
+#include "symbol_table.hpp"
+#include "thread_pool.hpp"
 
 class Lexer {
 public:
+  static constexpr size_t kDefaultBlockSize = 64 * 1024;
+  static constexpr size_t kMinParallelSegment = 256 * 1024;
+
   Lexer();
+
+  // Streaming lexer that pulls its input from `reader` on demand (see next())
+  explicit Lexer(SourceReader& reader, size_t blockSize = kDefaultBlockSize);
+
+  // Returns the next token from the reader, _EOF once the input is exhausted.
+  // Memory stays bounded: the input is held in two fixed-size blocks used in turn, and only
+  // the unfinished token is carried over when a block runs out. Values of the last two tokens
+  // returned stay valid, older ones may be overwritten. Keywords, operators and delimiters
+  // point into valueTT and are always valid.
+  Token next();
+
+  // Table the identifiers are interned into (SymbolTable::global() by default).
+  // Must outlive the lexer; symbols of tokens already returned are not remapped.
+  void setSymbolTable(SymbolTable& symbols) { symbols_ = &symbols; }
+  SymbolTable& symbolTable() const { return *symbols_; }
   
-  // Process source code and return tokens
+  // Process source code and return tokens.
+  // Token values are views into the lexer's source buffer and stay valid while the lexer is alive.
   std::vector<Token> tokenize(const std::string& sourceCode);
   
   // Get EOF token and finalize tokenization
   std::vector<Token> eof();
 
+  // Tokenize a complete source in place, including the final EOF token.
+  // Token values point into `source`, which must outlive them (e.g. a MappedFile).
+  std::vector<Token> tokenizeAll(std::string_view source);
+
+  // Same tokens as tokenizeAll(source), produced by lexing line-aligned segments on `pool`.
+  // Segments are at least `minSegment` bytes (smaller pieces cost more in setup than they win);
+  // inputs smaller than two segments are lexed on the calling thread.
+  std::vector<Token> tokenizeParallel(std::string_view source, ThreadPool& pool,
+                                      size_t minSegment = kMinParallelSegment);
+
 private:
-  std::string pending_token_value_;   // Raw string value of the last pending token
+  SourceBuffer source_;                   // Owns the text all token values point into
+  std::string_view pending_token_value_;  // Raw text of the last pending token (inside source_)
+  uint32_t line_;                         // Position of the next character to scan
+  uint32_t column_;
+  const ScanKernels* kernels_;            // SIMD run scanners picked for this CPU
+  SymbolTable* symbols_;                  // Identifiers of emitted tokens are interned here
+
+  // Streaming state for next()
+  struct Block {
+    std::unique_ptr<char[]> data;
+    size_t capacity = 0;
+  };
+  SourceReader* reader_ = nullptr;
+  Block blocks_[2];
+  int current_block_ = 0;                 // Block the window is in
+  int pinned_block_ = 1;                  // Block holding the last returned token, never refilled
+  std::string_view window_;               // Bytes read but not yet scanned start at window_[window_pos_]
+  size_t window_pos_ = 0;
+  bool reader_done_ = false;
+
+  bool refill_();
   
   // Internal token scanning methods
-  std::pair<Token, bool> scan_next_(const std::string& sourceCode, size_t& iter);
-  std::pair<Token, bool> scan_const_or_id_(const std::string& sourceCode, size_t& iter, std::string& value, bool initial_char_consumed);
+  void scan_all_(std::string_view source, std::vector<Token>& tokens);
+  std::pair<Token, bool> scan_next_(std::string_view sourceCode, size_t& iter);
+  std::pair<Token, bool> scan_token_(std::string_view sourceCode, size_t& iter);
+  std::pair<Token, bool> scan_identifier_(std::string_view sourceCode, size_t& iter);
+  std::pair<Token, bool> scan_const_or_id_(std::string_view sourceCode, size_t& iter, size_t start);
+  void advance_position_(std::string_view consumed);
+  void parse_number_(Token& token);
+  const Token& intern_(Token& token);
+  bool is_final_(const std::pair<Token, bool>& scanned, size_t iter, size_t size, bool more_input) const;
 };
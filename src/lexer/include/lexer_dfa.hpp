@@ -0,0 +1,95 @@
+#pragma once
+#include <cstdint>
+#include <string_view>
+#include "token.hpp"
+
+// Transition table for the fixed spellings of valueTT (operators, delimiters and keywords).
+// Built at compile time, so scanning a token is a walk over a flat array without allocations.
+//
+// State 0 is the dead state, state 1 is the start state. accept[s] is the token recognized
+// when the walk stops in state s, or TokenType::ERROR if s is not a final state.
+struct LexerDfa {
+  static constexpr int kAlphabet = 128;
+  static constexpr int kMaxStates = 128;
+
+  uint8_t next[kMaxStates][kAlphabet] {};
+  TokenType accept[kMaxStates] {};
+  int states = 2;
+
+  constexpr uint8_t step(uint8_t state, char c) const {
+    unsigned char uc = static_cast<unsigned char>(c);
+    return uc < kAlphabet ? next[state][uc] : 0;
+  }
+};
+
+// Character classes used by the scanner to pick a token kind from the first character
+enum class CharClass : uint8_t {
+  OTHER,        // not a valid token start
+  BLANK,        // ' ', '\t'
+  NEWLINE,      // '\n'
+  DIGIT,        // 0-9
+  IDENT,        // A-Z, a-z, _
+  QUOTE,        // ' "
+  COMMENT,      // #
+  PUNCT         // first character of an operator or delimiter
+};
+
+constexpr LexerDfa build_lexer_dfa() {
+  LexerDfa dfa;
+  for (int s = 0; s < LexerDfa::kMaxStates; s++) dfa.accept[s] = TokenType::ERROR;
+
+  for (int i = 0; i < static_cast<int>(TokenType::ERROR); i++) {
+    std::string_view spelling = valueTT[i];
+    if (spelling.empty() || spelling == "\n") continue; // EOL is handled by the scanner itself
+
+    uint8_t state = 1;
+    for (char c : spelling) {
+      unsigned char uc = static_cast<unsigned char>(c);
+      if (dfa.next[state][uc] == 0) {
+        if (dfa.states >= LexerDfa::kMaxStates) throw "LexerDfa::kMaxStates is too small for valueTT";
+        dfa.next[state][uc] = static_cast<uint8_t>(dfa.states++);
+      }
+      state = dfa.next[state][uc];
+    }
+    dfa.accept[state] = static_cast<TokenType>(i);
+  }
+  return dfa;
+}
+
+struct CharClassTable {
+  CharClass cls[256] {};
+  bool ident_tail[256] {}; // characters allowed after the first one of an identifier
+};
+
+constexpr CharClassTable build_char_classes() {
+  CharClassTable t;
+  for (int c = 0; c < 256; c++) t.cls[c] = CharClass::OTHER;
+
+  for (int i = 0; i < static_cast<int>(TokenType::ERROR); i++) {
+    std::string_view spelling = valueTT[i];
+    if (!spelling.empty()) t.cls[static_cast<unsigned char>(spelling[0])] = CharClass::PUNCT;
+  }
+  for (int c = 'a'; c <= 'z'; c++) t.cls[c] = CharClass::IDENT;
+  for (int c = 'A'; c <= 'Z'; c++) t.cls[c] = CharClass::IDENT;
+  for (int c = '0'; c <= '9'; c++) t.cls[c] = CharClass::DIGIT;
+  t.cls['_'] = CharClass::IDENT;
+  t.cls[' '] = CharClass::BLANK;
+  t.cls['\t'] = CharClass::BLANK;
+  t.cls['\n'] = CharClass::NEWLINE;
+  t.cls['\''] = CharClass::QUOTE;
+  t.cls['"'] = CharClass::QUOTE;
+  t.cls['#'] = CharClass::COMMENT;
+
+  for (int c = 0; c < 256; c++) {
+    t.ident_tail[c] = t.cls[c] == CharClass::IDENT || t.cls[c] == CharClass::DIGIT;
+  }
+  t.ident_tail['-'] = true; // identifiers may contain '-' (e.g. 'a-b')
+  return t;
+}
+
+inline constexpr LexerDfa kLexerDfa = build_lexer_dfa();
+inline constexpr CharClassTable kCharClasses = build_char_classes();
+
+inline CharClass char_class(char c) { return kCharClasses.cls[static_cast<unsigned char>(c)]; }
+inline bool is_ident_tail(char c) { return kCharClasses.ident_tail[static_cast<unsigned char>(c)]; }
+inline bool is_blank(char c) { return c == ' ' || c == '\t'; }
@@ -0,0 +1,30 @@
+#pragma once
+#include <cstddef>
+
+// Character-run kernels used by the lexer for its longest runs: blanks, identifier tails,
+// digits, and the search for the end of comments and strings.
+// Every kernel takes [p, end) and returns the first position that does not belong to the run
+// (or `end`). The SIMD variants compare 16 (SSE2) or 32 (AVX2) bytes at a time and finish
+// the last few bytes with the scalar code.
+
+enum class SimdLevel {
+  SCALAR,
+  SSE2,
+  AVX2
+};
+
+struct ScanKernels {
+  SimdLevel level;
+  const char* (*skip_blanks)(const char* p, const char* end);      // ' ', '\t'
+  const char* (*skip_ident_tail)(const char* p, const char* end);  // A-Z a-z 0-9 _ -
+  const char* (*skip_digits)(const char* p, const char* end);      // 0-9
+  const char* (*find_char)(const char* p, const char* end, char c);
+};
+
+// Kernels for the best instruction set supported by the running CPU (chosen once)
+const ScanKernels& scanKernels();
+
+// Kernels for a specific level; falls back to the closest supported level
+const ScanKernels& scanKernels(SimdLevel level);
+
+const char* simdLevelName(SimdLevel level);
@@ -0,0 +1,21 @@
+#pragma once
+#include <deque>
+#include <string>
+#include <string_view>
+
+// Append-only storage for source text.
+// Tokens keep std::string_view spans into it, so stored text never moves
+// and stays valid for the lifetime of the buffer.
+class SourceBuffer {
+public:
+  // Stores the concatenation of both parts and returns a view of the stored copy
+  std::string_view append(std::string_view head, std::string_view tail = {}) {
+    std::string& segment = segments_.emplace_back();
+    segment.reserve(head.size() + tail.size());
+    segment.append(head).append(tail);
+    return segment;
+  }
+
+private:
+  std::deque<std::string> segments_; // deque never relocates its elements on push_back
+};
@@ -0,0 +1,32 @@
+#pragma once
+#include <cstddef>
+#include <string>
+#include <string_view>
+
+// Read-only memory mapping of a whole source file.
+// The lexer scans the mapped bytes in place, so token values point straight into the mapping
+// and the file must stay mapped while its tokens are in use.
+class MappedFile {
+public:
+  MappedFile() = default;
+  ~MappedFile();
+
+  MappedFile(const MappedFile&) = delete;
+  MappedFile& operator=(const MappedFile&) = delete;
+
+  // Maps a regular file. Returns false for anything that cannot be mapped
+  // (pipes, terminals, unsupported platforms); callers then fall back to stream reading.
+  bool open(const std::string& path);
+  void close();
+
+  std::string_view view() const { return { data_, size_ }; }
+
+  // Drops the pages that lie wholly before offset `end` from memory. They are read back
+  // from the file if touched again, so this only bounds the resident size of a long scan.
+  void release(size_t end);
+
+private:
+  const char* data_ = nullptr;
+  size_t size_ = 0;
+  bool mapped_ = false;
+};
@@ -0,0 +1,46 @@
+#pragma once
+#include <cstddef>
+#include <cstring>
+#include <istream>
+#include <string_view>
+
+// Pull interface used by the streaming lexer to get more source bytes
+class SourceReader {
+public:
+  virtual ~SourceReader() = default;
+
+  // Copies up to `capacity` bytes into `buffer` and returns how many were copied.
+  // Returning 0 means the end of the input.
+  virtual size_t read(char* buffer, size_t capacity) = 0;
+};
+
+// Reads from any std::istream (files that cannot be mapped, pipes, std::cin)
+class StreamReader : public SourceReader {
+public:
+  explicit StreamReader(std::istream& in) : in_(in) {}
+
+  size_t read(char* buffer, size_t capacity) override {
+    in_.read(buffer, static_cast<std::streamsize>(capacity));
+    return static_cast<size_t>(in_.gcount());
+  }
+
+private:
+  std::istream& in_;
+};
+
+// Reads bytes that are already in memory (a mapped file) block by block, so the streaming
+// lexer can scan them without building the whole token list
+class ViewReader : public SourceReader {
+public:
+  explicit ViewReader(std::string_view text) : text_(text) {}
+
+  size_t read(char* buffer, size_t capacity) override {
+    size_t count = text_.size() < capacity ? text_.size() : capacity;
+    std::memcpy(buffer, text_.data(), count);
+    text_.remove_prefix(count);
+    return count;
+  }
+
+private:
+  std::string_view text_;
+};
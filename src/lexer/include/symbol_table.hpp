@@ -0,0 +1,39 @@
+#pragma once
+#include <cstdint>
+#include <memory>
+#include <string_view>
+#include <vector>
+
+// Dense 32-bit ID of an identifier or keyword spelling
+using Symbol = uint32_t;
+
+// Interner that maps every spelling to one Symbol and stores each spelling once.
+// Keywords are interned first, so the symbol of a keyword equals its TokenType value.
+// Names returned by name() stay valid for the lifetime of the table.
+// Not thread-safe: lexers running concurrently must each use their own table.
+class SymbolTable {
+public:
+  SymbolTable();
+
+  SymbolTable(const SymbolTable&) = delete;
+  SymbolTable& operator=(const SymbolTable&) = delete;
+
+  Symbol intern(std::string_view spelling);
+  std::string_view name(Symbol symbol) const { return names_[symbol]; }
+  size_t size() const { return names_.size(); }
+
+  // Table shared by the lexer, parser and runtime of the process
+  static SymbolTable& global();
+
+private:
+  static constexpr size_t kStorageBlock = 64 * 1024;
+
+  std::vector<std::string_view> names_;  // by Symbol, pointing into storage_
+  std::vector<uint64_t> hashes_;         // by Symbol, reused when the slot array grows
+  std::vector<uint32_t> slots_;          // open addressing, Symbol + 1 (0 = empty)
+  std::vector<std::unique_ptr<char[]>> storage_;
+  size_t storage_used_ = kStorageBlock;
+
+  std::string_view store_(std::string_view spelling);
+  void grow_();
+};
@@ -0,0 +1,45 @@
+#pragma once
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Fixed set of worker threads for data-parallel loops.
+// The calling thread takes part in every loop, so a pool of size 1 has no workers
+// and runs everything inline.
+class ThreadPool {
+public:
+  explicit ThreadPool(size_t threads = defaultThreads());
+  ~ThreadPool();
+
+  ThreadPool(const ThreadPool&) = delete;
+  ThreadPool& operator=(const ThreadPool&) = delete;
+
+  // Threads taking part in a loop, including the caller
+  size_t size() const { return workers_.size() + 1; }
+
+  // Runs fn(i) for every i in [0, count) and returns once all calls are done.
+  // Indices are handed out one at a time, so uneven items balance across threads.
+  // Not reentrant: fn must not call parallelFor on the same pool.
+  void parallelFor(size_t count, const std::function<void(size_t)>& fn);
+
+  static size_t defaultThreads();
+
+private:
+  std::vector<std::thread> workers_;
+  std::mutex mutex_;
+  std::condition_variable wake_;     // workers wait here for the next loop
+  std::condition_variable finished_; // the caller waits here for the workers
+  const std::function<void(size_t)>* job_ = nullptr;
+  size_t count_ = 0;
+  std::atomic<size_t> next_index_{0};
+  size_t generation_ = 0;            // bumped for each loop, wakes the workers
+  size_t busy_ = 0;                  // workers still inside the current loop
+  bool stopping_ = false;
+
+  void work_();
+  void run_items_(const std::function<void(size_t)>& fn, size_t count);
+};
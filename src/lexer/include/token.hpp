@@ -1,8 +1,11 @@
 #pragma once
+#include <cstdint>
 #include <iostream>
 #include <string>
+#include <string_view>
+#include "symbol_table.hpp"
 
-enum class TokenType {
+enum class TokenType : uint8_t {
   // Ключевые слова
   KEYWORD_IF,
   KEYWORD_ELSE,
@@ -150,7 +153,9 @@ const std::string nameTT [] = {
   "ERROR"
 };
 
-const std::string valueTT [] = {
+// Fixed spellings, indexed by TokenType. Empty entries have no fixed spelling.
+// constexpr so that the lexer can build its transition table at compile time.
+inline constexpr std::string_view valueTT [] = {
   // Ключевые слова
   "if",               // KEYWORD_IF
   "else",             // KEYWORD_ELSE
@@ -223,24 +228,76 @@ const std::string valueTT [] = {
   ""    // ERROR
 };
 
+static_assert(std::size(valueTT) == static_cast<size_t>(TokenType::ERROR) + 1, "valueTT must cover every TokenType");
 
+
+// Keywords, operators and delimiters (everything declared before DELIMETER_COMMENT)
+// are always spelled exactly as in valueTT
+inline bool hasFixedSpelling(TokenType type) { return type < TokenType::DELIMETER_COMMENT; }
+
+// Diagnostics attached to ERROR tokens
+enum class LexError : uint8_t {
+  NONE,                 // unexpected character / unfinished input, see the token text
+  NUMBER_OUT_OF_RANGE,  // literal overflows double (inf)
+  INVALID_NUMBER        // malformed numeric literal
+};
+
+const std::string_view lexErrorMessage [] = {
+  "unexpected input",
+  "numeric literal out of range",
+  "invalid numeric literal"
+};
+
+// Compact token: type, position and a span of its text.
+// The span points into the lexer's source buffer (or into valueTT for fixed spellings),
+// so a token is cheap to copy and never owns memory.
+// CONSTANT_NUM tokens also carry the value parsed by the lexer, ERROR tokens carry a LexError,
+// IDENTIFIER tokens carry their interned Symbol.
 class Token {
 public:
   Token(TokenType type)
-    : type_(type), value_() {}
+    : Token(type, valueTT[static_cast<size_t>(type)]) {}
     
-  Token(TokenType type, std::string value)
-    : type_(type), value_(value) {}
+  Token(TokenType type, std::string_view value, uint32_t line = 0, uint32_t column = 0)
+    : text_(value.data()), length_(static_cast<uint32_t>(value.size())), line_(line), column_(column), type_(type) {
+    if (type == TokenType::ERROR) error_ = LexError::NONE;
+  }
 
   TokenType getType() const { return type_; }
-  std::string getValue() const { return value_; }
+  std::string_view getValue() const { return { text_, length_ }; }
+  uint32_t getLine() const { return line_; }     // 1-based, 0 if unknown
+  uint32_t getColumn() const { return column_; } // 1-based, 0 if unknown
+
+  // CONSTANT_NUM: literals without a fraction are kept as exact int64
+  bool isInteger() const { return is_integer_; }
+  int64_t getInteger() const { return is_integer_ ? integer_ : static_cast<int64_t>(number_); }
+  double getNumber() const { return is_integer_ ? static_cast<double>(integer_) : number_; }
+
+  LexError getError() const { return type_ == TokenType::ERROR ? error_ : LexError::NONE; }
+
+  // IDENTIFIER: symbol assigned by the lexer's SymbolTable; keywords: their TokenType value
+  Symbol getSymbol() const { return type_ == TokenType::IDENTIFIER ? symbol_ : static_cast<Symbol>(type_); }
   
   friend bool operator==(const Token& lhs, const Token& rhs) { return lhs.getType() == rhs.getType(); }
   friend bool operator!=(const Token& lhs, const Token& rhs) { return lhs.getType() != rhs.getType(); }
 
 private:
+  friend class Lexer; // stamps positions and parsed values
+
+  const char* text_;
+  uint32_t length_;
+  uint32_t line_;
+  uint32_t column_;
   TokenType type_;
-  std::string value_;
+  bool is_integer_ = false;
+  union {
+    double number_ = 0.0;
+    int64_t integer_;
+    LexError error_;
+    Symbol symbol_;
+  };
 };
 
+static_assert(sizeof(Token) <= 32, "Token is expected to stay compact");
+
 std::ostream& operator << (std::ostream& outs, const Token& t);
\ No newline at end of file
@@ -1,221 +1,307 @@
 #include "lexer.hpp"
-#include <set>
+#include "lexer_dfa.hpp"
+#include <algorithm>
+#include <charconv>
+#include <cstring>
 
-Lexer::Lexer() : pending_token_value_("") {}
+Lexer::Lexer() : pending_token_value_(), line_(1), column_(1), kernels_(&scanKernels()), symbols_(&SymbolTable::global()) {}
 
-std::pair<Token, bool> Lexer::scan_next_(const std::string& chunk, size_t& iter) {
-  // pending_ обрабатывается в tokenize путем конкатенации
-  size_t last_index = chunk.size() - 1;
-  size_t local_index = 0;
-  std::set<int> valid_tokens;
-  std::string value = "";
-  bool separated = false;
+Lexer::Lexer(SourceReader& reader, size_t blockSize) : Lexer() {
+  reader_ = &reader;
+  for (Block& block : blocks_) {
+    block.capacity = blockSize;
+    block.data = std::make_unique<char[]>(blockSize);
+  }
+  window_ = std::string_view(blocks_[current_block_].data.get(), 0);
+}
+
+// A token that runs into the end of the available text may continue in the next chunk
+// (e.g. '+' that becomes '+=', or half of an identifier) unless it is known to be closed:
+// closing quote, end of comment, EOL, or a following blank.
+bool Lexer::is_final_(const std::pair<Token, bool>& scanned, size_t iter, size_t size, bool more_input) const {
+  return !more_input || iter < size || scanned.second;
+}
+
+Token Lexer::next() {
+  if (reader_ == nullptr) return Token(TokenType::_EOF, "EOF", line_, column_);
+
+  for (;;) {
+    size_t iter = window_pos_;
+    std::pair<Token, bool> scanned = scan_next_(window_, iter);
+
+    if (scanned.first.getType() == TokenType::PENDING) {
+      // Only blanks were left in the window
+      window_pos_ = iter;
+      if (!refill_()) return Token(TokenType::_EOF, "EOF", line_, column_);
+      continue;
+    }
+
+    if (!is_final_(scanned, iter, window_.size(), !reader_done_)) {
+      // Unfinished token: rescan it from its first character once more input is in the window
+      window_pos_ = iter - scanned.first.getValue().size();
+      line_ = scanned.first.getLine();
+      column_ = scanned.first.getColumn();
+      refill_();
+      continue;
+    }
+
+    window_pos_ = iter;
+    pinned_block_ = current_block_;
+    return intern_(scanned.first);
+  }
+}
+
+// Moves the unscanned tail of the window to the front of a block that is not pinned
+// and fills the rest of that block from the reader. Returns false at the end of input.
+bool Lexer::refill_() {
+  if (reader_done_) return false;
 
+  std::string_view tail = window_.substr(window_pos_);
+  int target = current_block_ == pinned_block_ ? current_block_ ^ 1 : current_block_;
+  Block& block = blocks_[target];
+
+  if (tail.size() > block.capacity / 2) {
+    // A single token longer than half a block: grow so the refill still makes progress
+    size_t capacity = block.capacity * 2;
+    while (tail.size() > capacity / 2) capacity *= 2;
+    std::unique_ptr<char[]> data = std::make_unique<char[]>(capacity);
+    std::copy(tail.begin(), tail.end(), data.get());
+    block.data = std::move(data);
+    block.capacity = capacity;
+  } else {
+    // memmove: the tail may already be inside the target block
+    std::memmove(block.data.get(), tail.data(), tail.size());
+  }
+
+  size_t read = reader_->read(block.data.get() + tail.size(), block.capacity - tail.size());
+  if (read == 0) reader_done_ = true;
+
+  current_block_ = target;
+  window_ = std::string_view(block.data.get(), tail.size() + read);
+  window_pos_ = 0;
+  return true;
+}
+
+std::pair<Token, bool> Lexer::scan_next_(std::string_view chunk, size_t& iter) {
+  // pending_ обрабатывается в tokenize путем конкатенации
   if (iter >= chunk.size()) return { Token(TokenType::PENDING, "PENDING_EOF_REACHED"), false }; // Используем PENDING, если чанк закончился
   
   // Skip whitespace
-  while (iter < chunk.size() && (chunk[iter] == ' ' || chunk[iter] == '\t')) iter++;
+  size_t blank_start = iter;
+  iter = static_cast<size_t>(kernels_->skip_blanks(chunk.data() + iter, chunk.data() + chunk.size()) - chunk.data());
+  column_ += static_cast<uint32_t>(iter - blank_start);
   if (iter >= chunk.size()) {
     return { Token(TokenType::PENDING, "PENDING_AFTER_WHITESPACE"), false }; // Закончился чанк после пробелов
   };
-  value += chunk[iter];
 
-  // Check for newline character
-  if (chunk[iter] == '\n') {
-    iter++;
-    return { Token(TokenType::EOL, "EOL"), true };
+  size_t start = iter;
+  std::pair<Token, bool> scanned = scan_token_(chunk, iter);
+
+  // Stamp the token with the position of its first character and move past its text.
+  // Fixed spellings point into valueTT, so they outlive the source text.
+  TokenType tt = scanned.first.getType();
+  Token located(tt, hasFixedSpelling(tt) ? valueTT[static_cast<size_t>(tt)] : scanned.first.getValue(), line_, column_);
+  if (tt == TokenType::CONSTANT_NUM) parse_number_(located);
+  advance_position_(chunk.substr(start, iter - start));
+  return { located, scanned.second };
+}
+
+// Numbers are converted once, here, with the locale-independent std::from_chars.
+// Literals without a fraction stay exact int64 when they fit and become doubles otherwise.
+// Only a literal that overflows double, or a malformed one, turns the token into an ERROR
+// carrying the reason instead of throwing; one too small for double is 0.
+void Lexer::parse_number_(Token& token) {
+  std::string_view text = token.getValue();
+  const char* first = text.data();
+  const char* last = first + text.size();
+
+  if (text.find('.') == std::string_view::npos) {
+    std::from_chars_result result = std::from_chars(first, last, token.integer_);
+    token.is_integer_ = true;
+    if (result.ec == std::errc() && result.ptr == last) return;
+    token.is_integer_ = false;
+  }
+  std::from_chars_result result = std::from_chars(first, last, token.number_, std::chars_format::fixed);
+  if (result.ptr == last && result.ec == std::errc()) return;
+  if (result.ptr == last && result.ec == std::errc::result_out_of_range) {
+    // from_chars reports underflow and overflow alike: a literal below 1 can only underflow
+    size_t integer_digits = std::min(text.find('.'), text.size());
+    if (text.substr(0, integer_digits).find_first_not_of('0') == std::string_view::npos) {
+      token.number_ = 0.0;
+      return;
+    }
+    token.error_ = LexError::NUMBER_OUT_OF_RANGE;
+  } else {
+    token.error_ = LexError::INVALID_NUMBER;
   }
+  token.type_ = TokenType::ERROR;
+}
 
-  for (int i = 0; i < static_cast<int>(TokenType::ERROR); i++) {
-    if (valueTT[i][local_index] == value[local_index]) valid_tokens.insert(i);
+// Identifiers are interned only when their token is emitted: a token cut by the end of
+// a chunk is rescanned later, and its partial spelling must not end up in the table.
+const Token& Lexer::intern_(Token& token) {
+  if (token.type_ == TokenType::IDENTIFIER) token.symbol_ = symbols_->intern(token.getValue());
+  return token;
+}
+
+void Lexer::advance_position_(std::string_view consumed) {
+  size_t last_newline = consumed.rfind('\n');
+  if (last_newline == std::string_view::npos) {
+    column_ += static_cast<uint32_t>(consumed.size());
+    return;
   }
+  for (char c : consumed) line_ += (c == '\n');
+  column_ = static_cast<uint32_t>(consumed.size() - last_newline);
+}
 
-  iter++;
-  local_index++;
-  while (iter <= last_index) {
-    if (chunk[iter] == ' ' || chunk[iter] == '\t') {
-      separated = true;
-      break;
-    }
-    value += chunk[iter];
-
-    std::set<int> tokens_to_erase;
-    for (int i : valid_tokens) {
-      if (valueTT[i].size() <= local_index || valueTT[i][local_index] != value[local_index]) tokens_to_erase.insert(i);
-      //else if (valueTT[i][local_index] != value[local_index]) tokens_to_erase.insert(i); // Объединено выше
-      else if (valueTT[i][local_index] != value[local_index]) tokens_to_erase.insert(i);
-      //else continue; // Лишнее
-    }
-    if (valid_tokens.size() == tokens_to_erase.size() && !value.empty()) { 
-      value.pop_back(); // Убираем последний символ, который сделал все невалидным
-      // iter--; // iter должен указывать на символ *после* успешно разобранной части токена.
-      // Этот декремент приводил к зацикливанию на односимвольных токенах.
-      break; 
+std::pair<Token, bool> Lexer::scan_token_(std::string_view chunk, size_t& iter) {
+  size_t start = iter;
+  switch (char_class(chunk[iter])) {
+    case CharClass::NEWLINE:
+      iter++;
+      return { Token(TokenType::EOL, "EOL"), true };
+
+    case CharClass::IDENT:
+      return scan_identifier_(chunk, iter);
+
+    case CharClass::PUNCT: {
+      // Longest match over the operator/delimiter transitions
+      uint8_t state = 1;
+      TokenType matched = TokenType::ERROR;
+      size_t matched_end = start;
+      while (iter < chunk.size()) {
+        state = kLexerDfa.step(state, chunk[iter]);
+        if (state == 0) break;
+        iter++;
+        if (kLexerDfa.accept[state] != TokenType::ERROR) {
+          matched = kLexerDfa.accept[state];
+          matched_end = iter;
+        }
+      }
+      if (matched == TokenType::ERROR) {
+        // Prefix of an operator that never completed (e.g. a lone '&')
+        iter = start + 1;
+        return { Token(TokenType::ERROR, chunk.substr(start, 1)), false };
+      }
+      iter = matched_end;
+      bool separated = iter < chunk.size() && is_blank(chunk[iter]);
+      return { Token(matched, chunk.substr(start, iter - start)), separated };
     }
-    for (int t : tokens_to_erase) valid_tokens.erase(t);
 
-    if (valid_tokens.size() == 1) {
+    case CharClass::OTHER: {
       iter++;
-      std::string target_value = valueTT[*(valid_tokens.begin())];
-      // iter уже инкрементирован, value содержит потенциальное начало токена
-      std::pair<Token, bool> scanned = scan_const_or_id_(chunk, iter, value, true);
-      if (target_value == scanned.first.getValue()) return { Token(static_cast<TokenType>(*(valid_tokens.begin())), value), scanned.second };
-      else return scanned;
+      return { Token(TokenType::ERROR, chunk.substr(start, 1)), false };
     }
-    iter++; local_index++;
-  }
 
-  if (valid_tokens.size() >= 1) {
-    for (int i : valid_tokens) {
-      if (valueTT[i] == value) return { Token(static_cast<TokenType>(i), value), separated };
-    }
+    default:
+      // Numbers, strings and comments
+      iter++;
+      return scan_const_or_id_(chunk, iter, start);
   }
-  // iter НЕ инкрементирован после последнего добавления в value, если мы здесь
-  // value содержит то, что не подошло ни под один valueTT
-  return scan_const_or_id_(chunk, iter, value, false);
 }
 
+std::pair<Token, bool> Lexer::scan_identifier_(std::string_view chunk, size_t& iter) {
+  // The run of identifier characters is found by the SIMD kernel; the spelling is then
+  // walked through the DFA and is a keyword only if it ends in a keyword state.
+  // Keywords are short, so the walk stops at the dead state after a few characters.
+  size_t start = iter;
+  const char* end = chunk.data() + chunk.size();
+  iter = static_cast<size_t>(kernels_->skip_ident_tail(chunk.data() + start + 1, end) - chunk.data());
+
+  uint8_t state = 1;
+  for (size_t i = start; i < iter && state != 0; i++) state = kLexerDfa.step(state, chunk[i]);
+  TokenType tt = kLexerDfa.accept[state] != TokenType::ERROR ? kLexerDfa.accept[state] : TokenType::IDENTIFIER;
+  bool separated = iter < chunk.size() && is_blank(chunk[iter]);
+  return { Token(tt, chunk.substr(start, iter - start)), separated };
+}
 
-std::pair<Token, bool> Lexer::scan_const_or_id_(const std::string& chunk, size_t& iter, std::string& value, bool initial_char_consumed) {
+
+std::pair<Token, bool> Lexer::scan_const_or_id_(std::string_view chunk, size_t& iter, size_t start) {
+  // Первый символ токена (chunk[start]) уже принят, iter указывает на следующий символ для проверки.
+  // Значение токена - это срез chunk[start, iter), без копирования.
   TokenType tt = TokenType::ERROR;
-  if (value[0] == '#') {                                      // DELIMETER_COMMENT
+  char first = chunk[start];
+  const char* begin = chunk.data();
+  const char* end = begin + chunk.size();
+  if (first == '#') {                                         // DELIMETER_COMMENT
     tt = TokenType::DELIMETER_COMMENT;
-    while (iter < chunk.size()) {
-      if (chunk[iter] != '\n') value += chunk[iter];
-      else {
-        // iter--; // Не нужно, так как EOL будет обработан на следующей итерации scan_next_
-        return { Token(TokenType::DELIMETER_COMMENT, value), true }; // Комментарий всегда отделен (EOL или EOF)
-      }
-      iter++;
+    iter = static_cast<size_t>(kernels_->find_char(begin + iter, end, '\n') - begin);
+    if (iter < chunk.size()) {
+      // EOL будет обработан на следующей итерации scan_next_
+      return { Token(TokenType::DELIMETER_COMMENT, chunk.substr(start, iter - start)), true }; // Комментарий всегда отделен (EOL или EOF)
     }
-  } else if (value[0] >= '0' && value[0] <= '9') {            // CONSTANT_NUM
+  } else if (first >= '0' && first <= '9') {                  // CONSTANT_NUM
     tt = TokenType::CONSTANT_NUM;
-    bool doted = false;
-    // Первый символ уже в value
-    // iter указывает на следующий символ для проверки
-    while (iter < chunk.size()) {
-      if (chunk[iter] >= '0' && chunk[iter] <= '9') value += chunk[iter];
-      else if (chunk[iter] == '.' && !doted) {
-        value += chunk[iter];
-        doted = true;
-      }
-      else { 
-        // Встретили символ, не являющийся частью числа. Завершаем число.
-        // separated будет true, если chunk[iter] это пробел или табуляция
-        bool separated_after = (iter < chunk.size() && (chunk[iter] == ' ' || chunk[iter] == '	'));
-        return { Token(TokenType::CONSTANT_NUM, value), separated_after }; 
-      }
-      iter++;
+    // Цифры, затем не более одной точки и снова цифры
+    const char* p = kernels_->skip_digits(begin + iter, end);
+    if (p < end && *p == '.') p = kernels_->skip_digits(p + 1, end);
+    iter = static_cast<size_t>(p - begin);
+    if (p < end) {
+      // Встретили символ, не являющийся частью числа. Завершаем число.
+      // separated будет true, если это пробел или табуляция
+      return { Token(TokenType::CONSTANT_NUM, chunk.substr(start, iter - start)), is_blank(*p) };
     }
-  } else if (value[0] == '\'' || value[0] == '\"') {         // CONSTANT_STRING
+  } else if (first == '\'' || first == '\"') {                // CONSTANT_STRING
     tt = TokenType::CONSTANT_STRING;
-    char opener = value[0];
-    // Первый символ уже в value (открывающая кавычка)
-    // iter указывает на следующий символ для проверки
-    while (iter < chunk.size()) {
-      if (chunk[iter] != opener) value += chunk[iter];
-      else if (chunk[iter] == '\n') {
-        // iter--; // Не нужно, ошибка синтаксиса, перевод строки внутри строки без экранирования
-        return { Token(TokenType::ERROR, "Wrong syntax (newline in string): \"" + value + "\""), true };
-      }
-      else {
-        value += chunk[iter];
-        iter++;
-        return { Token(TokenType::CONSTANT_STRING, value), true };
-      }
-      iter++;
-    }
-  } else if (value[0] == '_'                                  // IDENTIFIER
-    || (value[0] >= 'A' && value[0] <= 'Z') 
-    || (value[0] >= 'a' && value[0] <= 'z')) { 
-    tt = TokenType::IDENTIFIER;
-    // Первый символ уже в value
-    // iter указывает на следующий символ для проверки
-    while (iter < chunk.size()) {
-      if (chunk[iter] == '-' 
-        || chunk[iter] == '_' 
-        || (chunk[iter] >= 'A' && chunk[iter] <= 'Z') 
-        || (chunk[iter] >= 'a' && chunk[iter] <= 'z')
-        || (chunk[iter] >= '0' && chunk[iter] <= '9')) 
-      value += chunk[iter];
-      else { 
-        // Встретили символ, не являющийся частью идентификатора. Завершаем идентификатор.
-        bool separated_after = (iter < chunk.size() && (chunk[iter] == ' ' || chunk[iter] == '	'));
-        return { Token(TokenType::IDENTIFIER, value), separated_after }; 
-      }
+    // Открывающая кавычка уже принята, ищем закрывающую
+    iter = static_cast<size_t>(kernels_->find_char(begin + iter, end, first) - begin);
+    if (iter < chunk.size()) {
       iter++;
+      return { Token(TokenType::CONSTANT_STRING, chunk.substr(start, iter - start)), true };
     }
+  } else if (char_class(first) == CharClass::IDENT) {         // IDENTIFIER
+    iter = start;
+    return scan_identifier_(chunk, iter);
   }
   // Если цикл завершился из-за конца чанка (iter == chunk.size())
   // то токен считается завершенным, но не обязательно отделенным пробелом (separated = false)
-  return { Token(tt, value), false };  
+  return { Token(tt, chunk.substr(start, iter - start)), false };  
 }
 
 std::vector<Token> Lexer::tokenize(const std::string& source_chunk) {
-  std::string current_input = pending_token_value_; // Начинаем с остатка от предыдущего раза
-  pending_token_value_.clear(); // Сбрасываем pending перед новой обработкой
-  current_input += source_chunk; // Добавляем новый кусок
-
-  if (current_input.empty()) return {};
+  // Начинаем с остатка от предыдущего раза. Текст хранится в source_, поэтому
+  // значения токенов (std::string_view) остаются валидными, пока жив лексер.
+  std::string_view current_input = source_.append(pending_token_value_, source_chunk);
+  pending_token_value_ = {}; // Сбрасываем pending перед новой обработкой
 
   std::vector<Token> tokens;
   size_t iter = 0;
-  Token current_token = Token(TokenType::ERROR);
-  bool current_token_separated = false;
-
-  // Для отслеживания последнего токена, добавленного в `tokens` в этом чанке
-  Token last_added_token_in_chunk = Token(TokenType::ERROR);
-  bool last_added_token_separated = false;
-  bool token_was_added_in_loop = false;
-
-  do {
+  while (iter < current_input.size()) {
     std::pair<Token, bool> scanned = scan_next_(current_input, iter);
-    current_token = scanned.first;
-    current_token_separated = scanned.second;
-    if (current_token.getType() == TokenType::PENDING) {
-      if (iter < current_input.size()) {
-        pending_token_value_ = current_input.substr(iter);
-      }
-      break; 
-    }
+    if (scanned.first.getType() == TokenType::PENDING) break; // Чанк закончился пробелами
 
-    if (current_token.getType() == TokenType::ERROR && current_token.getValue().empty() && iter >= current_input.size()) {
-      // Это может быть ситуация, когда scan_next_ ничего не нашел в пустом остатке current_input
-      // Не добавляем такой ERROR токен и выходим.
+    if (!is_final_(scanned, iter, current_input.size(), true)) {
+      // Токен упирается в конец чанка и может продолжиться в следующем: он становится pending
+      // и будет просканирован заново вместе со следующим чанком, начиная со своей позиции
+      pending_token_value_ = current_input.substr(iter - scanned.first.getValue().size());
+      line_ = scanned.first.getLine();
+      column_ = scanned.first.getColumn();
       break;
     }
 
-    tokens.push_back(current_token);
-    last_added_token_in_chunk = current_token;
-    last_added_token_separated = current_token_separated;
-    token_was_added_in_loop = true;
-
-    if (current_token.getType() == TokenType::ERROR) {
-      break;
-    }
-
-  } while (current_token.getType() != TokenType::ERROR && 
-           current_token.getType() != TokenType::_EOF &&
-           iter < current_input.size());
-
-  // После цикла проверяем, не нужно ли последний добавленный токен сделать pending
-  if (token_was_added_in_loop && iter >= current_input.size() && 
-      last_added_token_in_chunk.getType() != TokenType::ERROR &&
-      last_added_token_in_chunk.getType() != TokenType::_EOF &&
-      last_added_token_in_chunk.getType() != TokenType::ERROR &&
-      !last_added_token_separated) {
-    pending_token_value_ = last_added_token_in_chunk.getValue();
-    // Убираем последний токен из списка, так как он теперь pending
-    // Но только если он действительно там последний (на случай если токен был, но не добавился из-за ошибки или EOF)
-    if (!tokens.empty() && tokens.back().getValue() == last_added_token_in_chunk.getValue() && tokens.back().getType() == last_added_token_in_chunk.getType()) {
-      tokens.pop_back(); 
-    }
+    tokens.push_back(intern_(scanned.first));
+    if (scanned.first.getType() == TokenType::ERROR) break;
   }
+  return tokens;
+}
 
+std::vector<Token> Lexer::tokenizeAll(std::string_view source) {
+  std::vector<Token> tokens;
+  tokens.reserve(source.size() / 4 + 1); // rough token density of typical scripts
+  scan_all_(source, tokens);
+  tokens.push_back(Token(TokenType::_EOF, "EOF", line_, column_));
   return tokens;
 }
 
-// Ensure Lexer::eof() starts on a new line after tokenize's closing brace
+void Lexer::scan_all_(std::string_view source, std::vector<Token>& tokens) {
+  size_t iter = 0;
+  while (iter < source.size()) {
+    // The whole input is available, so nothing is ever pending: every token is final
+    std::pair<Token, bool> scanned = scan_next_(source, iter);
+    if (scanned.first.getType() == TokenType::PENDING) break; // only trailing whitespace was left
+    tokens.push_back(intern_(scanned.first));
+  }
+}
 
 std::vector<Token> Lexer::eof() {
   std::vector<Token> final_tokens;
@@ -223,48 +309,19 @@ std::vector<Token> Lexer::eof() {
     size_t temp_iter = 0;
     std::pair<Token, bool> scanned = scan_next_(pending_token_value_, temp_iter);
 
-    // Если pending_token_value_ был полностью разобран как один токен
-    if (scanned.first.getType() != TokenType::ERROR && 
-      scanned.first.getType() != TokenType::PENDING && 
-      temp_iter == pending_token_value_.size()) {
-      final_tokens.push_back(scanned.first);
-    } 
-    // Если scan_next_ вернул PENDING, но что-то распарсил (например, это незавершенный идентификатор)
-    // или если он вернул валидный токен, но не всю строку pending_token_value_
-    else if (scanned.first.getType() != TokenType::ERROR && !scanned.first.getValue().empty()) {
-      // Если scan_next_ вернул PENDING с непустым значением, которое не является стандартным сообщением PENDING.
-      // Либо если он вернул обычный токен, но обработал не всю строку pending.
-      // В таких случаях, предполагаем, что это идентификатор или число, если возможно.
-      // Эта логика может потребовать уточнений.
-      if (scanned.first.getType() == TokenType::PENDING) {
-        if (scanned.first.getValue() != "PENDING_EOF_REACHED" && 
-            scanned.first.getValue() != "PENDING_AFTER_WHITESPACE" && 
-            !scanned.first.getValue().empty()) {
-          // Пытаемся распознать как константу или идентификатор
-          std::string val_to_check = scanned.first.getValue();
-          size_t check_iter = 0; // iter для scan_const_or_id
-          // Передаем false для initial_char_consumed, так как scan_next_ вернул PENDING
-          // и мы передаем ему полный остаток value.
-          std::pair<Token, bool> const_id_scan = scan_const_or_id_(val_to_check, check_iter, val_to_check, false);
-          if(const_id_scan.first.getType() != TokenType::ERROR && check_iter == val_to_check.size()) {
-            final_tokens.push_back(const_id_scan.first);
-          } else {
-            final_tokens.push_back(Token(TokenType::ERROR, "Unfinished pending at EOF: " + pending_token_value_));
-          }
-        } else if (!pending_token_value_.empty()) { // scan_next_ вернул стандартный PENDING, но строка была
-          final_tokens.push_back(Token(TokenType::ERROR, "Unprocessed pending at EOF: " + pending_token_value_));
-        }
-      } else { // scan_next_ вернул валидный токен, но не всю строку pending_token_value_
-        final_tokens.push_back(scanned.first); // Добавляем то, что удалось распознать
-        if (temp_iter < pending_token_value_.size()) { // Если что-то осталось
-          final_tokens.push_back(Token(TokenType::ERROR, "Extra chars after pending at EOF: " + pending_token_value_.substr(temp_iter)));
-        }
+    if (scanned.first.getType() != TokenType::PENDING) {
+      // pending_token_value_ разобран как токен (ERROR токены сохраняют свою диагностику)
+      final_tokens.push_back(intern_(scanned.first));
+      if (temp_iter < pending_token_value_.size()) { // Если что-то осталось
+        std::string_view message = source_.append("Extra chars after pending at EOF: ", pending_token_value_.substr(temp_iter));
+        final_tokens.push_back(Token(TokenType::ERROR, message, line_, column_));
       }
-    } else if (!pending_token_value_.empty()) { // scan_next_ вернул ERROR или PENDING (без данных)
-      final_tokens.push_back(Token(TokenType::ERROR, "Unable to process pending at EOF: " + pending_token_value_));
+    } else { // scan_next_ вернул PENDING
+      std::string_view message = source_.append("Unable to process pending at EOF: ", pending_token_value_);
+      final_tokens.push_back(Token(TokenType::ERROR, message, line_, column_));
     }
   }
-  pending_token_value_.clear();
-  final_tokens.push_back(Token(TokenType::_EOF, "EOF"));
+  pending_token_value_ = {};
+  final_tokens.push_back(Token(TokenType::_EOF, "EOF", line_, column_));
   return final_tokens;
-}
\ No newline at end of file
+}
@@ -0,0 +1,142 @@
+#include "lexer.hpp"
+#include <algorithm>
+#include <cstring>
+
+// Parallel variant of tokenizeAll.
+//
+// The input is cut right after a '\n' into segments of similar size, and every segment is
+// lexed by its own Lexer with its own SymbolTable, as if it were a separate file starting at
+// line 1. A cut is only valid if the '\n' is not inside a token. Comments stop before '\n',
+// so only strings (which may span lines) can contain one; such a segment ends with a string
+// that runs into its end, and is then rescanned together with the next segment.
+// Afterwards line numbers are shifted by the number of lines before each segment, local
+// symbols are mapped to the lexer's table, and the segments are joined in order.
+
+namespace {
+
+constexpr size_t kSegmentsPerThread = 4;  // a few segments per thread even out the load
+
+struct Segment {
+  std::string_view text;
+  std::vector<Token> tokens;
+  std::unique_ptr<SymbolTable> symbols;
+  std::vector<Symbol> remap;    // local symbol -> symbol in the lexer's table
+  uint32_t lines = 1;           // line after the last character, relative to the segment
+  uint32_t end_column = 1;      // column after the last character
+  uint32_t first_line = 1;      // absolute line of the first character
+  bool merged = false;          // text was rescanned as part of an earlier segment
+};
+
+std::vector<std::string_view> split_at_lines(std::string_view source, size_t parts) {
+  std::vector<std::string_view> pieces;
+  const char* begin = source.data();
+  const char* end = begin + source.size();
+  const char* from = begin;
+  for (size_t i = 1; i < parts; i++) {
+    const char* target = begin + source.size() / parts * i;
+    if (target < from) continue;
+    const void* newline = std::memchr(target, '\n', static_cast<size_t>(end - target));
+    if (newline == nullptr) break;
+    const char* cut = static_cast<const char*>(newline) + 1;
+    if (cut >= end) break;
+    pieces.emplace_back(from, static_cast<size_t>(cut - from));
+    from = cut;
+  }
+  pieces.emplace_back(from, static_cast<size_t>(end - from));
+  return pieces;
+}
+
+// A string without its closing quote that stops at the end of the segment continues in the next one
+bool runs_into_next(const Token& token, const char* segment_end) {
+  if (token.getType() != TokenType::CONSTANT_STRING) return false;
+  std::string_view text = token.getValue();
+  if (text.data() + text.size() != segment_end) return false;
+  return text.size() < 2 || text.back() != text.front();
+}
+
+} // namespace
+
+std::vector<Token> Lexer::tokenizeParallel(std::string_view source, ThreadPool& pool, size_t minSegment) {
+  size_t parts = std::min(pool.size() * kSegmentsPerThread, source.size() / std::max<size_t>(minSegment, 1));
+  if (pool.size() == 1 || parts < 2) return tokenizeAll(source);
+
+  std::vector<std::string_view> pieces = split_at_lines(source, parts);
+  std::vector<Segment> segments(pieces.size());
+
+  pool.parallelFor(segments.size(), [&](size_t i) {
+    Segment& seg = segments[i];
+    seg.text = pieces[i];
+    seg.symbols = std::make_unique<SymbolTable>();
+    seg.tokens.reserve(seg.text.size() / 4 + 1);
+
+    Lexer lexer;
+    lexer.setSymbolTable(*seg.symbols);
+    lexer.scan_all_(seg.text, seg.tokens);
+    seg.lines = lexer.line_;
+    seg.end_column = lexer.column_;
+  });
+
+  // Rescan strings cut by a segment boundary, continuing from the string's own position
+  for (size_t i = 0; i < segments.size(); i++) {
+    Segment& seg = segments[i];
+    if (seg.merged) continue;
+    for (size_t j = i + 1; j < segments.size() && !seg.tokens.empty(); j++) {
+      const char* seg_end = seg.text.data() + seg.text.size();
+      if (!runs_into_next(seg.tokens.back(), seg_end)) break;
+
+      Token open = seg.tokens.back();
+      seg.tokens.pop_back();
+      const char* to = segments[j].text.data() + segments[j].text.size();
+
+      Lexer lexer;
+      lexer.setSymbolTable(*seg.symbols);
+      lexer.line_ = open.line_;
+      lexer.column_ = open.column_;
+      lexer.scan_all_(std::string_view(open.text_, static_cast<size_t>(to - open.text_)), seg.tokens);
+      seg.lines = lexer.line_;
+      seg.end_column = lexer.column_;
+      seg.text = std::string_view(seg.text.data(), static_cast<size_t>(to - seg.text.data()));
+
+      segments[j].merged = true;
+      segments[j].tokens = {};
+    }
+  }
+
+  // Line offsets (prefix sum) and local symbols -> this lexer's table
+  uint32_t line = line_;
+  uint32_t column = column_;
+  size_t total = 0;
+  for (Segment& seg : segments) {
+    if (seg.merged) continue;
+    seg.first_line = line;
+    line += seg.lines - 1;
+    column = seg.end_column;
+    total += seg.tokens.size();
+
+    seg.remap.resize(seg.symbols->size());
+    for (Symbol s = 0; s < seg.remap.size(); s++) {
+      seg.remap[s] = s <= static_cast<Symbol>(TokenType::KEYWORD_NOT) ? s : symbols_->intern(seg.symbols->name(s));
+    }
+  }
+
+  pool.parallelFor(segments.size(), [&](size_t i) {
+    Segment& seg = segments[i];
+    if (seg.merged) return;
+    uint32_t offset = seg.first_line - 1;
+    for (Token& token : seg.tokens) {
+      token.line_ += offset;
+      if (token.type_ == TokenType::IDENTIFIER) token.symbol_ = seg.remap[token.symbol_];
+    }
+  });
+
+  std::vector<Token> tokens;
+  tokens.reserve(total + 1);
+  for (Segment& seg : segments) {
+    tokens.insert(tokens.end(), seg.tokens.begin(), seg.tokens.end());
+    seg.tokens = {};
+  }
+  line_ = line;
+  column_ = column;
+  tokens.push_back(Token(TokenType::_EOF, "EOF", line_, column_));
+  return tokens;
+}
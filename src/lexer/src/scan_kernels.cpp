@@ -0,0 +1,256 @@
+#include "scan_kernels.hpp"
+#include "lexer_dfa.hpp"
+#include <cstring>
+
+#if (defined(__x86_64__) || defined(_M_X64) || defined(__i386__)) && (defined(__SSE2__) || defined(_M_X64))
+#define MATHSOL_X86_SIMD 1
+#include <immintrin.h>
+#endif
+
+#if defined(MATHSOL_X86_SIMD) && (defined(__GNUC__) || defined(__clang__))
+#define MATHSOL_HAS_AVX2 1
+#define MATHSOL_TARGET_AVX2 __attribute__((target("avx2")))
+#endif
+
+namespace {
+
+// --- Scalar ---
+
+const char* scalar_skip_blanks(const char* p, const char* end) {
+  while (p < end && is_blank(*p)) p++;
+  return p;
+}
+
+const char* scalar_skip_ident_tail(const char* p, const char* end) {
+  while (p < end && is_ident_tail(*p)) p++;
+  return p;
+}
+
+const char* scalar_skip_digits(const char* p, const char* end) {
+  while (p < end && *p >= '0' && *p <= '9') p++;
+  return p;
+}
+
+const char* scalar_find_char(const char* p, const char* end, char c) {
+  const void* found = std::memchr(p, c, static_cast<size_t>(end - p));
+  return found ? static_cast<const char*>(found) : end;
+}
+
+#ifdef MATHSOL_X86_SIMD
+
+// Most runs are a few bytes long (names, small numbers, single blanks), and setting up the
+// vector compare would cost more than it saves. The vector kernels therefore check the first
+// kPrologue bytes one by one and switch to 16/32-byte steps only for longer runs.
+constexpr int kPrologue = 8;
+
+template <typename Pred>
+inline bool scalar_prologue(const char*& p, const char* end, Pred in_run) {
+  for (int i = 0; i < kPrologue; i++, p++) {
+    if (p >= end || !in_run(*p)) return true;
+  }
+  return false;
+}
+
+inline bool is_digit(char c) { return c >= '0' && c <= '9'; }
+
+inline int first_bit(unsigned mask) {
+#if defined(__GNUC__) || defined(__clang__)
+  return __builtin_ctz(mask);
+#else
+  unsigned long index;
+  _BitScanForward(&index, mask);
+  return static_cast<int>(index);
+#endif
+}
+
+// --- SSE2 ---
+// Byte range test without unsigned compares: shift [lo, hi] down to [-128, -128 + hi - lo]
+// and do one signed compare.
+
+inline __m128i sse2_in_range(__m128i v, char lo, char hi) {
+  __m128i shifted = _mm_sub_epi8(v, _mm_set1_epi8(static_cast<char>(lo + 128)));
+  return _mm_cmplt_epi8(shifted, _mm_set1_epi8(static_cast<char>(hi - lo + 1 - 128)));
+}
+
+inline __m128i sse2_blank_mask(__m128i v) {
+  return _mm_or_si128(_mm_cmpeq_epi8(v, _mm_set1_epi8(' ')), _mm_cmpeq_epi8(v, _mm_set1_epi8('\t')));
+}
+
+inline __m128i sse2_ident_mask(__m128i v) {
+  __m128i letter = sse2_in_range(_mm_or_si128(v, _mm_set1_epi8(0x20)), 'a', 'z');
+  __m128i digit = sse2_in_range(v, '0', '9');
+  __m128i extra = _mm_or_si128(_mm_cmpeq_epi8(v, _mm_set1_epi8('_')), _mm_cmpeq_epi8(v, _mm_set1_epi8('-')));
+  return _mm_or_si128(_mm_or_si128(letter, digit), extra);
+}
+
+// Skips 16-byte blocks while every byte matches, then points at the first mismatch
+template <typename MaskFn>
+inline const char* sse2_skip(const char* p, const char* end, MaskFn mask_of) {
+  while (end - p >= 16) {
+    __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+    unsigned miss = ~static_cast<unsigned>(_mm_movemask_epi8(mask_of(v))) & 0xFFFFu;
+    if (miss) return p + first_bit(miss);
+    p += 16;
+  }
+  return p;
+}
+
+const char* sse2_skip_blanks(const char* p, const char* end) {
+  if (scalar_prologue(p, end, is_blank)) return p;
+  return scalar_skip_blanks(sse2_skip(p, end, sse2_blank_mask), end);
+}
+
+const char* sse2_skip_ident_tail(const char* p, const char* end) {
+  if (scalar_prologue(p, end, is_ident_tail)) return p;
+  return scalar_skip_ident_tail(sse2_skip(p, end, sse2_ident_mask), end);
+}
+
+const char* sse2_skip_digits(const char* p, const char* end) {
+  if (scalar_prologue(p, end, is_digit)) return p;
+  return scalar_skip_digits(sse2_skip(p, end, [](__m128i v) { return sse2_in_range(v, '0', '9'); }), end);
+}
+
+#if !defined(__GLIBC__)
+const char* sse2_find_char(const char* p, const char* end, char c) {
+  __m128i needle = _mm_set1_epi8(c);
+  while (end - p >= 16) {
+    __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+    unsigned hit = static_cast<unsigned>(_mm_movemask_epi8(_mm_cmpeq_epi8(v, needle)));
+    if (hit) return p + first_bit(hit);
+    p += 16;
+  }
+  return scalar_find_char(p, end, c);
+}
+#endif
+
+#endif // MATHSOL_X86_SIMD
+
+#ifdef MATHSOL_HAS_AVX2
+
+// --- AVX2 ---
+// Every exit clears the upper halves of the ymm registers (vzeroupper): the rest of the
+// lexer is SSE code, and a dirty upper state makes each of its SSE instructions pay
+// a transition penalty.
+
+MATHSOL_TARGET_AVX2 inline __m256i avx2_in_range(__m256i v, char lo, char hi) {
+  __m256i shifted = _mm256_sub_epi8(v, _mm256_set1_epi8(static_cast<char>(lo + 128)));
+  return _mm256_cmpgt_epi8(_mm256_set1_epi8(static_cast<char>(hi - lo + 1 - 128)), shifted);
+}
+
+MATHSOL_TARGET_AVX2 inline __m256i avx2_blank_mask(__m256i v) {
+  return _mm256_or_si256(_mm256_cmpeq_epi8(v, _mm256_set1_epi8(' ')), _mm256_cmpeq_epi8(v, _mm256_set1_epi8('\t')));
+}
+
+MATHSOL_TARGET_AVX2 inline __m256i avx2_ident_mask(__m256i v) {
+  __m256i letter = avx2_in_range(_mm256_or_si256(v, _mm256_set1_epi8(0x20)), 'a', 'z');
+  __m256i digit = avx2_in_range(v, '0', '9');
+  __m256i extra = _mm256_or_si256(_mm256_cmpeq_epi8(v, _mm256_set1_epi8('_')), _mm256_cmpeq_epi8(v, _mm256_set1_epi8('-')));
+  return _mm256_or_si256(_mm256_or_si256(letter, digit), extra);
+}
+
+MATHSOL_TARGET_AVX2 inline __m256i avx2_digit_mask(__m256i v) {
+  return avx2_in_range(v, '0', '9');
+}
+
+template <__m256i (*MaskFn)(__m256i)>
+MATHSOL_TARGET_AVX2 inline const char* avx2_skip(const char* p, const char* end) {
+  while (end - p >= 32) {
+    __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p));
+    unsigned miss = ~static_cast<unsigned>(_mm256_movemask_epi8(MaskFn(v)));
+    if (miss) return p + first_bit(miss);
+    p += 32;
+  }
+  return p;
+}
+
+MATHSOL_TARGET_AVX2 const char* avx2_skip_blanks(const char* p, const char* end) {
+  if (scalar_prologue(p, end, is_blank)) return p;
+  p = avx2_skip<avx2_blank_mask>(p, end);
+  _mm256_zeroupper();
+  return sse2_skip_blanks(p, end);
+}
+
+MATHSOL_TARGET_AVX2 const char* avx2_skip_ident_tail(const char* p, const char* end) {
+  if (scalar_prologue(p, end, is_ident_tail)) return p;
+  p = avx2_skip<avx2_ident_mask>(p, end);
+  _mm256_zeroupper();
+  return sse2_skip_ident_tail(p, end);
+}
+
+MATHSOL_TARGET_AVX2 const char* avx2_skip_digits(const char* p, const char* end) {
+  if (scalar_prologue(p, end, is_digit)) return p;
+  p = avx2_skip<avx2_digit_mask>(p, end);
+  _mm256_zeroupper();
+  return sse2_skip_digits(p, end);
+}
+
+#if !defined(__GLIBC__)
+MATHSOL_TARGET_AVX2 const char* avx2_find_char(const char* p, const char* end, char c) {
+  __m256i needle = _mm256_set1_epi8(c);
+  while (end - p >= 32) {
+    __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p));
+    unsigned hit = static_cast<unsigned>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(v, needle)));
+    if (hit) {
+      _mm256_zeroupper();
+      return p + first_bit(hit);
+    }
+    p += 32;
+  }
+  _mm256_zeroupper();
+  return sse2_find_char(p, end, c);
+}
+#endif
+
+#endif // MATHSOL_HAS_AVX2
+
+// glibc's memchr is already vectorized (with its own CPU dispatch) and unrolled further
+// than the kernels above, so it is used for the single-byte search where available.
+#if defined(__GLIBC__)
+#define MATHSOL_SSE2_FIND_CHAR scalar_find_char
+#define MATHSOL_AVX2_FIND_CHAR scalar_find_char
+#else
+#define MATHSOL_SSE2_FIND_CHAR sse2_find_char
+#define MATHSOL_AVX2_FIND_CHAR avx2_find_char
+#endif
+
+const ScanKernels kScalar = { SimdLevel::SCALAR, scalar_skip_blanks, scalar_skip_ident_tail, scalar_skip_digits, scalar_find_char };
+#ifdef MATHSOL_X86_SIMD
+const ScanKernels kSse2 = { SimdLevel::SSE2, sse2_skip_blanks, sse2_skip_ident_tail, sse2_skip_digits, MATHSOL_SSE2_FIND_CHAR };
+#endif
+#ifdef MATHSOL_HAS_AVX2
+const ScanKernels kAvx2 = { SimdLevel::AVX2, avx2_skip_blanks, avx2_skip_ident_tail, avx2_skip_digits, MATHSOL_AVX2_FIND_CHAR };
+#endif
+
+bool cpu_has_avx2() {
+#ifdef MATHSOL_HAS_AVX2
+  return __builtin_cpu_supports("avx2");
+#else
+  return false;
+#endif
+}
+
+} // namespace
+
+const ScanKernels& scanKernels(SimdLevel level) {
+#ifdef MATHSOL_HAS_AVX2
+  if (level == SimdLevel::AVX2 && cpu_has_avx2()) return kAvx2;
+#endif
+#ifdef MATHSOL_X86_SIMD
+  if (level != SimdLevel::SCALAR) return kSse2; // SSE2 is part of the x86-64 baseline
+#endif
+  (void)level;
+  return kScalar;
+}
+
+const ScanKernels& scanKernels() {
+  static const ScanKernels& best = scanKernels(SimdLevel::AVX2);
+  return best;
+}
+
+const char* simdLevelName(SimdLevel level) {
+  switch (level) {
+    case SimdLevel::AVX2: return "avx2";
+    case SimdLevel::SSE2: return "sse2";
+    default: return "scalar";
+  }
+}
@@ -0,0 +1,71 @@
+#include "source_file.hpp"
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#define MATHSOL_HAS_MMAP 1
+#endif
+
+MappedFile::~MappedFile() { close(); }
+
+#ifdef MATHSOL_HAS_MMAP
+
+bool MappedFile::open(const std::string& path) {
+  close();
+  int fd = ::open(path.c_str(), O_RDONLY);
+  if (fd < 0) return false;
+
+  struct stat st;
+  if (fstat(fd, &st) != 0 || !S_ISREG(st.st_mode)) {
+    ::close(fd);
+    return false;
+  }
+
+  size_ = static_cast<size_t>(st.st_size);
+  if (size_ == 0) { // mmap rejects empty mappings, an empty view is enough
+    ::close(fd);
+    data_ = "";
+    return true;
+  }
+
+  void* addr = mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, fd, 0);
+  ::close(fd); // the mapping keeps its own reference to the file
+  if (addr == MAP_FAILED) {
+    size_ = 0;
+    return false;
+  }
+  madvise(addr, size_, MADV_SEQUENTIAL); // the lexer reads front to back exactly once
+
+  data_ = static_cast<const char*>(addr);
+  mapped_ = true;
+  return true;
+}
+
+void MappedFile::release(size_t end) {
+  if (!mapped_) return;
+  size_t page = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+  size_t length = (end < size_ ? end : size_) / page * page;
+  if (length) madvise(const_cast<char*>(data_), length, MADV_DONTNEED);
+}
+
+void MappedFile::close() {
+  if (mapped_) munmap(const_cast<char*>(data_), size_);
+  data_ = nullptr;
+  size_ = 0;
+  mapped_ = false;
+}
+
+#else
+
+bool MappedFile::open(const std::string& path) {
+  (void)path;
+  return false;
+}
+
+void MappedFile::release(size_t end) { (void)end; }
+
+void MappedFile::close() {}
+
+#endif
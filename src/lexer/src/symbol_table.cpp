@@ -0,0 +1,69 @@
+#include "symbol_table.hpp"
+#include "token.hpp"
+#include <algorithm>
+#include <cstring>
+
+namespace {
+
+// FNV-1a: spellings are short, so a simple byte loop beats the setup of stronger hashes
+uint64_t hash_spelling(std::string_view s) {
+  uint64_t h = 14695981039346656037ull;
+  for (char c : s) {
+    h ^= static_cast<unsigned char>(c);
+    h *= 1099511628211ull;
+  }
+  return h;
+}
+
+} // namespace
+
+SymbolTable::SymbolTable() {
+  slots_.assign(256, 0);
+  // Keywords get the symbols equal to their TokenType values (they are declared first)
+  for (int i = 0; i <= static_cast<int>(TokenType::KEYWORD_NOT); i++) intern(valueTT[i]);
+}
+
+SymbolTable& SymbolTable::global() {
+  static SymbolTable table;
+  return table;
+}
+
+Symbol SymbolTable::intern(std::string_view spelling) {
+  uint64_t hash = hash_spelling(spelling);
+  size_t mask = slots_.size() - 1;
+  for (size_t i = hash & mask;; i = (i + 1) & mask) {
+    uint32_t slot = slots_[i];
+    if (slot == 0) {
+      Symbol symbol = static_cast<Symbol>(names_.size());
+      names_.push_back(store_(spelling));
+      hashes_.push_back(hash);
+      slots_[i] = symbol + 1;
+      if (names_.size() * 4 > slots_.size() * 3) grow_(); // keep the load factor under 3/4
+      return symbol;
+    }
+    if (hashes_[slot - 1] == hash && names_[slot - 1] == spelling) return slot - 1;
+  }
+}
+
+// Copies the spelling into block storage that never moves, so names stay valid
+std::string_view SymbolTable::store_(std::string_view spelling) {
+  if (storage_used_ + spelling.size() > kStorageBlock) {
+    storage_.push_back(std::make_unique<char[]>(std::max(kStorageBlock, spelling.size())));
+    storage_used_ = 0;
+  }
+  char* dest = storage_.back().get() + storage_used_;
+  std::memcpy(dest, spelling.data(), spelling.size());
+  storage_used_ += spelling.size();
+  return { dest, spelling.size() };
+}
+
+void SymbolTable::grow_() {
+  std::vector<uint32_t> slots(slots_.size() * 2, 0);
+  size_t mask = slots.size() - 1;
+  for (Symbol symbol = 0; symbol < names_.size(); symbol++) {
+    size_t i = hashes_[symbol] & mask;
+    while (slots[i] != 0) i = (i + 1) & mask;
+    slots[i] = symbol + 1;
+  }
+  slots_ = std::move(slots);
+}
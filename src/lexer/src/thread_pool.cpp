@@ -0,0 +1,68 @@
+#include "thread_pool.hpp"
+
+ThreadPool::ThreadPool(size_t threads) {
+  for (size_t i = 1; i < threads; i++) workers_.emplace_back(&ThreadPool::work_, this);
+}
+
+ThreadPool::~ThreadPool() {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    stopping_ = true;
+  }
+  wake_.notify_all();
+  for (std::thread& worker : workers_) worker.join();
+}
+
+size_t ThreadPool::defaultThreads() {
+  unsigned n = std::thread::hardware_concurrency();
+  return n == 0 ? 1 : n;
+}
+
+void ThreadPool::parallelFor(size_t count, const std::function<void(size_t)>& fn) {
+  if (count == 0) return;
+  if (workers_.empty() || count == 1) {
+    for (size_t i = 0; i < count; i++) fn(i);
+    return;
+  }
+
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    job_ = &fn;
+    count_ = count;
+    next_index_.store(0, std::memory_order_relaxed);
+    busy_ = workers_.size();
+    generation_++;
+  }
+  wake_.notify_all();
+
+  run_items_(fn, count);
+
+  std::unique_lock<std::mutex> lock(mutex_);
+  finished_.wait(lock, [this] { return busy_ == 0; });
+  job_ = nullptr;
+}
+
+void ThreadPool::run_items_(const std::function<void(size_t)>& fn, size_t count) {
+  for (size_t i = next_index_.fetch_add(1); i < count; i = next_index_.fetch_add(1)) fn(i);
+}
+
+void ThreadPool::work_() {
+  size_t seen = 0;
+  for (;;) {
+    const std::function<void(size_t)>* job;
+    size_t count;
+    {
+      std::unique_lock<std::mutex> lock(mutex_);
+      wake_.wait(lock, [&] { return stopping_ || generation_ != seen; });
+      if (stopping_) return;
+      seen = generation_;
+      job = job_;
+      count = count_;
+    }
+
+    run_items_(*job, count);
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (--busy_ == 0) finished_.notify_one();
+  }
+}
@@ -1,4 +1,7 @@
 #include "token.hpp"
 
-// Пустая реализация, т.к. класс Token не требует дополнительной реализации
-std::ostream& operator << (std::ostream& outs, const Token& t) { return outs << "[" << nameTT[static_cast<int>(t.getType())] << ": " << t.getValue() << "]"; }
+std::ostream& operator << (std::ostream& outs, const Token& t) {
+  outs << "[" << nameTT[static_cast<int>(t.getType())] << ": " << t.getValue();
+  if (t.getError() != LexError::NONE) outs << " (" << lexErrorMessage[static_cast<int>(t.getError())] << ")";
+  return outs << "]";
+}
@@ -3,6 +3,18 @@
 // Global flags for command-line options
 bool showTokens = false;    // Enable token output
 bool showParseTree = false; // Enable parse tree output
+size_t lexJobs = 1;         // Threads used to tokenize files [-j, --jobs]
+bool foldConstants = true;  // Constant folding and simplification [--no-fold]
+bool shareSubexpressions = true; // Equal subexpressions of a statement evaluated once [--no-cse]
+bool inferTypes = true;     // Unchecked number arithmetic where types are proven [--no-infer]
+
+// Execution engine [--engine=tree|flat|vm]
+enum class Engine { TREE, FLAT, VM };
+Engine engine = Engine::TREE; // The tree walker is the reference implementation
+bool useJit = false;          // Hot numeric statements run as native code [--jit], implies --engine=vm
+bool emitC = false;           // Print the script translated to C instead of running it [--emit-c]
+bool runNative = false;       // Run the script as a shared object built from that C [--aot]
+bool useCache = true;         // VM runs of files keep their bytecode in __mathsol_cache__ [--no-cache]
 
 // Help information [-h, --help]
 void printHelp() {
@@ -14,7 +26,17 @@ void printHelp() {
   std::cout << "  -h, --help     : display this help information\n";
   std::cout << "  -V, --version  : display version information\n";
   std::cout << "  -t, --tokens   : show tokens\n";
-  std::cout << "  -T, --tree     : show parse tree\n\n";
+  std::cout << "  -T, --tree     : show parse tree\n";
+  std::cout << "  -j, --jobs[=N] : tokenize files on N threads (default: all cores)\n";
+  std::cout << "  --engine=NAME  : run with the tree walker (tree, default), the flat AST (flat) or the bytecode VM (vm)\n";
+  std::cout << "                   (the VM keeps the bytecode of a script file in __mathsol_cache__ next to it)\n";
+  std::cout << "  --jit          : run the VM and compile hot numeric statements to native code (x86-64)\n";
+  std::cout << "  --emit-c       : translate the script file to C and print it instead of running it\n";
+  std::cout << "  --aot          : build the script file into <file>.so with $CC (cc) and run that\n";
+  std::cout << "  --no-cache     : run the script file on the VM without __mathsol_cache__\n";
+  std::cout << "  --no-fold      : run the tree as parsed, without constant folding\n";
+  std::cout << "  --no-cse       : build and evaluate every repeated subexpression separately\n";
+  std::cout << "  --no-infer     : type-check every operation at run time, without type inference\n\n";
   std::cout << "Examples:\n";
   std::cout << "  mathsol                : Runs the interpreter interactively\n";
   std::cout << "  mathsol script.msol    : Executes code in script.msol file\n";
@@ -26,9 +48,91 @@ void printVersion() {
   std::cout << "MathSol version " << VERSION << "\n";
 }
 
+// Print parser diagnostics (lexer errors reach the parser as ERROR tokens)
+void reportParseErrors(const Parser& parser) {
+  for (const std::string& message : parser.errors()) {
+    std::cerr << "Error: " << message << "\n";
+  }
+}
+
+// State shared by all statements of one run (a file, a command or the whole REPL session)
+struct Session {
+  ConstantFolder folder;
+  Resolver resolver;
+  TypeInference types; // Variable types carried from statement to statement
+  Environment env;
+  FlatAst flat; // --engine=flat: the current statement, lowered
+  FlatEvaluator flatEvaluator{env};
+  Compiler compiler; // --engine=vm
+  Chunk chunk;
+  VirtualMachine vm{env};
+  Jit jit{env}; // --jit
+  CompiledScriptWriter* cache = nullptr; // Receives the bytecode of every statement the VM runs
+};
+
+// Run one statement; values of expression statements are printed, assignments are silent
+void executeStatement(const IStatement& statement, Session& session) {
+  if (statement.kind() != StatementKind::EXPRESSION) {
+    statement.execute(session.env);
+    return;
+  }
+  const IExpression& expression = *static_cast<const ExpressionStatement&>(statement).expression_;
+  Value value;
+  if (engine == Engine::VM) {
+    session.compiler.compile(statement, session.chunk);
+    if (session.cache) session.cache->add(session.chunk, expression.kind() != ExpressionKind::ASSIGNMENT);
+    // The JIT declines statements that are not hot yet or not purely numeric
+    if (!useJit || !session.jit.run(session.chunk, value)) value = session.vm.run(session.chunk);
+  } else if (engine == Engine::FLAT) {
+    value = session.flatEvaluator.evaluateStatement(session.flat, 0);
+  } else {
+    value = expression.evaluate(session.env);
+  }
+  if (expression.kind() != ExpressionKind::ASSIGNMENT) {
+    std::cout << formatValue(value) << "\n";
+  }
+}
+
+// Parse and run statements one at a time. Each statement is folded, resolved, typed, executed and its
+// AST freed before the next one is parsed, so memory is bounded by the largest statement.
+// --tree shows the tree after folding, i.e. the one that is executed (with --engine=flat, printed from
+// the flat AST). Stops at the first parse or runtime error and returns false.
+bool runStatements(Parser& parser, AstArena& arena, Session& session) {
+  AstPrinter printer(std::cout);
+  FlatAstPrinter flatPrinter;
+  bool ok = true;
+  parser.setShareSubexpressions(shareSubexpressions);
+  if (showParseTree) std::cout << "--- AST Tree ---\n";
+  while (IStatement* statement = parser.parseNext()) {
+    if (foldConstants) session.folder.fold(*statement, arena);
+    if (showParseTree && engine != Engine::FLAT) printer.print(*statement);
+    session.resolver.resolve(*statement);
+    if (inferTypes) session.types.infer(*statement);
+    if (engine == Engine::FLAT && statement->kind() == StatementKind::EXPRESSION) {
+      session.flat.clear();
+      lowerToFlat(*statement, session.flat);
+      if (showParseTree) std::cout << flatPrinter.print(session.flat);
+    }
+    try {
+      executeStatement(*statement, session);
+    } catch (const std::exception& e) {
+      session.types.reset(); // Some assignments of the statement did not happen
+      std::cerr << e.what() << "\n";
+      ok = false;
+      break;
+    }
+    arena.reset();
+  }
+  reportParseErrors(parser);
+  if (showParseTree) std::cout << "------------------\n";
+  return ok && !parser.hasError();
+}
+
 // Interactive mode [default]
 void runInteractiveMode() {
   Lexer lex = Lexer();
+  AstArena arena; // Дерево каждой инструкции освобождается целиком перед следующей
+  Session session; // Variables live for the whole session
 
   std::cout << "mathsol> ";
   std::string input;
@@ -42,35 +146,9 @@ void runInteractiveMode() {
       std::cout << "\n";
     }
     
-    // Парсинг и вывод дерева (если нужно)
     if (!tokens.empty() && !(tokens.size() == 1 && tokens[0].getType() == TokenType::_EOF)) {
-      Parser parser(tokens); // Создаем парсер с полученными токенами
-      std::vector<std::unique_ptr<IStatement>> statements = parser.parse();
-
-      // TODO: Добавить проверку parser.hasError() когда метод будет доступен
-      // if (parser.hasError()) {
-      //     std::cerr << "Parsing errors occurred.\n";
-      // }
-
-      if (showParseTree /*&& !parser.hasError()*/) {
-        if (!statements.empty() || (tokens.size() > 1 || (tokens.size()==1 && tokens[0].getType() != TokenType::_EOF) )) {
-          AstPrinter printer;
-          std::cout << "--- AST Tree ---\n";
-          std::cout << printer.print(statements); // Печатаем дерево
-          std::cout << "------------------\n";
-        } /*else if (parser.hasError())*/ else if (false) { // Временно, пока нет parser.hasError()
-          std::cout << "Parsing resulted in errors, no AST to show.\n";
-        } else {
-          std::cout << "Input resulted in no statements to display in AST.\n";
-        }
-      }
-
-      // TODO: Здесь будет вычисление выражений из statements
-      // for (const auto& stmt : statements) {
-      //     if (stmt /*&& !parser.hasError()*/) {
-      //         // stmt->execute(env); // или evaluate и printValue
-      //     }
-      // }
+      Parser parser(tokens, arena);
+      runStatements(parser, arena, session);
     }
     std::cout << "mathsol> ";
   }
@@ -81,11 +159,10 @@ void runInteractiveMode() {
     for (Token t : final_tokens) std::cout << t << " ";
     std::cout << "\n";
   }
-  // TODO: If a parser were here, it would also need to process these final_tokens.
 }
 
 // Execute expression [-c, --command]
-void runCommand(const std::string& command) {
+bool runCommand(const std::string& command) {
   Lexer lex = Lexer();
   std::vector<Token> tokens = lex.tokenize(command);
   
@@ -99,45 +176,19 @@ void runCommand(const std::string& command) {
     std::cout << "\n";
   }
   
-  // Парсинг и вывод дерева (если нужно)
-  if (!tokens.empty() && !(tokens.size() == 1 && tokens[0].getType() == TokenType::_EOF)) {
-    Parser parser(tokens);
-    std::vector<std::unique_ptr<IStatement>> statements = parser.parse();
-
-    // TODO: Добавить проверку parser.hasError()
-    if (showParseTree /*&& !parser.hasError()*/) {
-      if (!statements.empty() || (tokens.size() > 1 || (tokens.size()==1 && tokens[0].getType() != TokenType::_EOF) )) {
-        AstPrinter printer;
-        std::cout << "--- AST Tree ---\n";
-        std::cout << printer.print(statements);
-        std::cout << "------------------\n";
-      } /*else if (parser.hasError())*/ else if (false) { // Временно, пока нет parser.hasError()
-        std::cout << "Parsing resulted in errors, no AST to show.\n";
-      } else {
-        std::cout << "Input resulted in no statements to display in AST.\n";
-      }
-    }
-
-    // TODO: Здесь будет вычисление выражений из statements
-    // for (const auto& stmt : statements) { ... }
-  }
+  AstArena arena;
+  Session session;
+  Parser parser(tokens, arena);
+  return runStatements(parser, arena, session);
 }
 
-// Execute code from file [filepath]
-void runFile(const std::string& fileName) {
-  std::ifstream file(fileName);
-  if (!file.is_open()) {
-    std::cerr << "Error: cant open file " << fileName << "\n";
-    return;
-  }
-  
-  Lexer lex = Lexer();
-  
+// Tokenize a stream chunk by chunk (pipes, stdin and files that cannot be mapped)
+std::vector<Token> tokenizeStream(Lexer& lex, std::ifstream& file) {
   std::vector<Token> allTokens;
   allTokens.reserve(256); // Initial capacity
   
   // Buffer for reading chunks
-  char buffer[CHUNK_BUFFER_SIZE];
+  static char buffer[CHUNK_BUFFER_SIZE];
   
   // Process file in chunks for tokenisation
   while (!file.eof()) {
@@ -162,58 +213,174 @@ void runFile(const std::string& fileName) {
   // Get final EOF token
   std::vector<Token> eof_tokens = lex.eof();
   allTokens.insert(allTokens.end(), eof_tokens.begin(), eof_tokens.end());
-  
-  file.close();
-  
-  // Show tokens if requested
-  if (showTokens) {
-    for (const Token& t : allTokens) std::cout << t << " ";
-    std::cout << "\n";
-  }
-  
-  // Debug: Check allTokens before parsing block
-  std::cout << "DEBUG runFile: Before parsing block. allTokens.size() = " << allTokens.size() << std::endl;
-  if (!allTokens.empty()) {
-    std::cout << "DEBUG runFile: Last token type: " << allTokens.back() << std::endl;
-  }
+  return allTokens;
+}
 
-  // Parse all tokens once they're collected (when parser is ready)
-  if (!allTokens.empty() && !(allTokens.size() == 1 && allTokens[0].getType() == TokenType::_EOF)) {
-    Parser parser(allTokens);
-    std::vector<std::unique_ptr<IStatement>> statements;
+// Run compiled statements on the VM, printing like executeStatement; stops at the first runtime error
+bool runCompiledScript(CompiledScript& script) {
+  Session session;
+  bool print = false;
+  while (script.next(session.chunk, print)) {
+    Value value;
     try {
-        std::cout << "Attempting to parse tokens...\n"; // Отладочный вывод
-        statements = parser.parse();
-        std::cout << "Parser returned " << statements.size() << " statements\n";
+      if (!useJit || !session.jit.run(session.chunk, value)) value = session.vm.run(session.chunk);
     } catch (const std::exception& e) {
-        std::cerr << "Exception caught during parsing in runFile: " << e.what() << '\n';
-        // Можно добавить return или обработку, чтобы не продолжать с пустыми statements
-        return; // Выходим из runFile при ошибке парсинга
-    } catch (...) {
-        std::cerr << "Unknown exception caught during parsing in runFile.\n";
-        return; // Выходим из runFile при неизвестной ошибке
+      std::cerr << e.what() << "\n";
+      return false;
     }
+    if (print) std::cout << formatValue(value) << "\n";
+  }
+  if (script.damaged()) {
+    std::cerr << "Error: the cached bytecode of the script changed while it ran\n";
+    return false;
+  }
+  return true;
+}
+
+// Parse and run a file, streaming it through the lexer unless the tokens are needed up front
+bool runSourceFile(const std::string& fileName, Session& session) {
+  AstArena arena;
 
-    // TODO: Добавить проверку parser.hasError()
-    if (showParseTree /*&& !parser.hasError()*/) {
-      if (!statements.empty() || (allTokens.size() > 1 || (allTokens.size()==1 && allTokens[0].getType() != TokenType::_EOF) )) {
-        AstPrinter printer;
-        std::cout << "--- AST Tree ---\n";
-        std::cout << printer.print(statements);
-        std::cout << "------------------\n";
-      } /*else if (parser.hasError())*/ else if (false) { // Временно, пока нет parser.hasError()
-        std::cout << "Parsing resulted in errors, no AST to show.\n";
+  // Printing every token or lexing on several threads needs the whole token list up front
+  if (showTokens || lexJobs > 1) {
+    Lexer lex = Lexer();
+    std::vector<Token> allTokens;
+
+    // Regular files are mapped and scanned in place; the mapping must outlive the tokens
+    MappedFile mapped;
+    if (mapped.open(fileName)) {
+      if (lexJobs > 1) {
+        ThreadPool pool(lexJobs);
+        allTokens = lex.tokenizeParallel(mapped.view(), pool);
       } else {
-        std::cout << "File content resulted in no statements to display in AST.\n";
+        allTokens = lex.tokenizeAll(mapped.view());
+      }
+    } else {
+      std::ifstream file(fileName, std::ios::binary);
+      if (!file.is_open()) {
+        std::cerr << "Error: cant open file " << fileName << "\n";
+        return false;
       }
+      allTokens = tokenizeStream(lex, file);
+    }
+
+    if (showTokens) {
+      for (const Token& t : allTokens) std::cout << t << " ";
+      std::cout << "\n";
+    }
+
+    Parser parser(allTokens, arena);
+    return runStatements(parser, arena, session);
+  }
+
+  // Streaming: the parser pulls tokens from the lexer, which reads the file block by block
+  std::ifstream file(fileName, std::ios::binary);
+  if (!file.is_open()) {
+    std::cerr << "Error: cant open file " << fileName << "\n";
+    return false;
+  }
+  StreamReader reader(file);
+  Lexer lex(reader);
+  Parser parser(lex, arena);
+  return runStatements(parser, arena, session);
+}
+
+// Execute code from file [filepath]. VM runs go through __mathsol_cache__ next to the file: its entry is
+// the bytecode of every statement, keyed by a hash of the source, the version and the compile options.
+// A hit runs the entry without lexing or parsing. A miss runs the file as usual and writes the entry
+// statement by statement as they run, so neither path holds more than one statement in memory.
+bool runFile(const std::string& fileName) {
+  Session session;
+  CompiledScriptWriter cache;
+  uint64_t key = 0;
+  if (useCache && engine == Engine::VM && !showTokens && !showParseTree) {
+    std::ifstream source(fileName, std::ios::binary);
+    if (source.is_open()) {
+      uint32_t options = foldConstants | shareSubexpressions << 1 | inferTypes << 2;
+      key = scriptCacheKey(source, VERSION, options);
+      std::filesystem::path script(fileName);
+      std::filesystem::path cached = script.parent_path() / "__mathsol_cache__" / (script.filename().string() + ".msc");
+
+      CompiledScript compiled;
+      if (compiled.open(cached.string(), key, SymbolTable::global())) return runCompiledScript(compiled);
+      std::error_code error;
+      std::filesystem::create_directories(cached.parent_path(), error);
+      if (!error && cache.open(cached.string())) session.cache = &cache; // Without a cache the file still runs
     }
+  }
+  bool ok = runSourceFile(fileName, session);
+  // Only a script that ran to the end is kept: the next run of a failing one reports its error again
+  if (ok && session.cache) cache.finish(key);
+  return ok;
+}
+
+// Version and options a translated script was built with (mathsol_stamp, see aot.hpp)
+std::string nativeStamp() {
+  std::string stamp = "mathsol ";
+  stamp.append(VERSION);
+  if (!foldConstants) stamp.append(" --no-fold");
+  if (!shareSubexpressions) stamp.append(" --no-cse");
+  if (!inferTypes) stamp.append(" --no-infer");
+  return stamp;
+}
 
-    // TODO: Здесь будет вычисление выражений из statements
-    // for (const auto& stmt : statements) { ... }
-  } else if (showParseTree) {
-    std::cout << "File is empty or resulted in no tokens to parse for AST.\n";
+// Translate a file to C [--emit-c]. The statements go through the same passes as before execution;
+// nothing runs, and a parse error anywhere in the file means no output.
+bool translateFile(const std::string& fileName, std::ostream& out) {
+  std::ifstream file(fileName, std::ios::binary);
+  if (!file.is_open()) {
+    std::cerr << "Error: cant open file " << fileName << "\n";
+    return false;
   }
+  StreamReader reader(file);
+  Lexer lex(reader);
+  AstArena arena;
+  Parser parser(lex, arena);
+  parser.setShareSubexpressions(shareSubexpressions);
+  ConstantFolder folder;
+  Resolver resolver;
+  TypeInference types;
+  CEmitter emitter(fileName, nativeStamp());
+  while (IStatement* statement = parser.parseNext()) {
+    if (foldConstants) folder.fold(*statement, arena);
+    resolver.resolve(*statement);
+    if (inferTypes) types.infer(*statement); // Types after an error never matter: execution stops there
+    emitter.add(*statement);
+    arena.reset();
+  }
+  if (parser.hasError()) {
+    reportParseErrors(parser);
+    return false;
+  }
+  emitter.finish(out);
+  return true;
+}
 
+// Execute a file as native code [--aot]. script.msol.so (next to the script) is rebuilt from
+// script.msol.c when it is missing, older than the script or, by its script.msol.so.stamp, built
+// by another version or with other options; otherwise the run skips lexing and parsing.
+bool runCompiledFile(const std::string& fileName) {
+  std::error_code error;
+  auto scriptTime = std::filesystem::last_write_time(fileName, error);
+  if (error) {
+    std::cerr << "Error: cant open file " << fileName << "\n";
+    return false;
+  }
+  std::string library = fileName + ".so";
+  std::string stamp = nativeStamp();
+  auto libraryTime = std::filesystem::last_write_time(library, error);
+  if (error || libraryTime < scriptTime || !sharedObjectMatches(library, stamp)) {
+    std::string source = fileName + ".c";
+    std::ofstream out(source, std::ios::binary);
+    if (!out.is_open()) {
+      std::cerr << "Error: cant write file " << source << "\n";
+      return false;
+    }
+    bool translated = translateFile(fileName, out);
+    out.close();
+    if (!translated || !buildSharedObject(source, library, stamp)) return false;
+  }
+  return runSharedObject(library, stamp);
 }
 
 // Process short argument sequence [-abc] and return true if the sequence contains option that requires parameters
@@ -237,6 +404,9 @@ bool processShortArgSequence(const std::string& argSequence, char& lastOption) {
       case 'T':
         showParseTree = true;
         break;
+      case 'j':
+        lexJobs = ThreadPool::defaultThreads();
+        break;
       case 'c': // This option requires additional parameter
         requiresParam = true;
         break;
@@ -267,6 +437,51 @@ bool processArgument(const std::string& arg, char& lastOption) {
       } else if (arg == "--tree") {
         showParseTree = true;
         return true;
+      } else if (arg == "--no-fold") {
+        foldConstants = false;
+        return true;
+      } else if (arg == "--no-infer") {
+        inferTypes = false;
+        return true;
+      } else if (arg == "--no-cache") {
+        useCache = false;
+        return true;
+      } else if (arg == "--no-cse") {
+        shareSubexpressions = false;
+        return true;
+      } else if (arg == "--jobs") {
+        lexJobs = ThreadPool::defaultThreads();
+        return true;
+      } else if (arg.rfind("--jobs=", 0) == 0) {
+        char* end = nullptr;
+        unsigned long jobs = std::strtoul(arg.c_str() + 7, &end, 10);
+        if (jobs == 0 || *end != '\0') {
+          std::cerr << "Error: invalid number of jobs in " << arg << "\n";
+          return true;
+        }
+        lexJobs = jobs;
+        return true;
+      } else if (arg.rfind("--engine=", 0) == 0) {
+        std::string name = arg.substr(9);
+        if (name == "tree" || name == "flat") {
+          engine = name == "tree" ? Engine::TREE : Engine::FLAT;
+        } else if (name == "vm") {
+          engine = Engine::VM;
+        } else {
+          std::cerr << "Error: unknown engine " << name << " (expected tree, flat or vm)\n";
+        }
+        return true;
+      } else if (arg == "--jit") {
+        engine = Engine::VM;
+        useJit = Jit::available();
+        if (!useJit) std::cerr << "Warning: JIT is not available in this build, running the VM\n";
+        return true;
+      } else if (arg == "--emit-c") {
+        emitC = true;
+        return true;
+      } else if (arg == "--aot") {
+        runNative = true;
+        return true;
       } else if (arg == "--command") {
         // For option -c additional arguments are required
         lastOption = 'c';
@@ -342,10 +557,12 @@ int main(int argc, char* argv[]) {
       return 1;
     }
     
-    runCommand(command);
+    return runCommand(command) ? 0 : 1;
   } else if (i < argc) {
     // File execution
-    runFile(argv[i]);
+    if (emitC) return translateFile(argv[i], std::cout) ? 0 : 1;
+    if (runNative) return runCompiledFile(argv[i]) ? 0 : 1;
+    return runFile(argv[i]) ? 0 : 1;
   } else {
     // No command or file, run interactive mode
     runInteractiveMode();
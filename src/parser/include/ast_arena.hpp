@@ -0,0 +1,58 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <new>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+// Bump allocator that owns the AST of one compilation unit (a file or a REPL line).
+// Nodes are placed one after another in large blocks, so a parent and its children end up
+// next to each other in memory. Nodes are never destroyed one by one: the whole tree goes
+// away with the arena (or reset()), one free per block. Node types must therefore be
+// trivially destructible - children are plain pointers into the same arena, and text is
+// copied with copy() instead of being kept in a std::string.
+class AstArena {
+public:
+    static constexpr size_t kBlockSize = 64 * 1024;
+
+    AstArena() = default;
+    AstArena(const AstArena&) = delete;
+    AstArena& operator=(const AstArena&) = delete;
+    AstArena(AstArena&&) = default;
+    AstArena& operator=(AstArena&&) = default;
+
+    template <typename T, typename... Args>
+    T* make(Args&&... args) {
+        static_assert(std::is_trivially_destructible_v<T>, "AST nodes are never destroyed and must not own resources");
+        return new (allocate(sizeof(T), alignof(T))) T(std::forward<Args>(args)...);
+    }
+
+    // Copy of `text` that lives as long as the arena
+    std::string_view copy(std::string_view text);
+
+    void* allocate(size_t size, size_t align) {
+        uintptr_t p = (reinterpret_cast<uintptr_t>(cursor_) + (align - 1)) & ~static_cast<uintptr_t>(align - 1);
+        if (p + size > reinterpret_cast<uintptr_t>(limit_)) return allocate_slow_(size, align);
+        cursor_ = reinterpret_cast<char*>(p + size);
+        used_ += size;
+        return reinterpret_cast<void*>(p);
+    }
+
+    // Drops every node at once; the first block is kept for reuse (e.g. the next REPL line)
+    void reset();
+
+    size_t bytesUsed() const { return used_; }
+    size_t blockCount() const { return blocks_.size(); }
+
+private:
+    std::vector<std::unique_ptr<char[]>> blocks_;
+    char* cursor_ = nullptr;
+    char* limit_ = nullptr;
+    size_t used_ = 0;
+
+    void* allocate_slow_(size_t size, size_t align);
+};
@@ -3,49 +3,49 @@
 #include "ast_visitor.hpp"
 #include "expression.hpp" 
 #include "statement.hpp"  
+#include <ostream>
 #include <string>
-#include <vector> // Для std::vector<std::unique_ptr<IStatement>>
-#include <memory>   // Для std::unique_ptr
-#include <sstream> 
-#include <initializer_list> // Для std::initializer_list
-
-// Forward declarations для expression.hpp и statement.hpp, чтобы избежать прямого включения в заголовок,
-// если это возможно и достаточно. Однако, для доступа к членам (например, expr.left_)
-// нам могут понадобиться полные определения.
-// class IExpression;
-// class NumericLiteral;
-// class StringLiteral;
-// class BooleanLiteral;
-// class IdentifierExpression;
-// class BinaryExpression;
-// class UnaryExpression;
-// class IStatement;
-// class ExpressionStatement;
-
-class AstPrinter : public AstVisitor {
+#include <string_view>
+#include <vector> // Для std::vector<IStatement*>
+
+// Печать дерева в текстовом виде для -T. Вывод пишется прямо в поток через один буфер:
+// ни на один узел не создается отдельная строка, стоимость линейна по числу узлов.
+// Поддеревья обходятся явным стеком, поэтому глубина дерева не расходует стек вызовов.
+class AstPrinter : public AstVisitor<AstPrinter> {
 public:
-    std::string print(const IExpression& expression);
-    std::string print(const IStatement& statement);
-    std::string print(const std::vector<std::unique_ptr<IStatement>>& statements);
+    explicit AstPrinter(std::ostream& out) : out_(out) {}
+    ~AstPrinter() { flush(); }
+
+    // Каждый print выводит узел с переводом строки в конце и сбрасывает буфер в поток
+    void print(const IExpression& expression);
+    void print(const IStatement& statement);
+    void print(const std::vector<IStatement*>& statements);
 
     // Visit methods for Expression nodes
-    std::string visitNumericLiteral(const NumericLiteral& expr) override;
-    std::string visitStringLiteral(const StringLiteral& expr) override;
-    std::string visitBooleanLiteral(const BooleanLiteral& expr) override;
-    std::string visitIdentifierExpression(const IdentifierExpression& expr) override;
-    std::string visitBinaryExpression(const BinaryExpression& expr) override;
-    std::string visitUnaryExpression(const UnaryExpression& expr) override;
+    // Листья печатаются целиком, составные узлы - только заголовок: детей и закрывающую
+    // скобку они кладут в стек обхода.
+    void visitNumericLiteral(const NumericLiteral& expr);
+    void visitStringLiteral(const StringLiteral& expr);
+    void visitBooleanLiteral(const BooleanLiteral& expr);
+    void visitIdentifierExpression(const IdentifierExpression& expr);
+    void visitBinaryExpression(const BinaryExpression& expr);
+    void visitUnaryExpression(const UnaryExpression& expr);
+    void visitAssignmentExpression(const AssignmentExpression& expr);
 
     // Visit methods for Statement nodes
-    std::string visitExpressionStatement(const ExpressionStatement& stmt) override;
+    void visitExpressionStatement(const ExpressionStatement& stmt);
 
 private:
-    // Вспомогательная функция для создания строки с отступом и скобками для родительских узлов
-    std::string parenthesize(const std::string& name, int currentIndent, const std::vector<const IExpression*>& expressions);
-    std::string parenthesize(const std::string& name, int currentIndent, std::initializer_list<const IExpression*> expressions_list); // Удобная обертка
-    
+    std::ostream& out_;
+    std::string buffer_; // Накопленный вывод, уходит в out_ во flush()
+    std::vector<const IExpression*> stack_; // Узлы, ожидающие печати; nullptr - закрывающая скобка
+    int m_currentIndentLevel = 0; // Уровень составных узлов текущего выражения (листья на уровень глубже)
+
+    // Печать выражения и всего его поддерева на уровне level
+    void printExpression(const IExpression& root, int level);
+    void flush();
+
     // Вспомогательная функция для генерации отступов
-    std::string indent(int level) const;
-    
-    int m_currentIndentLevel = 0; // Для управления отступами при печати
-}; 
+    void indent(int level) { buffer_.append(static_cast<size_t>(level < 0 ? 0 : level) * 2, ' '); } // 2 пробела на уровень отступа
+    void open(std::string_view name, std::string_view detail);
+};
@@ -1,32 +1,44 @@
 #pragma once
-#include <string>
 
-// Forward declarations of AST node types
-// Expressions
-class NumericLiteral;
-class StringLiteral;
-class BooleanLiteral;
-class IdentifierExpression;
-class BinaryExpression;
-class UnaryExpression;
-
-// Statements
-class ExpressionStatement;
-// Add other statement types as they appear
+#include "expression.hpp"
+#include "statement.hpp"
 
+// Статически диспетчеризуемый посетитель (CRTP). Derived наследуется от AstVisitor<Derived, Result>
+// и предоставляет visit-метод для каждого типа узла, возвращающий Result (void, Value, NodeIndex...):
+//
+//   class Printer : public AstVisitor<Printer> {
+//   public:
+//       void visitNumericLiteral(const NumericLiteral& expr);
+//       ...
+//   };
+//
+// visit() выбирает метод по kind() узла и вызывает его напрямую: без виртуальных вызовов и без
+// промежуточных строк. Дети не обходятся автоматически - проход сам решает, рекурсией или
+// явным стеком (для глубоких деревьев, см. AstPrinter).
+template <typename Derived, typename Result = void>
 class AstVisitor {
 public:
-    virtual ~AstVisitor() = default;
+    Result visit(const IExpression& expr) {
+        Derived& self = static_cast<Derived&>(*this);
+        switch (expr.kind()) {
+            case ExpressionKind::NUMERIC:    return self.visitNumericLiteral(static_cast<const NumericLiteral&>(expr));
+            case ExpressionKind::STRING:     return self.visitStringLiteral(static_cast<const StringLiteral&>(expr));
+            case ExpressionKind::BOOLEAN:    return self.visitBooleanLiteral(static_cast<const BooleanLiteral&>(expr));
+            case ExpressionKind::IDENTIFIER: return self.visitIdentifierExpression(static_cast<const IdentifierExpression&>(expr));
+            case ExpressionKind::BINARY:     return self.visitBinaryExpression(static_cast<const BinaryExpression&>(expr));
+            case ExpressionKind::UNARY:      return self.visitUnaryExpression(static_cast<const UnaryExpression&>(expr));
+            default:                         return self.visitAssignmentExpression(static_cast<const AssignmentExpression&>(expr)); // ASSIGNMENT
+        }
+    }
 
-    // Visit methods for Expression nodes
-    virtual std::string visitNumericLiteral(const NumericLiteral& expr) = 0;
-    virtual std::string visitStringLiteral(const StringLiteral& expr) = 0;
-    virtual std::string visitBooleanLiteral(const BooleanLiteral& expr) = 0;
-    virtual std::string visitIdentifierExpression(const IdentifierExpression& expr) = 0;
-    virtual std::string visitBinaryExpression(const BinaryExpression& expr) = 0;
-    virtual std::string visitUnaryExpression(const UnaryExpression& expr) = 0;
+    Result visit(const IStatement& stmt) {
+        Derived& self = static_cast<Derived&>(*this);
+        switch (stmt.kind()) {
+            default: return self.visitExpressionStatement(static_cast<const ExpressionStatement&>(stmt)); // EXPRESSION
+        }
+    }
 
-    // Visit methods for Statement nodes
-    virtual std::string visitExpressionStatement(const ExpressionStatement& stmt) = 0;
-    // Add other visit methods for statements as they appear
+protected:
+    AstVisitor() = default;
+    ~AstVisitor() = default;
 };
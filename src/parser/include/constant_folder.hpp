@@ -0,0 +1,46 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+#include "ast_arena.hpp"
+#include "expression.hpp"
+#include "statement.hpp"
+
+// Проход после разбора (до Resolver): сворачивает константные подвыражения и упрощает
+// тождества, не меняя результата программы - ни значений, ни ошибок, ни их порядка.
+//
+//   2 * 7 + 8 * 2        -> 30          (по правилам IEEE, через applyBinary/applyUnary)
+//   x * 1, 1 * x, x / 1  -> x           x - 0 -> x   (x + 0 не трогаем: -0 + 0 == +0)
+//   --x                  -> x           not not x -> x
+//   x ** 2               -> x * x       (x - небольшое выражение без присваиваний)
+//   false and x -> false, true or x -> true, true and x / x and true -> x, ...
+//
+// Тождества применяются, только если тип x известен заранее (число для арифметики, bool
+// для логики): для строки x * 1 - ошибка, а x - нет. Подвыражение, вычисление которого
+// бросает ошибку ("a" - 1), остается в дереве, чтобы ошибка случилась при выполнении.
+// Узлы меняются на месте, новые литералы создаются в arena. Обход идет явным стеком.
+class ConstantFolder {
+public:
+    void fold(IStatement& statement, AstArena& arena);
+    IExpression* fold(IExpression* expression, AstArena& arena); // Возвращает новый корень
+
+private:
+    enum class Step : uint8_t { ENTER, EXIT };
+    struct Frame {
+        IExpression* node;
+        Step step;
+    };
+    struct Folded {
+        IExpression* node;
+        StaticType type;
+        uint32_t size; // Узлов в поддереве
+        bool pure;     // Без присваиваний: поддерево можно вычислить дважды
+        StaticType operand = StaticType::UNKNOWN; // Для унарного узла - тип его операнда
+    };
+
+    std::vector<Frame> frames_;  // Переиспользуются между инструкциями
+    std::vector<Folded> done_;   // Свернутые дети, ожидающие родителя
+
+    Folded foldBinary(BinaryExpression* node, Folded left, Folded right, AstArena& arena);
+    Folded foldUnary(UnaryExpression* node, Folded operand, AstArena& arena);
+};
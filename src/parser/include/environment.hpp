@@ -0,0 +1,50 @@
+#pragma once
+
+#include <cstdint>
+#include <string_view>
+#include <vector>
+#include "value.hpp"
+#include "../../lexer/include/symbol_table.hpp"
+
+// Слот переменной, которую Resolver еще не связал
+inline constexpr uint32_t kNoSlot = UINT32_MAX;
+
+// Ошибка "Undefined variable 'name'" в позиции line:column (runtime error)
+[[noreturn]] void undefinedVariable(std::string_view name, uint32_t line, uint32_t column);
+
+// Переменные программы по областям видимости. Resolver заранее связывает каждое имя с парой
+// (depth, slot): depth - на сколько областей выше текущей лежит переменная, slot - её индекс
+// в массиве значений этой области. Чтение и запись - обращение по индексу, без поиска по имени.
+class Environment {
+public:
+    Environment() : scopes_(1) {} // Глобальная область
+
+    // Области видимости (блоки, вызовы функций) открываются и закрываются парами
+    void pushScope() { scopes_.emplace_back(); }
+    void popScope() { scopes_.pop_back(); }
+
+    bool isDefined(uint32_t depth, uint32_t slot) const {
+        const Scope& scope = at(depth);
+        return slot < scope.defined.size() && scope.defined[slot];
+    }
+
+    // Бросает runtime error (с именем name из symbols и позицией line:column), если переменная
+    // не определена
+    const Value& get(uint32_t depth, uint32_t slot, const SymbolTable& symbols, Symbol name, uint32_t line, uint32_t column) const;
+
+    // Значение переменной, про которую уже известно, что она определена (isDefined)
+    const Value& value(uint32_t depth, uint32_t slot) const { return at(depth).values[slot]; }
+
+    // Присваивание определяет переменную, если её ещё нет
+    void assign(uint32_t depth, uint32_t slot, Value value);
+
+private:
+    struct Scope {
+        std::vector<Value> values;    // по слоту
+        std::vector<uint8_t> defined; // по слоту
+    };
+    std::vector<Scope> scopes_; // Последняя - текущая
+
+    const Scope& at(uint32_t depth) const { return scopes_[scopes_.size() - 1 - depth]; }
+    Scope& at(uint32_t depth) { return scopes_[scopes_.size() - 1 - depth]; }
+};
@@ -1,43 +1,84 @@
 #pragma once
 
 #include "../../lexer/include/token.hpp"
+#include <cstdint>
 #include <string>
-#include <variant>
-#include <memory> // Для std::unique_ptr
+#include <string_view>
 #include "../../lexer/include/token.hpp" // Для Token
-#include "ast_visitor.hpp" // Для AstVisitor
-
-// Определяем возможные типы значений, которые могут возвращать выражения
-using Value = std::variant<double, bool, std::string>; 
+#include "../../lexer/include/symbol_table.hpp" // Для Symbol
+#include "value.hpp" // Для Value
+#include "environment.hpp" // Для kNoSlot
+#include "operator_table.hpp" // Для OperatorKind
+
+// Конкретный тип узла. По нему AstVisitor выбирает visit-метод статически, а проходы с явным
+// стеком - как обойти детей (switch по kind()), без виртуальных вызовов.
+enum class ExpressionKind : uint8_t {
+    NUMERIC,
+    STRING,
+    BOOLEAN,
+    IDENTIFIER,
+    BINARY,
+    UNARY,
+    ASSIGNMENT
+};
 
-class Environment; // Forward declaration
+// Тип, известный до выполнения: каким будет значение узла, если его вычисление завершится
+// без ошибки (см. ConstantFolder, TypeInference)
+enum class StaticType : uint8_t { UNKNOWN, NUMBER, BOOLEAN, STRING };
+
+// Тип результата бинарного (не логического) оператора по типам операндов: + - число, если
+// хоть один операнд число (иначе была бы ошибка), строка - если хоть один строка
+constexpr StaticType binaryResultType(TokenType op, StaticType left, StaticType right) {
+    if (op == TokenType::OPERATOR_PLUS) {
+        if (left == StaticType::NUMBER || right == StaticType::NUMBER) return StaticType::NUMBER;
+        if (left == StaticType::STRING || right == StaticType::STRING) return StaticType::STRING;
+        return StaticType::UNKNOWN;
+    }
+    return operatorInfo(op).kind == OperatorKind::ARITHMETIC ? StaticType::NUMBER : StaticType::BOOLEAN;
+}
 
 // Базовый интерфейс для всех узлов выражений AST
+// Узлы создаются в AstArena (arena.make<...>()) и освобождаются вместе с ней, поэтому
+// деструктор не виртуальный и тривиальный: узлы не владеют ресурсами, дети - обычные указатели.
 class IExpression {
 public:
-    virtual ~IExpression() = default;
     virtual Value evaluate(Environment& env) const = 0;
-    virtual std::string accept(AstVisitor& visitor) const = 0;
+    ExpressionKind kind() const { return kind_; }
+protected:
+    explicit IExpression(ExpressionKind kind) : kind_(kind) {}
+    ~IExpression() = default;
+private:
+    ExpressionKind kind_;
 };
 
+// Вычисляет выражение обходом с явным стеком: глубина дерева не расходует стек вызовов.
+// evaluate() составных узлов вызывает эту функцию.
+Value evaluateExpression(const IExpression& root, Environment& env);
+
 // Конкретные классы выражений
 
+// Номер общего узла (см. SubexpressionTable): у необщего узла - kNotShared
+inline constexpr uint32_t kNotShared = UINT32_MAX;
+
 // Для числовых литералов (например, 123, 45.67)
 class NumericLiteral : public IExpression {
 public:
     double value_;
+    bool is_integer_ = false; // Литерал без дробной части: integer_value_ точно равен исходному числу
+    int64_t integer_value_ = 0;
     explicit NumericLiteral(double val);
+    explicit NumericLiteral(const Token& token); // Значение уже разобрано лексером
     Value evaluate(Environment& env) const override;
-    std::string accept(AstVisitor& visitor) const override;
 };
 
 // Для строковых литералов (например, "hello")
 class StringLiteral : public IExpression {
 public:
-    std::string value_;
-    explicit StringLiteral(std::string val);
+    std::string_view value_; // Текст токена вместе с кавычками, скопирован в AstArena
+    InternedString string_;  // Содержимое как значение: общая копия для одинаковых литералов
+    explicit StringLiteral(std::string_view val);
+    std::string_view text() const; // Содержимое строки без кавычек
     Value evaluate(Environment& env) const override;
-    std::string accept(AstVisitor& visitor) const override;
 };
 
 // Для булевых литералов (например, true, false)
@@ -46,31 +87,35 @@ public:
     bool value_;
     explicit BooleanLiteral(bool val);
     Value evaluate(Environment& env) const override;
-    std::string accept(AstVisitor& visitor) const override;
 };
 
 // Для идентификаторов (переменных)
+// Имя хранится как Symbol: сравнение и поиск - одно сравнение чисел. symbols_ - таблица, в
+// которой лексер интернировал имя (по умолчанию SymbolTable::global(), см. Lexer::setSymbolTable)
 class IdentifierExpression : public IExpression {
 public:
-    Token name_token_;
-    explicit IdentifierExpression(Token token);
-    virtual std::string getName() const { return name_token_.getValue(); }
+    Symbol symbol_;
+    const SymbolTable* symbols_;
+    uint32_t line_ = 0;   // Позиция имени в исходнике (для диагностики)
+    uint32_t column_ = 0;
+    uint32_t depth_ = 0;        // Связывание с переменной в Environment, заполняет Resolver
+    uint32_t slot_ = kNoSlot;
+    IdentifierExpression(const Token& token, const SymbolTable& symbols);
+    std::string_view getName() const { return symbols_->name(symbol_); }
     Value evaluate(Environment& env) const override;
-    std::string accept(AstVisitor& visitor) const override;
 };
 
 // Для бинарных выражений (например, a + b, 1 * 2)
 class BinaryExpression : public IExpression {
 public:
-    std::unique_ptr<IExpression> left_;
+    IExpression* left_;
     Token operator_token_; // Токен оператора (например, +, -, *, /)
-    std::unique_ptr<IExpression> right_;
+    IExpression* right_;
+    uint32_t shared_ = kNotShared; // Номер значения, которое вычисляется один раз на инструкцию
+    bool numeric_ = false;         // Оба операнда - числа (доказано TypeInference): без проверок типов
 
-    BinaryExpression(std::unique_ptr<IExpression> left, 
-                     Token op_token, 
-                     std::unique_ptr<IExpression> right);
+    BinaryExpression(IExpression* left, Token op_token, IExpression* right);
     Value evaluate(Environment& env) const override;
-    std::string accept(AstVisitor& visitor) const override;
 };
 
 // --- UnaryExpression ---
@@ -78,40 +123,26 @@ public:
 class UnaryExpression : public IExpression {
 public:
     Token operator_token_; // Токен оператора (например, "!" или "-")
-    std::unique_ptr<IExpression> right_; // Операнд
+    IExpression* right_; // Операнд
+    uint32_t shared_ = kNotShared; // См. BinaryExpression::shared_
+    bool numeric_ = false;         // Унарный минус от числа (см. BinaryExpression::numeric_)
 
-    UnaryExpression(Token op_token, std::unique_ptr<IExpression> right);
+    UnaryExpression(Token op_token, IExpression* right);
     Value evaluate(Environment& env) const override;
-    std::string accept(AstVisitor& visitor) const override;
 };
 
-// TODO: Позже сюда добавим BinaryExpression, CallExpression и др.
-// Они будут использовать std::unique_ptr<IExpression> для дочерних узлов.
-// Например:
-/*
-class BinaryExpression : public IExpression {
+// --- AssignmentExpression ---
+// Присваивание переменной: x = 1, а также составные x += 1, x -= 1, x *= 1, x /= 1
+class AssignmentExpression : public IExpression {
 public:
-    std::unique_ptr<IExpression> left_;
-    Token operator_;
-    std::unique_ptr<IExpression> right_;
-
-    BinaryExpression(std::unique_ptr<IExpression> left, 
-                     Token op, 
-                     std::unique_ptr<IExpression> right)
-        : left_(std::move(left)), operator_(std::move(op)), right_(std::move(right)) {}
-
-    Value evaluate(Environment& env) const override {
-        Value left_val = left_->evaluate(env);
-        Value right_val = right_->evaluate(env);
-        // ... логика бинарной операции в зависимости от operator_ и типов left_val/right_val ...
-        // Например, для сложения:
-        // if (std::holds_alternative<double>(left_val) && std::holds_alternative<double>(right_val)) {
-        //     return std::get<double>(left_val) + std::get<double>(right_val);
-        // }
-        // ... обработка ошибок типов ...
-        // throw std::runtime_error("Type error in binary expression.");
-        return {}; // Placeholder
-    }
+    Symbol symbol_;        // Имя переменной, как у IdentifierExpression
+    const SymbolTable* symbols_;
+    Token operator_token_; // '=' или составной оператор
+    IExpression* value_;   // Правая часть
+    uint32_t depth_ = 0;        // Связывание с переменной в Environment, заполняет Resolver
+    uint32_t slot_ = kNoSlot;
+
+    AssignmentExpression(const IdentifierExpression& target, Token op_token, IExpression* value);
+    std::string_view getName() const { return symbols_->name(symbol_); }
+    Value evaluate(Environment& env) const override;
 };
-
-*/
@@ -0,0 +1,113 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "../../lexer/include/token.hpp"
+#include "../../lexer/include/symbol_table.hpp"
+#include "statement.hpp"
+#include "environment.hpp"
+
+// Компактное представление AST: узлы лежат в непрерывных массивах (struct-of-arrays),
+// дети задаются 32-битными индексами. Код операции, операнд и позиция в исходнике хранятся
+// в отдельных столбцах, поэтому проход, которому нужен только один столбец, читает только его.
+//
+// Узлы идут в обратном польском порядке (дети раньше родителя), и каждая инструкция занимает
+// непрерывный диапазон [statementFirst(i), statementRoot(i)]. Вычисление - линейный проход по
+// диапазону со стеком значений, без виртуальных вызовов (см. FlatEvaluator).
+// Сокращенные and/or раскладываются как [левый операнд] LOGICAL_TEST [правый операнд] LOGICAL:
+// LOGICAL_TEST хранит в rhs индекс своего LOGICAL, куда вычисление переходит, если результат
+// уже известен по левому операнду.
+
+using NodeIndex = uint32_t;
+inline constexpr NodeIndex kNoNode = UINT32_MAX;
+
+enum class FlatOp : uint8_t {
+    NUMBER,       // operand: биты double
+    INTEGER,      // operand: int64 (литерал без дробной части, печатается точно)
+    STRING,       // operand: смещение << 32 | длина текста токена (с кавычками) в strings_
+    BOOLEAN,      // operand: 0 / 1
+    IDENTIFIER,   // operand: слот << 32 | Symbol (см. Resolver)
+    UNARY,        // lhs: операнд
+    BINARY,       // lhs, rhs
+    LOGICAL,      // lhs, rhs: and/or/&&/||
+    LOGICAL_TEST, // служебный узел между операндами LOGICAL, rhs: индекс LOGICAL
+    ASSIGN        // operand: слот << 32 | Symbol переменной, lhs: значение
+};
+
+class FlatAst {
+public:
+    size_t size() const { return ops_.size(); }
+
+    FlatOp op(NodeIndex node) const { return ops_[node]; }
+    TokenType operatorType(NodeIndex node) const { return operators_[node]; }
+    NodeIndex lhs(NodeIndex node) const { return lhs_[node]; }
+    NodeIndex rhs(NodeIndex node) const { return rhs_[node]; }
+    uint32_t line(NodeIndex node) const { return lines_[node]; }     // 0, если неизвестна (литералы)
+    uint32_t column(NodeIndex node) const { return columns_[node]; }
+
+    double number(NodeIndex node) const;
+    int64_t integer(NodeIndex node) const { return static_cast<int64_t>(operands_[node]); }
+    std::string_view string(NodeIndex node) const;
+    bool boolean(NodeIndex node) const { return operands_[node] != 0; }
+    Symbol symbol(NodeIndex node) const { return static_cast<Symbol>(operands_[node]); }
+    // Таблица, в которой интернированы Symbol узлов (берется из узлов дерева при lowerToFlat)
+    const SymbolTable& symbols() const { return *symbols_; }
+    // Слот переменной в текущей области Environment. Плоский AST пока описывает код одной
+    // области видимости, поэтому depth всегда 0.
+    uint32_t slot(NodeIndex node) const { return static_cast<uint32_t>(operands_[node] >> 32); }
+
+    // Токен оператора узла для сообщений об ошибках
+    Token operatorToken(NodeIndex node) const { return Token(operators_[node], valueTT[static_cast<size_t>(operators_[node])], lines_[node], columns_[node]); }
+
+    size_t statementCount() const { return statement_roots_.size(); }
+    NodeIndex statementFirst(size_t i) const { return statement_firsts_[i]; }
+    NodeIndex statementRoot(size_t i) const { return statement_roots_[i]; }
+
+    // Построение
+    NodeIndex add(FlatOp op, TokenType op_type, NodeIndex lhs, NodeIndex rhs, uint64_t operand, uint32_t line = 0, uint32_t column = 0);
+    void setRhs(NodeIndex node, NodeIndex rhs) { rhs_[node] = rhs; }
+    void setSymbolTable(const SymbolTable& symbols) { symbols_ = &symbols; }
+    uint64_t storeString(std::string_view text);
+    void addStatement(NodeIndex first, NodeIndex root);
+    void reserve(size_t nodes);
+    void clear();
+
+    // Диспетчеризация по коду операции без виртуальных вызовов. Visitor предоставляет
+    // visitNumber, visitString, visitBoolean, visitIdentifier, visitUnary, visitBinary
+    // (BINARY и LOGICAL) и visitAssign, каждый с параметрами (const FlatAst&, NodeIndex).
+    template <typename Visitor>
+    decltype(auto) accept(NodeIndex node, Visitor& visitor) const {
+        switch (ops_[node]) {
+            case FlatOp::NUMBER:
+            case FlatOp::INTEGER:    return visitor.visitNumber(*this, node);
+            case FlatOp::STRING:     return visitor.visitString(*this, node);
+            case FlatOp::BOOLEAN:    return visitor.visitBoolean(*this, node);
+            case FlatOp::IDENTIFIER: return visitor.visitIdentifier(*this, node);
+            case FlatOp::UNARY:      return visitor.visitUnary(*this, node);
+            case FlatOp::ASSIGN:     return visitor.visitAssign(*this, node);
+            default:                 return visitor.visitBinary(*this, node); // BINARY, LOGICAL
+        }
+    }
+
+private:
+    // Столбцы, по одному элементу на узел
+    std::vector<FlatOp> ops_;
+    std::vector<TokenType> operators_;
+    std::vector<NodeIndex> lhs_;
+    std::vector<NodeIndex> rhs_;
+    std::vector<uint64_t> operands_;
+    std::vector<uint32_t> lines_;
+    std::vector<uint32_t> columns_;
+
+    std::vector<NodeIndex> statement_firsts_;
+    std::vector<NodeIndex> statement_roots_;
+    std::string strings_; // Тексты строковых литералов подряд
+    const SymbolTable* symbols_ = &SymbolTable::global();
+};
+
+// Переводит дерево инструкций в плоское представление (добавляет к `out`).
+// Инструкции должны быть уже разрешены Resolver (слоты переменных берутся из узлов).
+void lowerToFlat(const std::vector<IStatement*>& statements, FlatAst& out);
+void lowerToFlat(const IStatement& statement, FlatAst& out);
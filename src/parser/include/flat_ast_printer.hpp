@@ -0,0 +1,32 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include "flat_ast.hpp"
+
+// Печать плоского AST в том же формате, что и AstPrinter.
+// Весь вывод дописывается в одну строку, без промежуточных строк на каждый узел.
+class FlatAstPrinter {
+public:
+    std::string print(const FlatAst& ast);
+
+    // Методы посетителя для FlatAst::accept. Составные узлы печатают только заголовок,
+    // детей и закрывающую скобку выводит printNode.
+    void visitNumber(const FlatAst& ast, NodeIndex node);
+    void visitString(const FlatAst& ast, NodeIndex node);
+    void visitBoolean(const FlatAst& ast, NodeIndex node);
+    void visitIdentifier(const FlatAst& ast, NodeIndex node);
+    void visitUnary(const FlatAst& ast, NodeIndex node);
+    void visitBinary(const FlatAst& ast, NodeIndex node);
+    void visitAssign(const FlatAst& ast, NodeIndex node);
+
+private:
+    std::string out_;
+    int level_ = 0; // Отступ составных узлов (листья печатаются на уровень глубже)
+    std::vector<NodeIndex> stack_; // Узлы, ожидающие печати; kNoNode - закрывающая скобка
+
+    void indent(int level) { out_.append(static_cast<size_t>(level < 0 ? 0 : level) * 2, ' '); }
+    void leaf(std::string_view text);
+    void open(std::string_view name, std::string_view detail);
+    void printNode(const FlatAst& ast, NodeIndex root);
+};
@@ -0,0 +1,22 @@
+#pragma once
+
+#include <vector>
+#include "flat_ast.hpp"
+#include "environment.hpp"
+
+// Вычисление плоского AST линейным проходом по узлам инструкции со стеком значений.
+// Семантика та же, что у IExpression::evaluate (общие операции из value.hpp).
+class FlatEvaluator {
+public:
+    explicit FlatEvaluator(Environment& env) : env_(env) {}
+
+    // Значение корня i-й инструкции
+    Value evaluateStatement(const FlatAst& ast, size_t i);
+
+    // Выполняет все инструкции по порядку, возвращает значение последней
+    Value run(const FlatAst& ast);
+
+private:
+    Environment& env_;
+    std::vector<Value> stack_; // Переиспользуется между инструкциями
+};
@@ -0,0 +1,99 @@
+#pragma once
+#include <cstdint>
+#include "../../lexer/include/token.hpp"
+
+// Operator table of the expression grammar, indexed by TokenType.
+// The Pratt parser looks up every operator here instead of walking one function per level,
+// so adding an operator or a level is a change to this table only.
+
+// Binding powers, from loosest to tightest
+enum class Precedence : uint8_t {
+  NONE,         // not an operator in this position
+  ASSIGNMENT,   // = += -= *= /=       (right)
+  OR,           // or ||
+  AND,          // and &&
+  NOT,          // not (prefix)
+  EQUALITY,     // == !=
+  COMPARISON,   // < <= > >=
+  TERM,         // + -
+  FACTOR,       // * / %
+  UNARY,        // - ! (prefix)
+  POWER         // **                  (right, binds tighter than a prefix on its left: -2 ** 2 == -(2 ** 2))
+};
+
+enum class Assoc : uint8_t { LEFT, RIGHT };
+
+enum class OperatorKind : uint8_t {
+  NONE,
+  ARITHMETIC,   // + - * / % **
+  COMPARISON,   // == != < <= > >=
+  LOGICAL,      // and or && || (short-circuit)
+  ASSIGN        // = and compound assignment, the left side must be an identifier
+};
+
+struct OperatorInfo {
+  Precedence infix = Precedence::NONE;   // binding power as a binary operator
+  Assoc assoc = Assoc::LEFT;
+  OperatorKind kind = OperatorKind::NONE;
+  Precedence prefix = Precedence::NONE;  // binding power of the operand as a prefix operator
+};
+
+struct OperatorTable {
+  OperatorInfo ops[static_cast<size_t>(TokenType::ERROR) + 1] {};
+};
+
+constexpr OperatorTable build_operator_table() {
+  OperatorTable t;
+  auto infix = [&t](TokenType type, Precedence p, OperatorKind kind, Assoc assoc = Assoc::LEFT) {
+    OperatorInfo& info = t.ops[static_cast<size_t>(type)];
+    info.infix = p;
+    info.kind = kind;
+    info.assoc = assoc;
+  };
+  auto prefix = [&t](TokenType type, Precedence p) { t.ops[static_cast<size_t>(type)].prefix = p; };
+
+  infix(TokenType::OPERATOR_ASSIGN, Precedence::ASSIGNMENT, OperatorKind::ASSIGN, Assoc::RIGHT);
+  infix(TokenType::OPERATOR_PLUS_EQ, Precedence::ASSIGNMENT, OperatorKind::ASSIGN, Assoc::RIGHT);
+  infix(TokenType::OPERATOR_MINUS_EQ, Precedence::ASSIGNMENT, OperatorKind::ASSIGN, Assoc::RIGHT);
+  infix(TokenType::OPERATOR_MUL_EQ, Precedence::ASSIGNMENT, OperatorKind::ASSIGN, Assoc::RIGHT);
+  infix(TokenType::OPERATOR_DIV_EQ, Precedence::ASSIGNMENT, OperatorKind::ASSIGN, Assoc::RIGHT);
+
+  infix(TokenType::KEYWORD_OR, Precedence::OR, OperatorKind::LOGICAL);
+  infix(TokenType::OPERATOR_OR, Precedence::OR, OperatorKind::LOGICAL);
+  infix(TokenType::KEYWORD_AND, Precedence::AND, OperatorKind::LOGICAL);
+  infix(TokenType::OPERATOR_AND, Precedence::AND, OperatorKind::LOGICAL);
+
+  infix(TokenType::OPERATOR_EQ, Precedence::EQUALITY, OperatorKind::COMPARISON);
+  infix(TokenType::OPERATOR_NE, Precedence::EQUALITY, OperatorKind::COMPARISON);
+  infix(TokenType::OPERATOR_LT, Precedence::COMPARISON, OperatorKind::COMPARISON);
+  infix(TokenType::OPERATOR_LE, Precedence::COMPARISON, OperatorKind::COMPARISON);
+  infix(TokenType::OPERATOR_GT, Precedence::COMPARISON, OperatorKind::COMPARISON);
+  infix(TokenType::OPERATOR_GE, Precedence::COMPARISON, OperatorKind::COMPARISON);
+
+  infix(TokenType::OPERATOR_PLUS, Precedence::TERM, OperatorKind::ARITHMETIC);
+  infix(TokenType::OPERATOR_MINUS, Precedence::TERM, OperatorKind::ARITHMETIC);
+  infix(TokenType::OPERATOR_MUL, Precedence::FACTOR, OperatorKind::ARITHMETIC);
+  infix(TokenType::OPERATOR_DIV, Precedence::FACTOR, OperatorKind::ARITHMETIC);
+  infix(TokenType::OPERATOR_MOD, Precedence::FACTOR, OperatorKind::ARITHMETIC);
+  infix(TokenType::OPERATOR_POW, Precedence::POWER, OperatorKind::ARITHMETIC, Assoc::RIGHT);
+
+  prefix(TokenType::OPERATOR_MINUS, Precedence::UNARY);
+  prefix(TokenType::OPERATOR_NOT, Precedence::UNARY);
+  prefix(TokenType::KEYWORD_NOT, Precedence::NOT);
+  return t;
+}
+
+inline constexpr OperatorTable kOperatorTable = build_operator_table();
+
+inline const OperatorInfo& operatorInfo(TokenType type) { return kOperatorTable.ops[static_cast<size_t>(type)]; }
+
+// Binary operator applied by a compound assignment (+= -> +), or `type` itself
+constexpr TokenType compoundBaseOperator(TokenType type) {
+  switch (type) {
+    case TokenType::OPERATOR_PLUS_EQ: return TokenType::OPERATOR_PLUS;
+    case TokenType::OPERATOR_MINUS_EQ: return TokenType::OPERATOR_MINUS;
+    case TokenType::OPERATOR_MUL_EQ: return TokenType::OPERATOR_MUL;
+    case TokenType::OPERATOR_DIV_EQ: return TokenType::OPERATOR_DIV;
+    default: return type;
+  }
+}
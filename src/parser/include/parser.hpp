@@ -1,66 +1,93 @@
 #pragma once
 
 #include "../../lexer/include/token.hpp"
+#include "../../lexer/include/lexer.hpp"
 #include "expression.hpp" // Содержит IExpression, Value и конкретные выражения
 #include "statement.hpp"  // Содержит IStatement и конкретные инструкции
+#include "ast_arena.hpp"  // Узлы AST размещаются в арене
+#include "operator_table.hpp" // Приоритеты операторов
+#include "subexpression_table.hpp" // Общие подвыражения
+#include <initializer_list>
+#include <string>
+#include <string_view>
 #include <vector>
-#include <memory> // Для std::unique_ptr
 
 class Parser {
 public:
-    // Конструктор принимает все токены для парсинга
-    explicit Parser(const std::vector<Token>& tokens);
+    // Конструктор принимает все токены для парсинга и арену, в которой будут созданы узлы AST.
+    // Арена должна жить дольше, чем используется дерево. symbols - таблица, в которую лексер
+    // интернировал идентификаторы токенов.
+    Parser(const std::vector<Token>& tokens, AstArena& arena, const SymbolTable& symbols = SymbolTable::global());
 
-    // Главный метод парсинга, возвращает список инструкций (AST)
-    std::vector<std::unique_ptr<IStatement>> parse();
+    // Потоковый режим: токены берутся из lexer.next() по мере разбора, поэтому в памяти
+    // одновременно находятся только текущий и предыдущий токены (ровно столько, сколько
+    // гарантирует потоковый лексер).
+    Parser(Lexer& lexer, AstArena& arena);
+
+    // Главный метод парсинга, возвращает список инструкций (AST), принадлежащих арене
+    std::vector<IStatement*> parse();
+
+    // Разбирает одну инструкцию верхнего уровня. Возвращает nullptr в конце входа или при
+    // ошибке (см. hasError()). Узлы прошлых инструкций парсеру больше не нужны, поэтому
+    // между вызовами арену можно очищать: память ограничена самой большой инструкцией.
+    IStatement* parseNext();
+
+    // Равные чистые подвыражения инструкции - один общий узел (по умолчанию включено)
+    void setShareSubexpressions(bool share) { subexpressions_.setEnabled(share); }
+
+    // Диагностика: "line:column: message" для каждой ошибки разбора
+    bool hasError() const { return !errors_.empty(); }
+    const std::vector<std::string>& errors() const { return errors_; }
 
 private:
-    const std::vector<Token>& tokens_; // Ссылка на исходные токены
-    size_t currentTokenIndex_;        // Индекс текущего токена для разбора
-    // Environment* environment_; // Если понадобится доступ к окружению во время парсинга
+    // Источник токенов: готовый массив или потоковый лексер
+    const std::vector<Token>* tokens_ = nullptr;
+    size_t nextTokenIndex_ = 0;       // Индекс следующего токена в tokens_
+    Lexer* lexer_ = nullptr;
+    Token current_;                   // Текущий токен
+    Token previous_;                  // Последний поглощенный токен
+    std::vector<std::string> errors_; // Накопленные сообщения об ошибках
+    AstArena& arena_;                 // Владеет всеми узлами AST
+    SubexpressionTable subexpressions_; // Создает узлы выражений, объединяя равные
+
+    // Явный стек parseBinary: узлы, ожидающие разбора своего (правого) операнда
+    enum class PendingKind : uint8_t {
+        PREFIX, // Унарный оператор op_token
+        INFIX,  // left op_token <правый операнд>
+        GROUP   // '(' <выражение> ')'
+    };
+    struct Pending {
+        PendingKind kind;
+        Precedence min; // Порог уровня, на который вернется разбор после узла
+        IExpression* left;
+        Token op_token; // У INFIX and/or правый операнд - ветвь SubexpressionTable
+    };
+    std::vector<Pending> pending_; // Переиспользуется между выражениями
 
     // Вспомогательные методы парсера
-    Token advance();                 // Передвигает указатель на следующий токен и возвращает предыдущий
-    Token peek() const;              // Возвращает текущий токен без сдвига указателя
-    Token previous() const;          // Возвращает предыдущий токен
+    Token fetch();                   // Следующий токен из источника (_EOF после конца)
+    const Token& advance();          // Передвигает указатель на следующий токен и возвращает предыдущий
+    const Token& peek() const;       // Возвращает текущий токен без сдвига указателя
+    const Token& previous() const;   // Возвращает предыдущий токен
     bool isAtEnd() const;            // Проверяет, достигнут ли конец потока токенов
     bool check(TokenType type) const; // Проверяет тип текущего токена
-    bool match(const std::vector<TokenType>& types); // Проверяет, соответствует ли текущий токен одному из типов, и если да, то сдвигает указатель
+    bool match(std::initializer_list<TokenType> types); // Проверяет, соответствует ли текущий токен одному из типов, и если да, то сдвигает указатель
 
     // Методы для разбора конкретных грамматических конструкций
-    // Все они возвращают std::unique_ptr на соответствующий узел AST или nullptr при ошибке
+    // Все они возвращают указатель на узел AST в арене или nullptr при ошибке
 
     // Инструкции (Statements)
-    std::unique_ptr<IStatement> parseDeclaration(); // Для переменных, функций (если будут)
-    std::unique_ptr<IStatement> parseStatement();
-    std::unique_ptr<IStatement> parseExpressionStatement();
-    // std::unique_ptr<IStatement> parseIfStatement();        // TODO
-    // std::unique_ptr<IStatement> parseWhileStatement();     // TODO
-    // std::unique_ptr<IStatement> parseForStatement();       // TODO
-    // std::unique_ptr<IStatement> parseFunctionDeclaration(const std::string& kind); // TODO
-    // std::unique_ptr<IStatement> parseReturnStatement();    // TODO
+    IStatement* parseDeclaration(); // Для переменных, функций (если будут)
+    IStatement* parseStatement();
+    IStatement* parseExpressionStatement();
 
     // Выражения (Expressions)
-    std::unique_ptr<IExpression> parseExpression();
-    std::unique_ptr<IExpression> parseAssignment();      // x = 10
-    std::unique_ptr<IExpression> parseLogicalOr();       // or
-    std::unique_ptr<IExpression> parseLogicalAnd();      // and
-    std::unique_ptr<IExpression> parseEquality();        // == !=
-    std::unique_ptr<IExpression> parseComparison();      // < > <= >=
-    std::unique_ptr<IExpression> parseTerm();            // + -
-    std::unique_ptr<IExpression> parseFactor();          // * /
-    std::unique_ptr<IExpression> parseUnary();           // ! -
-    // std::unique_ptr<IExpression> parseCall();             // func(args)
-    std::unique_ptr<IExpression> parsePrimary();         // Литералы, группировка, идентификаторы
-
-    // Вспомогательные методы для ошибок и синхронизации
-    void synchronize(); // Для восстановления после ошибки парсинга
-    // ParseError error(const Token& token, const std::string& message); // TODO: Определить ParseError
+    // Pratt-парсер: приоритеты и ассоциативность всех операторов берутся из kOperatorTable
+    // (operator_table.hpp), поэтому на каждый операнд приходится один вызов parseBinary.
+    IExpression* parseExpression();
+    IExpression* parseBinary(Precedence min_precedence); // Операнд и все операторы сильнее min_precedence (явный стек, без рекурсии)
+    IExpression* parsePrimary();         // Литералы и идентификаторы (скобки разбирает parseBinary)
 
-    // Старые методы, которые нужно будет адаптировать или заменить:
-    // bool parseBooleanLiteral(); -> станет частью parsePrimary
-    // bool parseIntegerLiteral(); -> станет частью parsePrimary
-    // bool parseIdentifier();     -> станет частью parsePrimary
-    // bool parseUnaryExpression(); -> заменен на parseUnary
-    // bool parseBinaryExpression(int precedence); -> заменен цепочкой parseEquality, parseComparison и т.д.
+    // Ошибки
+    void error(const Token& token, std::string_view message); // Записывает ошибку с позицией токена
 };
\ No newline at end of file
@@ -0,0 +1,37 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+#include "expression.hpp"
+#include "statement.hpp"
+#include "environment.hpp"
+
+// Проход после разбора: связывает каждое использование переменной с парой (depth, slot) в
+// Environment и записывает её в IdentifierExpression / AssignmentExpression. Слоты выдаются
+// подряд в порядке первого упоминания имени в области, поэтому массивы Environment плотные.
+//
+// Состояние областей сохраняется между вызовами resolve(): инструкции скрипта (или строки REPL)
+// разрешаются по одной, и одно имя в разных инструкциях получает один и тот же слот.
+// Обход идет явным стеком, как и остальные проходы по дереву.
+class Resolver {
+public:
+    Resolver() : scopes_(1) {} // Глобальная область
+
+    void resolve(IStatement& statement);
+    void resolve(IExpression& expression);
+
+    // Должны вызываться в тех же местах, что и Environment::pushScope/popScope
+    void pushScope() { scopes_.emplace_back(); }
+    void popScope() { scopes_.pop_back(); }
+
+private:
+    struct Scope {
+        std::vector<uint32_t> slots; // по Symbol, kNoSlot - имя в области не встречалось
+        uint32_t count = 0;          // Выдано слотов
+    };
+    std::vector<Scope> scopes_; // Последняя - текущая
+    std::vector<IExpression*> stack_; // Узлы, ожидающие обхода
+
+    // Ищет имя от текущей области наружу; не найденное объявляется в текущей области
+    void bind(Symbol name, uint32_t& depth, uint32_t& slot);
+};
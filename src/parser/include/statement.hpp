@@ -2,23 +2,32 @@
 
 #include "../../lexer/include/token.hpp"
 #include "expression.hpp" // Для IExpression и Value
-#include "ast_visitor.hpp"  // Для AstVisitor
 
 class Environment; // Forward declaration
 
+// Конкретный тип инструкции (см. ExpressionKind)
+enum class StatementKind : uint8_t {
+    EXPRESSION
+};
+
+// Инструкции, как и выражения, живут в AstArena (см. IExpression)
 class IStatement {
   public:
-    virtual ~IStatement() = default;
     virtual void execute(Environment& env) const = 0;
-    virtual std::string accept(AstVisitor& visitor) const = 0; // Добавлен параметр Environment
+    StatementKind kind() const { return kind_; }
+  protected:
+    explicit IStatement(StatementKind kind) : kind_(kind) {}
+    ~IStatement() = default;
+  private:
+    StatementKind kind_;
 };
 
 // Инструкция-выражение (например, вызов функции или операция, используемая как инструкция)
 class ExpressionStatement : public IStatement {
 public:
-    std::unique_ptr<IExpression> expression_;
+    IExpression* expression_;
+    uint32_t shared_ = 0; // Общих узлов в выражении: их номера shared_ - 0..shared_-1
 
-    explicit ExpressionStatement(std::unique_ptr<IExpression> expr);
+    explicit ExpressionStatement(IExpression* expr);
     void execute(Environment& env) const override;
-    std::string accept(AstVisitor& visitor) const override;
 };
\ No newline at end of file
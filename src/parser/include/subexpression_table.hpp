@@ -0,0 +1,78 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+#include "../../lexer/include/token.hpp"
+#include "../../lexer/include/symbol_table.hpp"
+#include "ast_arena.hpp"
+#include "expression.hpp"
+
+// Хеш-консинг узлов выражения внутри одной инструкции: структурно равные чистые поддеревья
+// создаются один раз и становятся общими, дерево инструкции превращается в DAG. Ключ узла -
+// оператор и адреса детей, которые сами уже общие, поэтому равенство поддеревьев
+// проверяется за одно сравнение ключей.
+//
+// Общий узел дает то же значение и ту же ошибку, что и каждое его вхождение:
+//  - переменная входит в ключ вместе с версией, которая меняется при каждом присваивании
+//    ей: x до и после (x = 1) - разные узлы;
+//  - присваивание не объединяется, поэтому не объединяются и узлы, которые его содержат;
+//  - узлы из правого операнда and/or (он вычисляется не всегда) видны только до конца
+//    этого операнда;
+//  - цель x = ... не совпадает с последующими чтениями x (парсер сообщает о присваивании
+//    уже по знаку =, так что у чтений в правой части другая версия и своя позиция).
+// Парсер создает узлы в порядке вычисления, поэтому первым вычисляется то вхождение, которое
+// создало узел (его позиция и попадет в сообщение об ошибке).
+//
+// Составной узел, использованный повторно, получает номер shared_: вычислители запоминают
+// его значение и не считают его второй раз.
+class SubexpressionTable {
+public:
+    explicit SubexpressionTable(AstArena& arena) : arena_(arena) {}
+
+    void setEnabled(bool enabled) { enabled_ = enabled; } // false - каждое вхождение отдельным узлом
+    void setSymbolTable(const SymbolTable& symbols) { symbols_ = &symbols; } // Таблица имен идентификаторов
+    void reset();                                       // Начало новой инструкции
+    uint32_t sharedCount() const { return shared_count_; } // Номера shared_ инструкции: 0..sharedCount()-1
+
+    IExpression* number(const Token& token);
+    IExpression* boolean(bool value);
+    IExpression* identifier(const Token& token);
+    IExpression* unary(const Token& op_token, IExpression* operand);
+    IExpression* binary(IExpression* left, const Token& op_token, IExpression* right);
+
+    void assigned(Symbol name); // Переменная получила новое значение
+    void enterBranch();         // Начало правого операнда and/or
+    void leaveBranch();
+
+private:
+    struct Key {
+        uint64_t first;
+        uint64_t second;
+        uint32_t tag; // ExpressionKind и TokenType оператора
+        bool operator==(const Key&) const = default;
+    };
+    struct Entry {
+        Key key;
+        IExpression* node = nullptr;
+        uint32_t statement = 0; // Запись действительна только в инструкции с этим номером
+        uint32_t branch = 0;    // ... и пока не закончилась ветвь, в которой она создана
+    };
+
+    AstArena& arena_;
+    const SymbolTable* symbols_ = &SymbolTable::global();
+    bool enabled_ = true;
+    std::vector<Entry> entries_ = std::vector<Entry>(256); // Открытая адресация, размер - степень двойки
+    size_t count_ = 0;              // Записей текущей инструкции
+    uint32_t statement_ = 1;
+    uint32_t shared_count_ = 0;
+    std::vector<uint8_t> live_branches_; // По номеру ветви: 1 - ветвь еще не закончилась
+    std::vector<uint32_t> branches_;     // Стек открытых ветвей, последняя - текущая
+    std::vector<uint32_t> versions_;     // По Symbol; растут от инструкции к инструкции
+
+    // Запись с ключом key, видимая сейчас, или свободная (либо устаревшая) запись для нее
+    Entry& find(const Key& key);
+    bool visible(const Entry& entry) const;
+    IExpression* reuse(Entry& entry); // Повторное вхождение узла entry
+    void insert(Entry& entry, const Key& key, IExpression* node);
+    void grow();
+};
@@ -0,0 +1,45 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+#include "../../lexer/include/symbol_table.hpp"
+#include "expression.hpp"
+#include "statement.hpp"
+
+// Вывод типов: помечает numeric_ у унарных и бинарных узлов, оба операнда которых
+// гарантированно числа. Вычислители выполняют такие узлы над double без проверок типов.
+//
+// Тип переменной известен после присваивания ей и хранится между инструкциями: инструкции
+// выполняются по порядку, поэтому после x = 1 переменная x - число, пока ей не присвоят
+// что-то другое. Тип узла означает тип значения, если вычисление узла завершится без ошибки
+// (y + 1 - число при любом y: иначе ошибка). Присваивания в правом операнде and/or могут
+// не выполниться, поэтому после него тип переменной - общий для обоих исходов.
+//
+// Если инструкция прервалась ошибкой, часть ее присваиваний не выполнена: вызывающий код
+// должен сбросить известные типы (reset()). Обход идет явным стеком, как в Resolver.
+class TypeInference {
+public:
+    void infer(IStatement& statement);
+    void infer(IExpression& expression);
+    void reset() { variables_.clear(); } // Типы всех переменных снова неизвестны
+
+private:
+    enum class Step : uint8_t { ENTER, LOGICAL_RIGHT, EXIT };
+    struct Frame {
+        IExpression* node;
+        Step step;
+        uint32_t log; // EXIT для and/or: начало присваиваний правого операнда в log_
+    };
+    struct Assigned {
+        Symbol name;
+        StaticType before; // Тип переменной до присваивания
+    };
+
+    std::vector<StaticType> variables_; // По Symbol
+    std::vector<Frame> frames_;  // Переиспользуются между инструкциями
+    std::vector<StaticType> types_; // Типы вычисленных детей, ожидающих родителя
+    std::vector<Assigned> log_;   // Присваивания текущей инструкции
+
+    StaticType variable(Symbol name) const;
+    void assign(Symbol name, StaticType type);
+};
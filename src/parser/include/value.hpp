@@ -0,0 +1,202 @@
+#pragma once
+
+#include <bit>
+#include <cmath>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include "../../lexer/include/token.hpp"
+
+class InternedString;
+
+// Значение MathSol в 8 байтах (NaN-boxing). Число хранится как есть, остальные типы - в битах
+// NaN с установленными знаком и двумя старшими битами мантиссы. Настоящие NaN при записи
+// в Value приводятся к одному каноническому, поэтому с упакованными значениями не путаются:
+//
+//   1111 1111 1111 11TT  + 48 бит данных
+//   TT = 01 - bool (данные 0 или 1)
+//   TT = 10 - строка в куче (данные - указатель на StringObject)
+//   TT = 11 - короткая строка до 5 байт прямо в данных (байты 0-4 - текст, байт 5 - длина)
+//
+// Число, bool, inf и короткая строка копируются как 8 байт без выделения памяти. Строка
+// в куче неизменяема и общая: копия Value увеличивает атомарный счетчик ссылок, деструктор
+// уменьшает. Склейка длинных строк (concat) не копирует текст, а строит rope - узел со
+// ссылками на обе части; текст собирается один раз при первом чтении (asString).
+class Value {
+public:
+    Value() : bits_(0) {} // Число 0
+    Value(double number) : bits_(std::bit_cast<uint64_t>(number)) {
+        if ((bits_ & kBoxMask) == kBoxMask) bits_ = kCanonicalNaN;
+    }
+    Value(bool boolean) : bits_(kBoolTag | static_cast<uint64_t>(boolean)) {}
+    Value(std::string_view text);
+    Value(const char* text) : Value(std::string_view(text)) {} // Иначе const char* стал бы bool
+    Value(std::string text);
+    Value(InternedString text);
+
+    Value(const Value& other) : bits_(other.bits_) { retain(); }
+    Value(Value&& other) noexcept : bits_(other.bits_) { other.bits_ = 0; }
+    Value& operator=(const Value& other) {
+        other.retain(); // До release: other может быть той же строкой
+        release();
+        bits_ = other.bits_;
+        return *this;
+    }
+    Value& operator=(Value&& other) noexcept {
+        if (this != &other) {
+            release();
+            bits_ = other.bits_;
+            other.bits_ = 0;
+        }
+        return *this;
+    }
+    ~Value() { release(); }
+
+    bool isNumber() const { return (bits_ & kBoxMask) != kBoxMask; }
+    bool isBool() const { return (bits_ & kTagMask) == kBoolTag; }
+    bool isString() const { return (bits_ & kStringMask) == kHeapTag; }
+
+    double asNumber() const { return std::bit_cast<double>(bits_); }
+    bool asBool() const { return bits_ & 1; }
+    // Текст строки; действителен, пока жив и не изменен этот Value
+    std::string_view asString() const {
+        if (isShort()) return {reinterpret_cast<const char*>(&bits_), shortLength()};
+        return heapText();
+    }
+    size_t stringLength() const { return isShort() ? shortLength() : heapLength(); }
+
+    // left + right для двух строк
+    static Value concat(const Value& left, const Value& right);
+
+    // == и != языка: значения разных типов не равны, NaN не равен ничему
+    friend bool operator==(const Value& left, const Value& right);
+
+    // Упакованные биты для кода, собранного из --emit-c (см. aot.hpp): raw() не передает
+    // владение строкой, fromRaw() берет новую ссылку, как копия Value
+    uint64_t raw() const { return bits_; }
+    static Value fromRaw(uint64_t bits) {
+        Value value;
+        value.bits_ = bits;
+        value.retain();
+        return value;
+    }
+
+private:
+    friend class InternedString;
+    struct StringObject;
+
+    static constexpr uint64_t kBoxMask = 0xFFFC000000000000;
+    static constexpr uint64_t kTagMask = 0xFFFF000000000000;
+    static constexpr uint64_t kStringMask = 0xFFFE000000000000; // Общие биты двух видов строк
+    static constexpr uint64_t kBoolTag = 0xFFFD000000000000;
+    static constexpr uint64_t kHeapTag = 0xFFFE000000000000;
+    static constexpr uint64_t kShortTag = 0xFFFF000000000000;
+    static constexpr uint64_t kPayloadMask = 0x0000FFFFFFFFFFFF;
+    static constexpr uint64_t kCanonicalNaN = 0x7FF8000000000000;
+    static constexpr size_t kShortCapacity = 5;
+
+    uint64_t bits_;
+
+    bool isHeap() const { return (bits_ & kTagMask) == kHeapTag; }
+    bool isShort() const { return (bits_ & kTagMask) == kShortTag; }
+    size_t shortLength() const { return (bits_ >> 40) & 0xFF; }
+    StringObject* object() const { return reinterpret_cast<StringObject*>(bits_ & kPayloadMask); }
+
+    static uint64_t shortBits(std::string_view text); // text.size() <= kShortCapacity
+    std::string_view heapText() const;
+    size_t heapLength() const;
+
+    void retain() const { if (isHeap()) retainString(); }
+    void release() { if (isHeap()) releaseString(); }
+    void retainString() const;
+    void releaseString();
+};
+
+static_assert(std::endian::native == std::endian::little, "short strings are read from the bytes of Value");
+
+// Интернированная строка (литерал программы): одна общая копия текста на всю программу
+// в таблице, которая живет до конца работы. Тривиально копируется и не владеет ссылкой,
+// поэтому её можно хранить в узлах AstArena; Value из неё получается без поиска и копирования.
+class InternedString {
+public:
+    InternedString() : bits_(0) {}
+    static InternedString intern(std::string_view text);
+
+private:
+    friend class Value;
+    uint64_t bits_; // Биты Value: короткая строка или строка таблицы
+};
+
+static_assert(sizeof(Value) == 8, "Value must stay one machine word");
+
+// Операции над значениями, общие для всех способов выполнения (дерево, плоское AST, ...).
+// Ошибки типов бросают std::runtime_error с позицией токена `where`.
+//
+//   + - * / % **      числа (IEEE: 1 / 0 == inf); + также склеивает две строки
+//   < <= > >=         два числа или две строки
+//   == !=             любые значения; значения разных типов не равны
+//   - (унарный)       число
+//   ! not             логическое значение
+// and/or вычисляются сокращенно вызывающим кодом, здесь проверяется только тип операнда.
+Value applyBinary(TokenType op, const Value& left, const Value& right, const Token& where);
+Value applyUnary(TokenType op, const Value& operand, const Token& where);
+
+// Быстрый путь applyBinary для арифметики и сравнений двух чисел, встраиваемый в циклы
+// вычислителей. false - операнды не числа или оператор не числовой (тогда нужен applyBinary).
+inline bool applyNumeric(TokenType op, const Value& left, const Value& right, Value& result) {
+    if (!left.isNumber() || !right.isNumber()) return false;
+    double l = left.asNumber();
+    double r = right.asNumber();
+    switch (op) {
+        case TokenType::OPERATOR_PLUS:  result = l + r; return true;
+        case TokenType::OPERATOR_MINUS: result = l - r; return true;
+        case TokenType::OPERATOR_MUL:   result = l * r; return true;
+        case TokenType::OPERATOR_DIV:   result = l / r; return true;
+        case TokenType::OPERATOR_LT:    result = l < r; return true;
+        case TokenType::OPERATOR_LE:    result = l <= r; return true;
+        case TokenType::OPERATOR_GT:    result = l > r; return true;
+        case TokenType::OPERATOR_GE:    result = l >= r; return true;
+        default:                        return false;
+    }
+}
+
+// Оператор ** для чисел. Квадрат считается умножением: так x ** 2 дает тот же результат,
+// что и x * x, в которое его переписывает ConstantFolder (std::pow может отличаться в
+// последнем бите).
+inline double power(double base, double exponent) {
+    return exponent == 2 ? base * base : std::pow(base, exponent);
+}
+
+// applyBinary для операндов, которые заранее известны как числа (узлы numeric_, см.
+// TypeInference): без проверок типов. op - арифметический оператор или сравнение.
+inline Value applyNumbers(TokenType op, double l, double r) {
+    switch (op) {
+        case TokenType::OPERATOR_PLUS:  return l + r;
+        case TokenType::OPERATOR_MINUS: return l - r;
+        case TokenType::OPERATOR_MUL:   return l * r;
+        case TokenType::OPERATOR_DIV:   return l / r;
+        case TokenType::OPERATOR_MOD:   return std::fmod(l, r);
+        case TokenType::OPERATOR_POW:   return power(l, r);
+        case TokenType::OPERATOR_EQ:    return l == r;
+        case TokenType::OPERATOR_NE:    return l != r;
+        case TokenType::OPERATOR_LT:    return l < r;
+        case TokenType::OPERATOR_LE:    return l <= r;
+        case TokenType::OPERATOR_GT:    return l > r;
+        default:                        return l >= r; // OPERATOR_GE
+    }
+}
+
+// Операнд and/or/&&/|| должен быть логическим значением
+bool logicalOperand(const Value& operand, const Token& where);
+
+// Содержимое строкового литерала по тексту его токена (без кавычек)
+std::string_view stringLiteralText(std::string_view token_text);
+
+// Текстовое представление значения для вывода результатов
+std::string formatValue(const Value& value);
+
+// Число в том же виде, в каком его печатает AstPrinter (без лишних нулей после точки)
+std::string formatNumber(double value);
+
+[[noreturn]] void runtimeError(uint32_t line, uint32_t column, std::string_view message);
+[[noreturn]] void runtimeError(const Token& where, std::string_view message);
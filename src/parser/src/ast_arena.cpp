@@ -0,0 +1,27 @@
+#include "../include/ast_arena.hpp"
+#include <algorithm>
+#include <cstring>
+
+std::string_view AstArena::copy(std::string_view text) {
+    if (text.empty()) return {};
+    char* dest = static_cast<char*>(allocate(text.size(), 1));
+    std::memcpy(dest, text.data(), text.size());
+    return { dest, text.size() };
+}
+
+void* AstArena::allocate_slow_(size_t size, size_t align) {
+    // Запросы больше блока получают собственный блок
+    size_t capacity = std::max(kBlockSize, size + align);
+    blocks_.push_back(std::unique_ptr<char[]>(new char[capacity])); // без обнуления
+    cursor_ = blocks_.back().get();
+    limit_ = cursor_ + capacity;
+    return allocate(size, align);
+}
+
+void AstArena::reset() {
+    if (blocks_.empty()) return;
+    blocks_.resize(1);
+    cursor_ = blocks_.front().get();
+    limit_ = cursor_ + kBlockSize; // первый блок всегда обычного размера или больше
+    used_ = 0;
+}
@@ -1,124 +1,126 @@
 // src/parser/src/ast_printer.cpp
 #include "../include/ast_printer.hpp"
-#include <iomanip> // Для std::fixed, std::setprecision (для double)
-#include <cmath>   // Для std::modf, std::abs
 
 // --- Public Print Methods ---
-std::string AstPrinter::print(const IExpression& expression) {
-    // m_currentIndentLevel сбрасывается или устанавливается здесь, если это корневой вызов для одного выражения
-    // Но для простоты, предполагаем, что visit методы сами управляют своими локальными отступами или используют m_currentIndentLevel как базовый
-    return expression.accept(*this);
+void AstPrinter::print(const IExpression& expression) {
+    printExpression(expression, 0);
+    buffer_.push_back('\n');
+    flush();
 }
 
-std::string AstPrinter::print(const IStatement& statement) {
-    // Аналогично print(IExpression&)
-    return statement.accept(*this);
+void AstPrinter::print(const IStatement& statement) {
+    m_currentIndentLevel = 0;
+    visit(statement);
+    buffer_.push_back('\n');
+    flush();
 }
 
-std::string AstPrinter::print(const std::vector<std::unique_ptr<IStatement>>& statements) {
-    std::stringstream out;
-    m_currentIndentLevel = 0; // Сброс для списка инструкций верхнего уровня
-    for (const auto& stmt_ptr : statements) {
+void AstPrinter::print(const std::vector<IStatement*>& statements) {
+    for (const IStatement* stmt_ptr : statements) {
+        m_currentIndentLevel = 0; // Сброс для каждой инструкции верхнего уровня
         if (stmt_ptr) {
-            // Каждый visit для statement будет использовать m_currentIndentLevel для своего базового отступа
-            out << stmt_ptr->accept(*this) << "\n"; 
+            visit(*stmt_ptr);
         } else {
-            out << indent(m_currentIndentLevel) << "[<nullptr statement>]\n";
+            buffer_.append("[<nullptr statement>]");
         }
+        buffer_.push_back('\n');
+        // Большой список сбрасывается по частям, чтобы буфер не рос до размера всего вывода
+        if (buffer_.size() >= 64 * 1024) flush();
     }
-    return out.str();
+    flush();
 }
 
 // --- Helper Methods ---
-std::string AstPrinter::indent(int level) const {
-    if (level < 0) level = 0;
-    return std::string(level * 2, ' '); // 2 пробела на уровень отступа
+void AstPrinter::flush() {
+    out_.write(buffer_.data(), static_cast<std::streamsize>(buffer_.size()));
+    buffer_.clear();
 }
 
-std::string AstPrinter::parenthesize(const std::string& name, int currentIndent, const std::vector<const IExpression*>& expressions) {
-    std::stringstream out;
-    out << indent(currentIndent) << "[" << name;
+void AstPrinter::open(std::string_view name, std::string_view detail) {
+    indent(m_currentIndentLevel);
+    buffer_.append("[").append(name).append(detail);
+}
+
+// Составные узлы печатаются на уровне level, листья - на уровень глубже; каждый ребенок
+// начинается с новой строки. Прямой порядок обхода с явным стеком вместо рекурсии.
+void AstPrinter::printExpression(const IExpression& root, int level) {
     int previousIndent = m_currentIndentLevel;
-    m_currentIndentLevel = currentIndent; // Устанавливаем для дочерних узлов
-    for (const IExpression* expr_ptr : expressions) {
-        if (expr_ptr) {
-            out << "\n" << expr_ptr->accept(*this); 
+    m_currentIndentLevel = level;
+    size_t base = stack_.size();
+    stack_.push_back(&root);
+    bool first = true;
+    while (stack_.size() > base) {
+        const IExpression* node = stack_.back();
+        stack_.pop_back();
+        if (!first) buffer_.push_back('\n');
+        first = false;
+        if (!node) {
+            indent(level);
+            buffer_.push_back(']');
         } else {
-            out << "\n" << indent(m_currentIndentLevel + 1) << "[<nullptr expression>]";
+            visit(*node);
         }
+        if (buffer_.size() >= 64 * 1024) flush();
     }
     m_currentIndentLevel = previousIndent; // Восстанавливаем
-    out << "\n" << indent(currentIndent) << "]";
-    return out.str();
 }
 
-std::string AstPrinter::parenthesize(const std::string& name, int currentIndent, std::initializer_list<const IExpression*> expressions_list) {
-    std::vector<const IExpression*> expressions_vec(expressions_list);
-    return parenthesize(name, currentIndent, expressions_vec);
+// --- Visit Methods for Expressions ---
+void AstPrinter::visitNumericLiteral(const NumericLiteral& expr) {
+    indent(m_currentIndentLevel + 1);
+    buffer_.append("[Numeric: ");
+    // Целочисленные литералы печатаются точно, без прохода через double
+    buffer_.append(expr.is_integer_ ? std::to_string(expr.integer_value_) : formatNumber(expr.value_));
+    buffer_.push_back(']');
 }
 
-// --- Visit Methods for Expressions ---
-std::string AstPrinter::visitNumericLiteral(const NumericLiteral& expr) {
-    // Prepend (Numeric ...) to the output
-    std::stringstream ss;
-    double val = expr.value_;
-    double intpart;
-    // Проверяем, является ли число целым (с некоторой точностью для чисел с плавающей запятой)
-    if (std::abs(std::modf(val, &intpart)) < 1e-9) { // Если дробная часть очень мала
-        ss << static_cast<long long>(val);
-    } else {
-        ss << std::fixed << std::setprecision(15) << val;
-        std::string s_val = ss.str();
-        // The rest of the original logic for formatting the number
-        s_val.erase(s_val.find_last_not_of('0') + 1, std::string::npos);
-        if (!s_val.empty() && s_val.back() == '.') {
-            s_val.pop_back();
-        }
-        return indent(m_currentIndentLevel + 1) + "[Numeric: " + s_val + "]"; // Changed line
-        s_val.erase(s_val.find_last_not_of('0') + 1, std::string::npos);
-        if (!s_val.empty() && s_val.back() == '.') {
-            s_val.pop_back();
-        }
-        return indent(m_currentIndentLevel + 1) + s_val;
-    }
-    return indent(m_currentIndentLevel + 1) + "[Numeric: " + ss.str() + "]"; // Changed line for integer part
+void AstPrinter::visitStringLiteral(const StringLiteral& expr) {
+    indent(m_currentIndentLevel + 1);
+    buffer_.append("[String: \"").append(expr.value_).append("\"]");
 }
 
-std::string AstPrinter::visitStringLiteral(const StringLiteral& expr) {
-    return indent(m_currentIndentLevel + 1) + "[String: \"" + expr.value_ + "\"]";
+void AstPrinter::visitBooleanLiteral(const BooleanLiteral& expr) {
+    indent(m_currentIndentLevel + 1);
+    buffer_.append(expr.value_ ? "[Boolean: true]" : "[Boolean: false]");
 }
 
-std::string AstPrinter::visitBooleanLiteral(const BooleanLiteral& expr) {
-    return indent(m_currentIndentLevel + 1) + "[Boolean: " + (expr.value_ ? "true" : "false") + "]";
+void AstPrinter::visitIdentifierExpression(const IdentifierExpression& expr) {
+    indent(m_currentIndentLevel + 1);
+    buffer_.append("[Identifier: ").append(expr.getName()).push_back(']');
 }
 
-std::string AstPrinter::visitIdentifierExpression(const IdentifierExpression& expr) {
-    return indent(m_currentIndentLevel + 1) + "[Identifier: " + expr.name_token_.getValue() + "]";
+void AstPrinter::visitUnaryExpression(const UnaryExpression& expr) {
+    open("Unary: ", expr.operator_token_.getValue());
+    stack_.push_back(nullptr);
+    stack_.push_back(expr.right_);
 }
 
-std::string AstPrinter::visitUnaryExpression(const UnaryExpression& expr) {
-    // parenthesize управляет m_currentIndentLevel для своих детей
-    return parenthesize("Unary: " + expr.operator_token_.getValue(), m_currentIndentLevel, {expr.right_.get()});
+void AstPrinter::visitBinaryExpression(const BinaryExpression& expr) {
+    open("Binary: ", expr.operator_token_.getValue());
+    stack_.push_back(nullptr);
+    stack_.push_back(expr.right_);
+    stack_.push_back(expr.left_);
 }
 
-std::string AstPrinter::visitBinaryExpression(const BinaryExpression& expr) {
-    // parenthesize управляет m_currentIndentLevel для своих детей
-    return parenthesize("Binary: " + expr.operator_token_.getValue(), m_currentIndentLevel, {expr.left_.get(), expr.right_.get()});
+void AstPrinter::visitAssignmentExpression(const AssignmentExpression& expr) {
+    open("Assign: ", expr.operator_token_.getValue());
+    buffer_.append(" ").append(expr.getName());
+    stack_.push_back(nullptr);
+    stack_.push_back(expr.value_);
 }
 
 // --- Visit Methods for Statements ---
-std::string AstPrinter::visitExpressionStatement(const ExpressionStatement& stmt) {
-    std::stringstream out;
-    out << indent(m_currentIndentLevel) << "[ExpressionStatement:";
+void AstPrinter::visitExpressionStatement(const ExpressionStatement& stmt) {
+    int statementIndent = m_currentIndentLevel;
+    indent(statementIndent);
+    buffer_.append("[ExpressionStatement:\n");
     if (stmt.expression_) {
-        int previousIndent = m_currentIndentLevel;
-        m_currentIndentLevel++; // Увеличиваем отступ для самого выражения внутри инструкции
-        out << "\n" << stmt.expression_->accept(*this);
-        m_currentIndentLevel = previousIndent; // Восстанавливаем отступ
-        out << "\n" << indent(m_currentIndentLevel) << "]";
+        printExpression(*stmt.expression_, statementIndent + 1); // Выражение на уровень глубже инструкции
     } else {
-        out << "\n" << indent(m_currentIndentLevel + 1) << "[<nullptr expression>]";
-        out << "\n" << indent(m_currentIndentLevel) << "]";
+        indent(statementIndent + 1);
+        buffer_.append("[<nullptr expression>]");
     }
-    return out.str();
+    buffer_.push_back('\n');
+    indent(statementIndent);
+    buffer_.push_back(']');
 }
@@ -0,0 +1,212 @@
+#include "../include/constant_folder.hpp"
+#include "../include/operator_table.hpp"
+#include <cmath>
+#include <stdexcept>
+
+namespace {
+
+// Подвыражение x ** 2 дублируется в x * x, только если оно не больше этого числа узлов
+constexpr uint32_t kSquareMaxSize = 3;
+
+bool isLiteral(const IExpression* node) {
+    ExpressionKind kind = node->kind();
+    return kind == ExpressionKind::NUMERIC || kind == ExpressionKind::STRING || kind == ExpressionKind::BOOLEAN;
+}
+
+Value literalValue(const IExpression* node) {
+    switch (node->kind()) {
+        case ExpressionKind::NUMERIC: return static_cast<const NumericLiteral*>(node)->value_;
+        case ExpressionKind::BOOLEAN: return static_cast<const BooleanLiteral*>(node)->value_;
+        default:                      return static_cast<const StringLiteral*>(node)->string_; // STRING
+    }
+}
+
+// Литерал-число, в точности равное value (с учетом знака нуля)
+bool isNumber(const IExpression* node, double value) {
+    if (node->kind() != ExpressionKind::NUMERIC) return false;
+    double number = static_cast<const NumericLiteral*>(node)->value_;
+    return number == value && std::signbit(number) == std::signbit(value);
+}
+
+bool isBoolean(const IExpression* node, bool& value) {
+    if (node->kind() != ExpressionKind::BOOLEAN) return false;
+    value = static_cast<const BooleanLiteral*>(node)->value_;
+    return true;
+}
+
+bool isOr(TokenType op) {
+    return op == TokenType::KEYWORD_OR || op == TokenType::OPERATOR_OR;
+}
+
+bool isNot(TokenType op) {
+    return op == TokenType::KEYWORD_NOT || op == TokenType::OPERATOR_NOT;
+}
+
+} // namespace
+
+void ConstantFolder::fold(IStatement& statement, AstArena& arena) {
+    switch (statement.kind()) {
+        case StatementKind::EXPRESSION: {
+            ExpressionStatement& expression_statement = static_cast<ExpressionStatement&>(statement);
+            if (expression_statement.expression_) {
+                expression_statement.expression_ = fold(expression_statement.expression_, arena);
+            }
+            break;
+        }
+    }
+}
+
+IExpression* ConstantFolder::fold(IExpression* expression, AstArena& arena) {
+    frames_.push_back({expression, Step::ENTER});
+    while (!frames_.empty()) {
+        Frame frame = frames_.back();
+        frames_.pop_back();
+        IExpression* node = frame.node;
+
+        switch (node->kind()) {
+            case ExpressionKind::NUMERIC:
+                done_.push_back({node, StaticType::NUMBER, 1, true});
+                break;
+            case ExpressionKind::STRING:
+                done_.push_back({node, StaticType::STRING, 1, true});
+                break;
+            case ExpressionKind::BOOLEAN:
+                done_.push_back({node, StaticType::BOOLEAN, 1, true});
+                break;
+            case ExpressionKind::IDENTIFIER:
+                done_.push_back({node, StaticType::UNKNOWN, 1, true});
+                break;
+            case ExpressionKind::UNARY: {
+                UnaryExpression* unary = static_cast<UnaryExpression*>(node);
+                if (frame.step == Step::ENTER) {
+                    frames_.push_back({node, Step::EXIT});
+                    frames_.push_back({unary->right_, Step::ENTER});
+                } else {
+                    done_.back() = foldUnary(unary, done_.back(), arena);
+                }
+                break;
+            }
+            case ExpressionKind::BINARY: {
+                BinaryExpression* binary = static_cast<BinaryExpression*>(node);
+                if (frame.step == Step::ENTER) {
+                    frames_.push_back({node, Step::EXIT});
+                    frames_.push_back({binary->right_, Step::ENTER});
+                    frames_.push_back({binary->left_, Step::ENTER});
+                } else {
+                    Folded right = done_.back();
+                    done_.pop_back();
+                    done_.back() = foldBinary(binary, done_.back(), right, arena);
+                }
+                break;
+            }
+            case ExpressionKind::ASSIGNMENT: {
+                AssignmentExpression* assign = static_cast<AssignmentExpression*>(node);
+                if (frame.step == Step::ENTER) {
+                    frames_.push_back({node, Step::EXIT});
+                    frames_.push_back({assign->value_, Step::ENTER});
+                    break;
+                }
+                Folded value = done_.back();
+                assign->value_ = value.node;
+                // x op= v: тип - как у x op v при неизвестном x
+                TokenType op = assign->operator_token_.getType();
+                StaticType type = op == TokenType::OPERATOR_ASSIGN
+                    ? value.type
+                    : binaryResultType(compoundBaseOperator(op), StaticType::UNKNOWN, value.type);
+                done_.back() = {node, type, value.size + 1, false};
+                break;
+            }
+        }
+    }
+    IExpression* root = done_.back().node;
+    done_.pop_back();
+    return root;
+}
+
+ConstantFolder::Folded ConstantFolder::foldBinary(BinaryExpression* node, Folded left, Folded right, AstArena& arena) {
+    node->left_ = left.node;
+    node->right_ = right.node;
+    const Token& token = node->operator_token_;
+    TokenType op = token.getType();
+    OperatorKind kind = operatorInfo(op).kind;
+
+    StaticType type = kind == OperatorKind::LOGICAL ? StaticType::BOOLEAN : binaryResultType(op, left.type, right.type);
+    Folded kept{node, type, left.size + right.size + 1, left.pure && right.pure};
+
+    if (kind == OperatorKind::LOGICAL) {
+        bool is_or = isOr(op);
+        bool value;
+        if (isBoolean(left.node, value)) {
+            // Левый операнд решает результат: правый не вычислялся бы вовсе
+            if (value == is_or) return {left.node, StaticType::BOOLEAN, 1, true};
+            // true and x, false or x: результат - x, если x точно bool (иначе нужна ошибка)
+            if (right.type == StaticType::BOOLEAN) return right;
+            return kept;
+        }
+        // x and true, x or false: x вычисляется и проверяется в любом случае
+        if (isBoolean(right.node, value) && value != is_or && left.type == StaticType::BOOLEAN) return left;
+        return kept;
+    }
+
+    if (isLiteral(left.node) && isLiteral(right.node)) {
+        try {
+            Value result = applyBinary(op, literalValue(left.node), literalValue(right.node), token);
+            if (result.isNumber()) return {arena.make<NumericLiteral>(result.asNumber()), StaticType::NUMBER, 1, true};
+            if (result.isBool()) return {arena.make<BooleanLiteral>(result.asBool()), StaticType::BOOLEAN, 1, true};
+        } catch (const std::runtime_error&) {
+            // Ошибка типов остается ошибкой выполнения
+        }
+        return kept; // Склейка строк сворачивается при выполнении
+    }
+
+    // Тождества для чисел; x должен вычисляться ровно так же, как и раньше (один раз)
+    switch (op) {
+        case TokenType::OPERATOR_MUL:
+            if (left.type == StaticType::NUMBER && isNumber(right.node, 1)) return left;
+            if (right.type == StaticType::NUMBER && isNumber(left.node, 1)) return right;
+            break;
+        case TokenType::OPERATOR_DIV:
+            if (left.type == StaticType::NUMBER && isNumber(right.node, 1)) return left;
+            break;
+        case TokenType::OPERATOR_MINUS:
+            if (left.type == StaticType::NUMBER && isNumber(right.node, 0.0)) return left;
+            break;
+        case TokenType::OPERATOR_POW:
+            // x ** 2 -> x * x: x вычисляется дважды, поэтому только небольшое x без присваиваний
+            if (left.type == StaticType::NUMBER && left.pure && left.size <= kSquareMaxSize && isNumber(right.node, 2)) {
+                Token multiply(TokenType::OPERATOR_MUL, valueTT[static_cast<size_t>(TokenType::OPERATOR_MUL)], token.getLine(), token.getColumn());
+                return {arena.make<BinaryExpression>(left.node, multiply, left.node), StaticType::NUMBER, 2 * left.size + 1, true};
+            }
+            break;
+        default:
+            break;
+    }
+    return kept;
+}
+
+ConstantFolder::Folded ConstantFolder::foldUnary(UnaryExpression* node, Folded operand, AstArena& arena) {
+    node->right_ = operand.node;
+    const Token& token = node->operator_token_;
+    TokenType op = token.getType();
+    StaticType type = isNot(op) ? StaticType::BOOLEAN : StaticType::NUMBER;
+    Folded kept{node, type, operand.size + 1, operand.pure, operand.type};
+
+    if (isLiteral(operand.node)) {
+        try {
+            Value result = applyUnary(op, literalValue(operand.node), token);
+            if (result.isNumber()) return {arena.make<NumericLiteral>(result.asNumber()), StaticType::NUMBER, 1, true};
+            if (result.isBool()) return {arena.make<BooleanLiteral>(result.asBool()), StaticType::BOOLEAN, 1, true};
+        } catch (const std::runtime_error&) {
+            // -"a", not 1: ошибка остается ошибкой выполнения
+        }
+        return kept;
+    }
+
+    // --x -> x, not not x -> x: внутренний оператор проверял тип x, поэтому тождество
+    // допустимо, только если этот тип известен заранее
+    if (operand.node->kind() == ExpressionKind::UNARY && isNot(op) == isNot(static_cast<UnaryExpression*>(operand.node)->operator_token_.getType())
+        && operand.operand == type) {
+        return {static_cast<UnaryExpression*>(operand.node)->right_, type, operand.size - 1, operand.pure};
+    }
+    return kept;
+}
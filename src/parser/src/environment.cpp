@@ -0,0 +1,24 @@
+#include "../include/environment.hpp"
+#include <stdexcept>
+
+void undefinedVariable(std::string_view name, uint32_t line, uint32_t column) {
+    runtimeError(line, column, "Undefined variable '" + std::string(name) + "'");
+}
+
+const Value& Environment::get(uint32_t depth, uint32_t slot, const SymbolTable& symbols, Symbol name, uint32_t line, uint32_t column) const {
+    if (!isDefined(depth, slot)) undefinedVariable(symbols.name(name), line, column);
+    return at(depth).values[slot];
+}
+
+void Environment::assign(uint32_t depth, uint32_t slot, Value value) {
+    if (slot == kNoSlot) {
+        throw std::logic_error("assignment to a variable that was not resolved");
+    }
+    Scope& scope = at(depth);
+    if (slot >= scope.values.size()) {
+        scope.values.resize(slot + 1);
+        scope.defined.resize(slot + 1, 0);
+    }
+    scope.values[slot] = std::move(value);
+    scope.defined[slot] = 1;
+}
@@ -1,12 +1,13 @@
 #include "../include/expression.hpp"
+#include "../include/environment.hpp"
 #include <stdexcept>
+#include <vector>
 
 // --- NumericLiteral ---
-std::string NumericLiteral::accept(AstVisitor& visitor) const {
-    return visitor.visitNumericLiteral(*this);
-}
+NumericLiteral::NumericLiteral(double val) : IExpression(ExpressionKind::NUMERIC), value_(val) {}
 
-NumericLiteral::NumericLiteral(double val) : value_(val) {}
+NumericLiteral::NumericLiteral(const Token& token)
+    : IExpression(ExpressionKind::NUMERIC), value_(token.getNumber()), is_integer_(token.isInteger()), integer_value_(token.getInteger()) {}
 
 Value NumericLiteral::evaluate(Environment& env) const {
     (void)env; 
@@ -14,23 +15,20 @@ Value NumericLiteral::evaluate(Environment& env) const {
 }
 
 // --- StringLiteral ---
-std::string StringLiteral::accept(AstVisitor& visitor) const {
-    return visitor.visitStringLiteral(*this);
-}
+StringLiteral::StringLiteral(std::string_view val)
+    : IExpression(ExpressionKind::STRING), value_(val), string_(InternedString::intern(stringLiteralText(val))) {}
 
-StringLiteral::StringLiteral(std::string val) : value_(std::move(val)) {}
+std::string_view StringLiteral::text() const {
+    return stringLiteralText(value_);
+}
 
 Value StringLiteral::evaluate(Environment& env) const {
     (void)env; 
-    return value_;
+    return string_;
 }
 
 // --- BooleanLiteral ---
-std::string BooleanLiteral::accept(AstVisitor& visitor) const {
-    return visitor.visitBooleanLiteral(*this);
-}
-
-BooleanLiteral::BooleanLiteral(bool val) : value_(val) {}
+BooleanLiteral::BooleanLiteral(bool val) : IExpression(ExpressionKind::BOOLEAN), value_(val) {}
 
 Value BooleanLiteral::evaluate(Environment& env) const {
     (void)env; 
@@ -38,83 +36,174 @@ Value BooleanLiteral::evaluate(Environment& env) const {
 }
 
 // --- IdentifierExpression ---
-std::string IdentifierExpression::accept(AstVisitor& visitor) const {
-    return visitor.visitIdentifierExpression(*this);
-}
-
-IdentifierExpression::IdentifierExpression(Token token) : name_token_(std::move(token)) {}
+IdentifierExpression::IdentifierExpression(const Token& token, const SymbolTable& symbols)
+    : IExpression(ExpressionKind::IDENTIFIER), symbol_(token.getSymbol()), symbols_(&symbols), line_(token.getLine()), column_(token.getColumn()) {}
 
 
 Value IdentifierExpression::evaluate(Environment& env) const {
-    (void)env; 
-    // В реальной реализации здесь будет что-то вроде: return env.get(name_token_.getValue());
-    // Пока что, чтобы код компилировался, вернем какое-нибудь значение по умолчанию или бросим исключение.
-    // Эта заглушка должна быть заменена реальной логикой или четким сообщением об ошибке.
-    // throw std::runtime_error("Environment not implemented for IdentifierExpression: " + getName());
-    return "Identifier_evaluated_placeholder"; 
+    return env.get(depth_, slot_, *symbols_, symbol_, line_, column_);
 }
 
 // --- BinaryExpression ---
-std::string BinaryExpression::accept(AstVisitor& visitor) const {
-    return visitor.visitBinaryExpression(*this);
-}
-
-BinaryExpression::BinaryExpression(std::unique_ptr<IExpression> left, 
-                                 Token op_token, 
-                                 std::unique_ptr<IExpression> right)
-    : left_(std::move(left)), 
-      operator_token_(std::move(op_token)), 
-      right_(std::move(right)) {}
+BinaryExpression::BinaryExpression(IExpression* left, Token op_token, IExpression* right)
+    : IExpression(ExpressionKind::BINARY), left_(left), operator_token_(op_token), right_(right) {}
 
 Value BinaryExpression::evaluate(Environment& env) const {
-    Value left_val = left_->evaluate(env);
-    Value right_val = right_->evaluate(env);
-
-    if (operator_token_.getType() == TokenType::OPERATOR_PLUS) { 
-        if (std::holds_alternative<double>(left_val) && std::holds_alternative<double>(right_val)) {
-            return std::get<double>(left_val) + std::get<double>(right_val);
-        }
-        // TODO: Добавить обработку других типов (например, конкатенация строк, если поддерживается)
-        // TODO: Добавить обработку ошибок типов (например, если пытаемся сложить число и строку без явного приведения)
-        // throw std::runtime_error("Runtime Error: Incomplete binary expression evaluation logic.");
-    }
-    // TODO: Добавить логику для других операторов (MINUS, STAR, SLASH, <, >, ==, etc.)
-    //  - Для каждого оператора нужно будет проверить типы операндов (left_val, right_val)
-    //  - Выполнить операцию
-    //  - Вернуть результат типа Value
-    //  - Обработать возможные ошибки (деление на ноль, несоответствие типов)
-
-    // Временная заглушка / сообщение об ошибке, если оператор не обработан
-    // throw std::runtime_error("Binary operation not (fully) implemented for operator: " + operator_token_.getValue());
-    return "Binary_expression_placeholder"; 
+    return evaluateExpression(*this, env);
 }
 
 // --- UnaryExpression ---
-std::string UnaryExpression::accept(AstVisitor& visitor) const {
-    return visitor.visitUnaryExpression(*this);
+UnaryExpression::UnaryExpression(Token op_token, IExpression* right)
+    : IExpression(ExpressionKind::UNARY), operator_token_(op_token), right_(right) {}
+
+Value UnaryExpression::evaluate(Environment& env) const {
+    return evaluateExpression(*this, env);
 }
 
-UnaryExpression::UnaryExpression(Token op_token, std::unique_ptr<IExpression> right)
-    : operator_token_(std::move(op_token)), right_(std::move(right)) {}
+// --- AssignmentExpression ---
+AssignmentExpression::AssignmentExpression(const IdentifierExpression& target, Token op_token, IExpression* value)
+    : IExpression(ExpressionKind::ASSIGNMENT), symbol_(target.symbol_), symbols_(target.symbols_), operator_token_(op_token), value_(value) {}
 
-Value UnaryExpression::evaluate(Environment& env) const {
-    Value right_val = right_->evaluate(env);
+Value AssignmentExpression::evaluate(Environment& env) const {
+    return evaluateExpression(*this, env);
+}
 
-    switch (operator_token_.getType()) {
-        case TokenType::OPERATOR_NOT:
-            if (std::holds_alternative<bool>(right_val)) {
-                return !std::get<bool>(right_val);
+// --- Обход с явным стеком ---
+// Каждый составной узел попадает в стек дважды: при входе (кладет детей) и при выходе
+// (забирает значения детей со стека значений). Левый операнд and/or вычисляется отдельно:
+// если он уже решает результат, правый операнд не кладется в стек вовсе.
+// Значение общего узла (shared_, см. SubexpressionTable) запоминается при первом вычислении,
+// следующие вхождения берут его без обхода поддерева. Узлы numeric_ (см. TypeInference)
+// считаются над double без проверок типов.
+Value evaluateExpression(const IExpression& root, Environment& env) {
+    enum class Step : uint8_t { ENTER, EXIT, LOGICAL_RIGHT };
+    struct Frame {
+        const IExpression* node;
+        Step step;
+    };
+    // Буферы переиспользуются между вызовами (evaluateExpression не вызывает себя)
+    struct Shared {
+        Value value;
+        bool ready = false;
+    };
+    thread_local std::vector<Frame> frames;
+    thread_local std::vector<Value> values;
+    thread_local std::vector<Shared> shared; // По номеру shared_
+    frames.clear();
+    values.clear();
+    shared.clear();
+    frames.push_back({&root, Step::ENTER});
+
+    // Вхождение общего узла, значение которого уже есть
+    auto cached = [](uint32_t slot) { return slot < shared.size() && shared[slot].ready; };
+    // Значение узла на вершине стека посчитано: общий узел его запоминает
+    auto remember = [](uint32_t slot) {
+        if (slot == kNotShared) return;
+        if (slot >= shared.size()) shared.resize(slot + 1);
+        shared[slot] = {values.back(), true};
+    };
+
+    while (!frames.empty()) {
+        Frame frame = frames.back();
+        frames.pop_back();
+        const IExpression* node = frame.node;
+
+        switch (node->kind()) {
+            case ExpressionKind::NUMERIC:
+                values.emplace_back(static_cast<const NumericLiteral*>(node)->value_);
+                break;
+            case ExpressionKind::STRING:
+                values.emplace_back(static_cast<const StringLiteral*>(node)->string_);
+                break;
+            case ExpressionKind::BOOLEAN:
+                values.emplace_back(static_cast<const BooleanLiteral*>(node)->value_);
+                break;
+            case ExpressionKind::IDENTIFIER: {
+                const IdentifierExpression* id = static_cast<const IdentifierExpression*>(node);
+                values.push_back(env.get(id->depth_, id->slot_, *id->symbols_, id->symbol_, id->line_, id->column_));
+                break;
+            }
+            case ExpressionKind::UNARY: {
+                const UnaryExpression* unary = static_cast<const UnaryExpression*>(node);
+                if (frame.step == Step::ENTER) {
+                    if (cached(unary->shared_)) {
+                        values.push_back(shared[unary->shared_].value);
+                        break;
+                    }
+                    frames.push_back({node, Step::EXIT});
+                    frames.push_back({unary->right_, Step::ENTER});
+                } else if (unary->numeric_) {
+                    values.back() = -values.back().asNumber();
+                    remember(unary->shared_);
+                } else {
+                    values.back() = applyUnary(unary->operator_token_.getType(), values.back(), unary->operator_token_);
+                    remember(unary->shared_);
+                }
+                break;
+            }
+            case ExpressionKind::BINARY: {
+                const BinaryExpression* binary = static_cast<const BinaryExpression*>(node);
+                const Token& op = binary->operator_token_;
+                bool logical = operatorInfo(op.getType()).kind == OperatorKind::LOGICAL;
+                if (frame.step == Step::ENTER) {
+                    if (cached(binary->shared_)) {
+                        values.push_back(shared[binary->shared_].value);
+                        break;
+                    }
+                    if (logical) {
+                        frames.push_back({node, Step::LOGICAL_RIGHT});
+                    } else {
+                        frames.push_back({node, Step::EXIT});
+                        frames.push_back({binary->right_, Step::ENTER});
+                    }
+                    frames.push_back({binary->left_, Step::ENTER});
+                } else if (frame.step == Step::LOGICAL_RIGHT) {
+                    // and/or вычисляются сокращенно: правая часть не вычисляется, если результат уже известен
+                    bool left_true = logicalOperand(values.back(), op);
+                    bool is_or = op.getType() == TokenType::KEYWORD_OR || op.getType() == TokenType::OPERATOR_OR;
+                    if (left_true == is_or) {
+                        values.back() = left_true;
+                        remember(binary->shared_);
+                    } else {
+                        values.pop_back();
+                        frames.push_back({node, Step::EXIT});
+                        frames.push_back({binary->right_, Step::ENTER});
+                    }
+                } else if (logical) {
+                    values.back() = logicalOperand(values.back(), op);
+                    remember(binary->shared_);
+                } else if (binary->numeric_) {
+                    double right = values.back().asNumber();
+                    values.pop_back();
+                    values.back() = applyNumbers(op.getType(), values.back().asNumber(), right);
+                    remember(binary->shared_);
+                } else {
+                    Value right = std::move(values.back());
+                    values.pop_back();
+                    if (!applyNumeric(op.getType(), values.back(), right, values.back())) {
+                        values.back() = applyBinary(op.getType(), values.back(), right, op);
+                    }
+                    remember(binary->shared_);
+                }
+                break;
             }
-            // TODO: Добавить номер строки в сообщение об ошибке, если Token::getLine() существует
-            throw std::runtime_error("Runtime Error: Operand for '!' must be a boolean.");
-        case TokenType::OPERATOR_MINUS:
-            if (std::holds_alternative<double>(right_val)) {
-                return -std::get<double>(right_val);
+            case ExpressionKind::ASSIGNMENT: {
+                const AssignmentExpression* assign = static_cast<const AssignmentExpression*>(node);
+                if (frame.step == Step::ENTER) {
+                    frames.push_back({node, Step::EXIT});
+                    frames.push_back({assign->value_, Step::ENTER});
+                    break;
+                }
+                const Token& op = assign->operator_token_;
+                if (op.getType() != TokenType::OPERATOR_ASSIGN) {
+                    // Составное присваивание: x += v означает x = x + v, x должен быть определен
+                    const Value& current = env.get(assign->depth_, assign->slot_, *assign->symbols_, assign->symbol_, op.getLine(), op.getColumn());
+                    values.back() = applyBinary(compoundBaseOperator(op.getType()), current, values.back(), op);
+                }
+                env.assign(assign->depth_, assign->slot_, values.back());
+                break;
             }
-            // TODO: Добавить номер строки в сообщение об ошибке, если Token::getLine() существует
-            throw std::runtime_error("Runtime Error: Operand for unary '-' must be a number.");
-        default:
-            // TODO: Добавить номер строки в сообщение об ошибке, если Token::getLine() существует
-            throw std::runtime_error("Runtime Error: Unknown unary operator '" + operator_token_.getValue() + "'.");
+        }
     }
-}
\ No newline at end of file
+    return std::move(values.back());
+}
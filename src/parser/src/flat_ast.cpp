@@ -0,0 +1,209 @@
+#include "../include/flat_ast.hpp"
+#include "../include/expression.hpp"
+#include "../include/ast_visitor.hpp"
+#include "../include/operator_table.hpp"
+#include <bit>
+
+double FlatAst::number(NodeIndex node) const {
+    if (ops_[node] == FlatOp::INTEGER) return static_cast<double>(integer(node));
+    return std::bit_cast<double>(operands_[node]);
+}
+
+std::string_view FlatAst::string(NodeIndex node) const {
+    uint64_t operand = operands_[node];
+    return std::string_view(strings_).substr(operand >> 32, operand & 0xFFFFFFFFu);
+}
+
+NodeIndex FlatAst::add(FlatOp op, TokenType op_type, NodeIndex lhs, NodeIndex rhs, uint64_t operand, uint32_t line, uint32_t column) {
+    NodeIndex node = static_cast<NodeIndex>(ops_.size());
+    ops_.push_back(op);
+    operators_.push_back(op_type);
+    lhs_.push_back(lhs);
+    rhs_.push_back(rhs);
+    operands_.push_back(operand);
+    lines_.push_back(line);
+    columns_.push_back(column);
+    return node;
+}
+
+uint64_t FlatAst::storeString(std::string_view text) {
+    uint64_t offset = strings_.size();
+    strings_.append(text);
+    return offset << 32 | text.size();
+}
+
+void FlatAst::addStatement(NodeIndex first, NodeIndex root) {
+    statement_firsts_.push_back(first);
+    statement_roots_.push_back(root);
+}
+
+void FlatAst::reserve(size_t nodes) {
+    ops_.reserve(nodes);
+    operators_.reserve(nodes);
+    lhs_.reserve(nodes);
+    rhs_.reserve(nodes);
+    operands_.reserve(nodes);
+    lines_.reserve(nodes);
+    columns_.reserve(nodes);
+}
+
+void FlatAst::clear() {
+    ops_.clear();
+    operators_.clear();
+    lhs_.clear();
+    rhs_.clear();
+    operands_.clear();
+    lines_.clear();
+    columns_.clear();
+    statement_firsts_.clear();
+    statement_roots_.clear();
+    strings_.clear();
+}
+
+namespace {
+
+uint64_t variableOperand(Symbol symbol, uint32_t slot) {
+    return static_cast<uint64_t>(slot) << 32 | symbol;
+}
+
+// Обход дерева в обратном порядке: каждый узел добавляется после своих детей.
+// Обход идет циклом с явным стеком кадров (frames_), поэтому глубина дерева не расходует
+// стек вызовов. visit-методы листьев добавляют узел и возвращают его индекс.
+class FlatLowering : public AstVisitor<FlatLowering, NodeIndex> {
+public:
+    explicit FlatLowering(FlatAst& out) : out_(out) {}
+
+    NodeIndex lower(const IExpression& root) {
+        frames_.push_back({&root, Step::ENTER, kNoNode});
+        while (!frames_.empty()) {
+            Frame frame = frames_.back();
+            frames_.pop_back();
+            const IExpression* node = frame.node;
+
+            switch (node->kind()) {
+                case ExpressionKind::UNARY: {
+                    const UnaryExpression* unary = static_cast<const UnaryExpression*>(node);
+                    if (frame.step == Step::ENTER) {
+                        frames_.push_back({node, Step::EXIT, kNoNode});
+                        frames_.push_back({unary->right_, Step::ENTER, kNoNode});
+                    } else {
+                        const Token& op = unary->operator_token_;
+                        done_.back() = out_.add(FlatOp::UNARY, op.getType(), done_.back(), kNoNode, 0, op.getLine(), op.getColumn());
+                    }
+                    break;
+                }
+                case ExpressionKind::ASSIGNMENT: {
+                    const AssignmentExpression* assign = static_cast<const AssignmentExpression*>(node);
+                    if (frame.step == Step::ENTER) {
+                        frames_.push_back({node, Step::EXIT, kNoNode});
+                        frames_.push_back({assign->value_, Step::ENTER, kNoNode});
+                    } else {
+                        const Token& op = assign->operator_token_;
+                        out_.setSymbolTable(*assign->symbols_);
+                        done_.back() = out_.add(FlatOp::ASSIGN, op.getType(), done_.back(), kNoNode, variableOperand(assign->symbol_, assign->slot_), op.getLine(), op.getColumn());
+                    }
+                    break;
+                }
+                case ExpressionKind::BINARY: {
+                    const BinaryExpression* binary = static_cast<const BinaryExpression*>(node);
+                    const Token& op = binary->operator_token_;
+                    bool logical = operatorInfo(op.getType()).kind == OperatorKind::LOGICAL;
+                    if (frame.step == Step::ENTER) {
+                        if (logical) {
+                            frames_.push_back({node, Step::LOGICAL_TEST, kNoNode});
+                        } else {
+                            frames_.push_back({node, Step::EXIT, kNoNode});
+                            frames_.push_back({binary->right_, Step::ENTER, kNoNode});
+                        }
+                        frames_.push_back({binary->left_, Step::ENTER, kNoNode});
+                    } else if (frame.step == Step::LOGICAL_TEST) {
+                        // [левый операнд] LOGICAL_TEST [правый операнд] LOGICAL
+                        NodeIndex test = out_.add(FlatOp::LOGICAL_TEST, op.getType(), done_.back(), kNoNode, 0, op.getLine(), op.getColumn());
+                        frames_.push_back({node, Step::EXIT, test});
+                        frames_.push_back({binary->right_, Step::ENTER, kNoNode});
+                    } else {
+                        NodeIndex right = done_.back();
+                        done_.pop_back();
+                        NodeIndex left = done_.back();
+                        done_.back() = out_.add(logical ? FlatOp::LOGICAL : FlatOp::BINARY, op.getType(), left, right, 0, op.getLine(), op.getColumn());
+                        if (logical) out_.setRhs(frame.test, done_.back());
+                    }
+                    break;
+                }
+                default: // Листья
+                    done_.push_back(visit(*node));
+                    break;
+            }
+        }
+        NodeIndex root_index = done_.back();
+        done_.pop_back();
+        return root_index;
+    }
+
+    NodeIndex visitNumericLiteral(const NumericLiteral& expr) {
+        if (expr.is_integer_) {
+            return out_.add(FlatOp::INTEGER, TokenType::CONSTANT_NUM, kNoNode, kNoNode, static_cast<uint64_t>(expr.integer_value_));
+        }
+        return out_.add(FlatOp::NUMBER, TokenType::CONSTANT_NUM, kNoNode, kNoNode, std::bit_cast<uint64_t>(expr.value_));
+    }
+
+    NodeIndex visitStringLiteral(const StringLiteral& expr) {
+        return out_.add(FlatOp::STRING, TokenType::CONSTANT_STRING, kNoNode, kNoNode, out_.storeString(expr.value_));
+    }
+
+    NodeIndex visitBooleanLiteral(const BooleanLiteral& expr) {
+        TokenType type = expr.value_ ? TokenType::KEYWORD_TRUE : TokenType::KEYWORD_FALSE;
+        return out_.add(FlatOp::BOOLEAN, type, kNoNode, kNoNode, expr.value_ ? 1 : 0);
+    }
+
+    NodeIndex visitIdentifierExpression(const IdentifierExpression& expr) {
+        out_.setSymbolTable(*expr.symbols_);
+        return out_.add(FlatOp::IDENTIFIER, TokenType::IDENTIFIER, kNoNode, kNoNode, variableOperand(expr.symbol_, expr.slot_), expr.line_, expr.column_);
+    }
+
+    // Составные узлы разбирает lower()
+    NodeIndex visitBinaryExpression(const BinaryExpression& expr) {
+        return lower(expr);
+    }
+
+    NodeIndex visitUnaryExpression(const UnaryExpression& expr) {
+        return lower(expr);
+    }
+
+    NodeIndex visitAssignmentExpression(const AssignmentExpression& expr) {
+        return lower(expr);
+    }
+
+    NodeIndex visitExpressionStatement(const ExpressionStatement& stmt) {
+        NodeIndex first = static_cast<NodeIndex>(out_.size());
+        NodeIndex root = lower(*stmt.expression_);
+        out_.addStatement(first, root);
+        return root;
+    }
+
+private:
+    enum class Step : uint8_t { ENTER, LOGICAL_TEST, EXIT };
+    struct Frame {
+        const IExpression* node;
+        Step step;
+        NodeIndex test; // EXIT для and/or: узел LOGICAL_TEST, которому нужен индекс LOGICAL
+    };
+
+    FlatAst& out_;
+    std::vector<Frame> frames_;
+    std::vector<NodeIndex> done_; // Индексы уже добавленных детей
+};
+
+} // namespace
+
+void lowerToFlat(const std::vector<IStatement*>& statements, FlatAst& out) {
+    FlatLowering lowering(out);
+    for (const IStatement* stmt : statements) {
+        if (stmt) lowering.visit(*stmt);
+    }
+}
+
+void lowerToFlat(const IStatement& statement, FlatAst& out) {
+    FlatLowering lowering(out);
+    lowering.visit(statement);
+}
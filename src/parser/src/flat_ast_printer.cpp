@@ -0,0 +1,93 @@
+#include "../include/flat_ast_printer.hpp"
+#include "../include/value.hpp"
+
+std::string FlatAstPrinter::print(const FlatAst& ast) {
+    out_.clear();
+    for (size_t i = 0; i < ast.statementCount(); i++) {
+        out_.append("[ExpressionStatement:\n");
+        level_ = 1;
+        printNode(ast, ast.statementRoot(i));
+        out_.append("\n]\n");
+    }
+    return std::move(out_);
+}
+
+// Прямой порядок по массиву в обратном польском порядке: явный стек вместо рекурсии,
+// поэтому глубина дерева не расходует стек вызовов
+void FlatAstPrinter::printNode(const FlatAst& ast, NodeIndex root) {
+    stack_.clear();
+    stack_.push_back(root);
+    bool first = true;
+    while (!stack_.empty()) {
+        NodeIndex node = stack_.back();
+        stack_.pop_back();
+        if (!first) out_.push_back('\n');
+        first = false;
+        if (node == kNoNode) {
+            indent(level_);
+            out_.push_back(']');
+            continue;
+        }
+        ast.accept(node, *this); // Лист целиком или заголовок составного узла
+        switch (ast.op(node)) {
+            case FlatOp::UNARY:
+            case FlatOp::ASSIGN:
+                stack_.push_back(kNoNode);
+                stack_.push_back(ast.lhs(node));
+                break;
+            case FlatOp::BINARY:
+            case FlatOp::LOGICAL:
+                stack_.push_back(kNoNode);
+                stack_.push_back(ast.rhs(node));
+                stack_.push_back(ast.lhs(node));
+                break;
+            default:
+                break;
+        }
+    }
+}
+
+void FlatAstPrinter::leaf(std::string_view text) {
+    indent(level_ + 1);
+    out_.append(text);
+}
+
+void FlatAstPrinter::open(std::string_view name, std::string_view detail) {
+    indent(level_);
+    out_.append("[").append(name).append(detail);
+}
+
+void FlatAstPrinter::visitNumber(const FlatAst& ast, NodeIndex node) {
+    indent(level_ + 1);
+    out_.append("[Numeric: ");
+    out_.append(ast.op(node) == FlatOp::INTEGER ? std::to_string(ast.integer(node)) : formatNumber(ast.number(node)));
+    out_.push_back(']');
+}
+
+void FlatAstPrinter::visitString(const FlatAst& ast, NodeIndex node) {
+    leaf("[String: \"");
+    out_.append(ast.string(node)).append("\"]");
+}
+
+void FlatAstPrinter::visitBoolean(const FlatAst& ast, NodeIndex node) {
+    leaf(ast.boolean(node) ? "[Boolean: true]" : "[Boolean: false]");
+}
+
+void FlatAstPrinter::visitIdentifier(const FlatAst& ast, NodeIndex node) {
+    leaf("[Identifier: ");
+    out_.append(ast.symbols().name(ast.symbol(node))).push_back(']');
+}
+
+void FlatAstPrinter::visitUnary(const FlatAst& ast, NodeIndex node) {
+    open("Unary: ", valueTT[static_cast<size_t>(ast.operatorType(node))]);
+}
+
+void FlatAstPrinter::visitBinary(const FlatAst& ast, NodeIndex node) {
+    open("Binary: ", valueTT[static_cast<size_t>(ast.operatorType(node))]);
+}
+
+void FlatAstPrinter::visitAssign(const FlatAst& ast, NodeIndex node) {
+    open("Assign: ", valueTT[static_cast<size_t>(ast.operatorType(node))]);
+    out_.push_back(' ');
+    out_.append(ast.symbols().name(ast.symbol(node)));
+}
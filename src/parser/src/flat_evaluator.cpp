@@ -0,0 +1,67 @@
+#include "../include/flat_evaluator.hpp"
+#include "../include/operator_table.hpp"
+
+Value FlatEvaluator::evaluateStatement(const FlatAst& ast, size_t i) {
+    stack_.clear();
+    NodeIndex root = ast.statementRoot(i);
+    for (NodeIndex node = ast.statementFirst(i); node <= root; node++) {
+        switch (ast.op(node)) {
+            case FlatOp::NUMBER:
+            case FlatOp::INTEGER:
+                stack_.emplace_back(ast.number(node));
+                break;
+            case FlatOp::STRING:
+                stack_.emplace_back(stringLiteralText(ast.string(node)));
+                break;
+            case FlatOp::BOOLEAN:
+                stack_.emplace_back(ast.boolean(node));
+                break;
+            case FlatOp::IDENTIFIER:
+                stack_.push_back(env_.get(0, ast.slot(node), ast.symbols(), ast.symbol(node), ast.line(node), ast.column(node)));
+                break;
+            case FlatOp::UNARY:
+                stack_.back() = applyUnary(ast.operatorType(node), stack_.back(), ast.operatorToken(node));
+                break;
+            case FlatOp::BINARY: {
+                Value right = std::move(stack_.back());
+                stack_.pop_back();
+                if (!applyNumeric(ast.operatorType(node), stack_.back(), right, stack_.back())) {
+                    stack_.back() = applyBinary(ast.operatorType(node), stack_.back(), right, ast.operatorToken(node));
+                }
+                break;
+            }
+            case FlatOp::LOGICAL_TEST: {
+                // Левый операнд на вершине стека: если он решает результат, правый пропускается
+                TokenType op = ast.operatorType(node);
+                bool left = logicalOperand(stack_.back(), ast.operatorToken(node));
+                bool is_or = op == TokenType::KEYWORD_OR || op == TokenType::OPERATOR_OR;
+                if (left == is_or) {
+                    stack_.back() = left;
+                    node = ast.rhs(node); // LOGICAL, цикл продолжится после него
+                } else {
+                    stack_.pop_back();
+                }
+                break;
+            }
+            case FlatOp::LOGICAL:
+                stack_.back() = logicalOperand(stack_.back(), ast.operatorToken(node));
+                break;
+            case FlatOp::ASSIGN: {
+                TokenType op = ast.operatorType(node);
+                if (op != TokenType::OPERATOR_ASSIGN) {
+                    const Value& current = env_.get(0, ast.slot(node), ast.symbols(), ast.symbol(node), ast.line(node), ast.column(node));
+                    stack_.back() = applyBinary(compoundBaseOperator(op), current, stack_.back(), ast.operatorToken(node));
+                }
+                env_.assign(0, ast.slot(node), stack_.back());
+                break;
+            }
+        }
+    }
+    return std::move(stack_.back());
+}
+
+Value FlatEvaluator::run(const FlatAst& ast) {
+    Value last;
+    for (size_t i = 0; i < ast.statementCount(); i++) last = evaluateStatement(ast, i);
+    return last;
+}
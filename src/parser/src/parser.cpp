@@ -1,67 +1,76 @@
 #include "../include/parser.hpp"
 #include "../include/expression.hpp" // Для NumericLiteral, StringLiteral, BooleanLiteral, IdentifierExpression, BinaryExpression
 #include "../include/statement.hpp"  // Для ExpressionStatement
-#include <stdexcept> // Для std::stod исключений
+#include <stdexcept>
 #include <iostream>  // Для временной отладки
 
 // --- Конструктор --- 
-Parser::Parser(const std::vector<Token>& tokens)
-    : tokens_(tokens), currentTokenIndex_(0) {}
-
-// --- Основной метод парсинга --- 
-std::vector<std::unique_ptr<IStatement>> Parser::parse() {
-    std::vector<std::unique_ptr<IStatement>> statements;
-    while (!isAtEnd()) {
-        // Сначала пропускаем все EOL, которые не являются частью синтаксиса (например, пустые строки)
-        while (check(TokenType::EOL)) { // Используем while для пропуска нескольких EOL подряд
-            advance();
-        }
+Parser::Parser(const std::vector<Token>& tokens, AstArena& arena, const SymbolTable& symbols)
+    : tokens_(&tokens), current_(TokenType::_EOF), previous_(TokenType::_EOF), arena_(arena), subexpressions_(arena) {
+    subexpressions_.setSymbolTable(symbols);
+    current_ = fetch();
+}
 
-        if (isAtEnd()) { // Могли дойти до конца, пропуская EOL
-            break;
-        }
+Parser::Parser(Lexer& lexer, AstArena& arena)
+    : lexer_(&lexer), current_(TokenType::_EOF), previous_(TokenType::_EOF), arena_(arena), subexpressions_(arena) {
+    subexpressions_.setSymbolTable(lexer.symbolTable());
+    current_ = fetch();
+}
 
-        std::unique_ptr<IStatement> stmt = parseDeclaration(); // Используем parseDeclaration как точку входа
-        if (stmt) {
-            statements.push_back(std::move(stmt));
-        } else {
-            // Если parseDeclaration вернул nullptr, и это не EOF (EOL уже пропущены),
-            // то это может быть неожиданный токен.
-            if (!isAtEnd()) { // isAtEnd() также проверяет _EOF
-                // Ошибка: неожиданный токен, который не может начать объявление/инструкцию.
-                // Можно добавить логирование ошибки или вызов synchronize().
-                // std::cerr << "Parser Error: Unexpected token " << peek().toString() << " cannot start a statement." << std::endl;
-                // synchronize(); // Попытка восстановления, если реализована
-                break; // Пока что прерываем парсинг при первой такой ошибке.
-            }
-        }
+// --- Основной метод парсинга --- 
+std::vector<IStatement*> Parser::parse() {
+    std::vector<IStatement*> statements;
+    while (IStatement* stmt = parseNext()) {
+        statements.push_back(stmt);
     }
     return statements;
 }
 
+IStatement* Parser::parseNext() {
+    // Сначала пропускаем все EOL, которые не являются частью синтаксиса (например, пустые строки)
+    while (check(TokenType::EOL)) {
+        advance();
+    }
+    if (isAtEnd() || hasError()) {
+        return nullptr;
+    }
+    // Пока что разбор прерывается на первой ошибке (synchronize() не используется)
+    return parseDeclaration();
+}
+
 // --- Вспомогательные методы для работы с токенами --- 
-Token Parser::advance() {
+// Комментарии не участвуют в грамматике: парсер их не видит (EOL после комментария остается)
+Token Parser::fetch() {
+    if (lexer_) {
+        Token token = lexer_->next();
+        while (token.getType() == TokenType::DELIMETER_COMMENT) token = lexer_->next();
+        return token;
+    }
+    while (nextTokenIndex_ < tokens_->size()) {
+        const Token& token = (*tokens_)[nextTokenIndex_++];
+        if (token.getType() != TokenType::DELIMETER_COMMENT) return token;
+    }
+    return Token(TokenType::_EOF); // Массив без завершающего EOF (например, строка REPL)
+}
+
+const Token& Parser::advance() {
+    previous_ = current_;
     if (!isAtEnd()) {
-        currentTokenIndex_++;
+        current_ = fetch();
     }
-    return previous();
+    return previous_;
 }
 
-Token Parser::peek() const {
-    return tokens_[currentTokenIndex_];
+const Token& Parser::peek() const {
+    return current_;
 }
 
-Token Parser::previous() const {
-    if (currentTokenIndex_ == 0) {
-        // Не должно происходить при правильном использовании, но для безопасности
-        // Можно бросить исключение или вернуть специальный "нулевой" токен
-        throw std::out_of_range("previous() called at the beginning of token stream");
-    }
-    return tokens_[currentTokenIndex_ - 1];
+const Token& Parser::previous() const {
+    return previous_;
 }
 
 bool Parser::isAtEnd() const {
-    return currentTokenIndex_ >= tokens_.size() || peek().getType() == TokenType::_EOF;
+    return current_.getType() == TokenType::_EOF;
 }
 
 bool Parser::check(TokenType type) const {
@@ -69,7 +78,7 @@ bool Parser::check(TokenType type) const {
     return peek().getType() == type;
 }
 
-bool Parser::match(const std::vector<TokenType>& types) {
+bool Parser::match(std::initializer_list<TokenType> types) {
     for (TokenType type : types) {
         if (check(type)) {
             advance();
@@ -80,20 +89,21 @@ bool Parser::match(const std::vector<TokenType>& types) {
 }
 
 // --- Методы для разбора инструкций (Statements) --- 
-std::unique_ptr<IStatement> Parser::parseDeclaration() {
+IStatement* Parser::parseDeclaration() {
     // TODO: Реализовать разбор объявлений (например, var, fun)
     // Если не объявление, то это обычная инструкция
     return parseStatement();
 }
 
-std::unique_ptr<IStatement> Parser::parseStatement() {
+IStatement* Parser::parseStatement() {
     // TODO: Добавить разбор других типов инструкций (if, while, for, print, return, block)
     // Пока что все инструкции - это инструкции-выражения
     return parseExpressionStatement();
 }
 
-std::unique_ptr<IStatement> Parser::parseExpressionStatement() {
-    std::unique_ptr<IExpression> expr = parseExpression();
+IStatement* Parser::parseExpressionStatement() {
+    subexpressions_.reset(); // Узлы объединяются только внутри одной инструкции
+    IExpression* expr = parseExpression();
     if (!expr) {
         // Ошибка при разборе выражения, или это не инструкция-выражение
         return nullptr;
@@ -111,149 +121,135 @@ std::unique_ptr<IStatement> Parser::parseExpressionStatement() {
         // Например, 'print 10 20' - здесь '20' лишний, если не ожидается.
         // Пока что мы это не обрабатываем как ошибку здесь, позволяя внешнему циклу решать.
     }
-    return std::make_unique<ExpressionStatement>(std::move(expr));
+    ExpressionStatement* statement = arena_.make<ExpressionStatement>(expr);
+    statement->shared_ = subexpressions_.sharedCount();
+    return statement;
 }
 
 // --- Методы для разбора выражений (Expressions) --- 
-std::unique_ptr<IExpression> Parser::parseExpression() {
-    return parseAssignment(); // Начинаем с самого низкого приоритета (присваивание)
-}
-
-std::unique_ptr<IExpression> Parser::parseAssignment() {
-    std::unique_ptr<IExpression> expr = parseLogicalOr(); // Следующий уровень приоритета
-    // TODO: Реализовать логику присваивания, если TokenType::EQUAL и expr - это l-value
-    // if (match({TokenType::EQUAL})) { ... }
-    return expr; 
-}
-
-std::unique_ptr<IExpression> Parser::parseLogicalOr() {
-    std::unique_ptr<IExpression> expr = parseLogicalAnd();
-    // TODO: while (match({TokenType::OR_OPERATOR})) { ... }
-    return expr;
-}
-
-std::unique_ptr<IExpression> Parser::parseLogicalAnd() {
-    std::unique_ptr<IExpression> expr = parseEquality();
-    // TODO: while (match({TokenType::AND_OPERATOR})) { ... }
-    return expr;
-}
-
-std::unique_ptr<IExpression> Parser::parseEquality() {
-    std::unique_ptr<IExpression> expr = parseComparison();
-    while (match({TokenType::OPERATOR_NE, TokenType::OPERATOR_EQ})) {
-        Token op_token = previous();
-        std::unique_ptr<IExpression> right = parseComparison();
-        if (!right) return nullptr; // Ошибка разбора правой части
-        expr = std::make_unique<BinaryExpression>(std::move(expr), op_token, std::move(right));
-    }
-    return expr;
-}
-
-std::unique_ptr<IExpression> Parser::parseComparison() {
-    std::unique_ptr<IExpression> expr = parseTerm();
-    while (match({TokenType::OPERATOR_GT, TokenType::OPERATOR_GE, TokenType::OPERATOR_LT, TokenType::OPERATOR_LE})) {
-        Token op_token = previous();
-        std::unique_ptr<IExpression> right = parseTerm();
-        if (!right) return nullptr;
-        expr = std::make_unique<BinaryExpression>(std::move(expr), op_token, std::move(right));
-    }
-    return expr;
-}
-
-std::unique_ptr<IExpression> Parser::parseTerm() {
-    std::unique_ptr<IExpression> expr = parseFactor();
-    while (match({TokenType::OPERATOR_MINUS, TokenType::OPERATOR_PLUS})) {
-        Token op_token = previous();
-        std::unique_ptr<IExpression> right = parseFactor();
-        if (!right) return nullptr;
-        expr = std::make_unique<BinaryExpression>(std::move(expr), op_token, std::move(right));
-    }
-    return expr;
-}
-
-std::unique_ptr<IExpression> Parser::parseFactor() {
-    std::unique_ptr<IExpression> expr = parseUnary();
-    while (match({TokenType::OPERATOR_DIV, TokenType::OPERATOR_MUL})) {
-        Token op_token = previous();
-        std::unique_ptr<IExpression> right = parseUnary();
-        if (!right) return nullptr;
-        expr = std::make_unique<BinaryExpression>(std::move(expr), op_token, std::move(right));
-    }
-    return expr;
-}
-
-std::unique_ptr<IExpression> Parser::parseUnary() {
-    if (match({TokenType::OPERATOR_NOT, TokenType::OPERATOR_MINUS})) {
-        Token op_token = previous();
-        std::unique_ptr<IExpression> right = parseUnary();
-        if (!right) return nullptr;
-        return std::make_unique<UnaryExpression>(op_token, std::move(right));
+IExpression* Parser::parseExpression() {
+    return parseBinary(Precedence::NONE); // Начинаем с самого низкого приоритета (присваивание)
+}
+
+// Разбирает префиксные операторы и первичное выражение, затем поглощает инфиксные операторы,
+// пока они связывают сильнее min_precedence. Правый операнд левоассоциативного оператора
+// разбирается с его собственным приоритетом, правоассоциативного (**, присваивание) - на
+// уровень ниже, чтобы такой же оператор справа вошел в правый операнд.
+//
+// Рекурсии нет: вместо вложенного вызова для операнда префиксного оператора, правой части
+// инфиксного и выражения в скобках в pending_ кладется кадр с тем, что нужно сделать, когда
+// операнд будет разобран. Глубина вложенности стоит только памяти в куче, а не стека.
+IExpression* Parser::parseBinary(Precedence min_precedence) {
+    const size_t base = pending_.size(); // Кадры ниже base принадлежат не этому вызову
+    Precedence min = min_precedence;     // Порог текущего (вложенного) уровня
+    IExpression* left = nullptr;
+
+    for (;;) {
+        // Начало операнда: префиксные операторы и открывающие скобки откладываются
+        for (;;) {
+            const OperatorInfo& prefix = operatorInfo(isAtEnd() ? TokenType::_EOF : peek().getType());
+            if (prefix.prefix != Precedence::NONE) {
+                pending_.push_back({PendingKind::PREFIX, min, nullptr, advance()});
+                min = prefix.prefix;
+            } else if (check(TokenType::DELIMITER_LBRACKET)) {
+                pending_.push_back({PendingKind::GROUP, min, nullptr, advance()});
+                min = Precedence::NONE;
+            } else {
+                break;
+            }
+        }
+        left = parsePrimary();
+        if (!left) break;
+
+        // Инфиксные операторы; уровень закончен - достраиваем узел из его кадра
+        for (;;) {
+            const OperatorInfo& info = operatorInfo(isAtEnd() ? TokenType::_EOF : peek().getType());
+            if (info.infix > min) {
+                pending_.push_back({PendingKind::INFIX, min, left, advance()});
+                if (info.kind == OperatorKind::LOGICAL) {
+                    subexpressions_.enterBranch();
+                } else if (info.kind == OperatorKind::ASSIGN && left->kind() == ExpressionKind::IDENTIFIER) {
+                    // Чтения x в правой части не должны совпасть с целью: у нее другая позиция
+                    subexpressions_.assigned(static_cast<IdentifierExpression*>(left)->symbol_);
+                }
+                min = info.assoc == Assoc::LEFT
+                    ? info.infix
+                    : static_cast<Precedence>(static_cast<uint8_t>(info.infix) - 1);
+                break; // Разбираем правый операнд
+            }
+            if (pending_.size() == base) {
+                return left;
+            }
+            Pending frame = pending_.back();
+            pending_.pop_back();
+            min = frame.min;
+            if (frame.kind == PendingKind::PREFIX) {
+                left = subexpressions_.unary(frame.op_token, left);
+            } else if (frame.kind == PendingKind::GROUP) {
+                if (!match({TokenType::DELIMITER_RBRACKET})) {
+                    error(peek(), "expected ')' after expression");
+                    left = nullptr;
+                    break;
+                }
+                // TODO: Можно добавить GroupingExpression, если нужно его явно представлять в AST
+            } else if (operatorInfo(frame.op_token.getType()).kind == OperatorKind::ASSIGN) {
+                if (frame.left->kind() != ExpressionKind::IDENTIFIER) {
+                    error(frame.op_token, "invalid assignment target");
+                    left = nullptr;
+                    break;
+                }
+                AssignmentExpression* assign = arena_.make<AssignmentExpression>(static_cast<const IdentifierExpression&>(*frame.left), frame.op_token, left);
+                subexpressions_.assigned(assign->symbol_);
+                left = assign;
+            } else {
+                if (operatorInfo(frame.op_token.getType()).kind == OperatorKind::LOGICAL) subexpressions_.leaveBranch();
+                left = subexpressions_.binary(frame.left, frame.op_token, left);
+            }
+        }
+        if (!left) break;
     }
-    return parsePrimary();
+    pending_.erase(pending_.begin() + static_cast<std::ptrdiff_t>(base), pending_.end()); // Ошибка: отложенные узлы уже не понадобятся
+    return nullptr;
 }
 
-std::unique_ptr<IExpression> Parser::parsePrimary() {
-    if (match({TokenType::KEYWORD_FALSE})) return std::make_unique<BooleanLiteral>(false);
-    if (match({TokenType::KEYWORD_TRUE})) return std::make_unique<BooleanLiteral>(true);
-    // if (match({TokenType::NIL_KEYWORD})) return std::make_unique<NilLiteral>(); // Если будет Nil
+IExpression* Parser::parsePrimary() {
+    if (match({TokenType::KEYWORD_FALSE})) return subexpressions_.boolean(false);
+    if (match({TokenType::KEYWORD_TRUE})) return subexpressions_.boolean(true);
 
     if (match({TokenType::CONSTANT_NUM})) {
-        try {
-            double value = std::stod(previous().getValue());
-            return std::make_unique<NumericLiteral>(value);
-        } catch (const std::invalid_argument& ia) {
-            // std::cerr << "Invalid number format: " << previous().getValue() << std::endl;
-            return nullptr;
-        } catch (const std::out_of_range& oor) {
-            // std::cerr << "Number out of range: " << previous().getValue() << std::endl;
-            return nullptr;
-        }
+        // Значение уже разобрано лексером
+        return subexpressions_.number(previous());
     }
 
     if (match({TokenType::CONSTANT_STRING})) {
-        return std::make_unique<StringLiteral>(previous().getValue());
+        return arena_.make<StringLiteral>(arena_.copy(previous().getValue()));
     }
 
     if (match({TokenType::IDENTIFIER})) {
-        return std::make_unique<IdentifierExpression>(previous());
+        return subexpressions_.identifier(previous());
     }
 
-    if (match({TokenType::DELIMITER_LBRACKET})) {
-        std::unique_ptr<IExpression> expr = parseExpression();
-        if (!match({TokenType::DELIMITER_RBRACKET})) {
-            // std::cerr << "Error: Expect ')' after expression." << std::endl;
-            return nullptr; // Ошибка: не найдена закрывающая скобка
-        }
-        // TODO: Можно добавить GroupingExpression, если нужно его явно представлять в AST
-        return expr; 
-    }
-    
+    // Скобки разбирает parseBinary (без рекурсии)
+
     // Если ни одно из правил не сработало
-    // std::cerr << "Error: Expect expression, got token: " << peek().toString() << std::endl;
+    if (check(TokenType::ERROR)) {
+        // Ошибка лексера (например, число вне диапазона) доходит до парсера как ERROR токен
+        LexError lex_error = peek().getError();
+        error(peek(), lex_error != LexError::NONE ? lexErrorMessage[static_cast<int>(lex_error)] : "unexpected input");
+    } else if (!isAtEnd() && !check(TokenType::EOL)) {
+        error(peek(), "expected expression");
+    } else {
+        error(peek(), "unexpected end of expression");
+    }
     return nullptr;
 }
 
-// --- Вспомогательные методы для ошибок и синхронизации --- 
-void Parser::synchronize() {
-    advance(); // Пропускаем токен, вызвавший ошибку
-
-    while (!isAtEnd()) {
-        if (previous().getType() == TokenType::DELIMITER_SEMICOLON) return; // Точка с запятой часто хороший разделитель
-
-        switch (peek().getType()) {
-            // Ключевые слова, которые обычно начинают новые инструкции/объявления
-            // case TokenType::CLASS_KEYWORD:
-            // case TokenType::FUN_KEYWORD:
-            // case TokenType::VAR_KEYWORD:
-            // case TokenType::FOR_KEYWORD:
-            // case TokenType::IF_KEYWORD:
-            // case TokenType::WHILE_KEYWORD:
-            // case TokenType::PRINT_KEYWORD: // Если есть
-            // case TokenType::RETURN_KEYWORD:
-            //     return;
-            default:;
-                // Ничего не делаем, просто пропускаем
-        }
-        advance();
+// --- Ошибки --- 
+void Parser::error(const Token& token, std::string_view message) {
+    std::string text = std::to_string(token.getLine()) + ":" + std::to_string(token.getColumn()) + ": ";
+    text.append(message);
+    if (token.getType() != TokenType::_EOF && token.getType() != TokenType::EOL) {
+        text.append(" near '").append(token.getValue()).append("'");
     }
-}
\ No newline at end of file
+    errors_.push_back(std::move(text));
+}
@@ -0,0 +1,61 @@
+#include "../include/resolver.hpp"
+
+void Resolver::resolve(IStatement& statement) {
+    switch (statement.kind()) {
+        case StatementKind::EXPRESSION: {
+            ExpressionStatement& expression_statement = static_cast<ExpressionStatement&>(statement);
+            if (expression_statement.expression_) resolve(*expression_statement.expression_);
+            break;
+        }
+    }
+}
+
+void Resolver::resolve(IExpression& expression) {
+    // Порядок обхода не важен для связывания: присваивание и чтение одного имени в одной
+    // области получают один слот независимо от того, что встретилось раньше
+    stack_.push_back(&expression);
+    while (!stack_.empty()) {
+        IExpression* node = stack_.back();
+        stack_.pop_back();
+        switch (node->kind()) {
+            case ExpressionKind::IDENTIFIER: {
+                IdentifierExpression* id = static_cast<IdentifierExpression*>(node);
+                bind(id->symbol_, id->depth_, id->slot_);
+                break;
+            }
+            case ExpressionKind::ASSIGNMENT: {
+                AssignmentExpression* assign = static_cast<AssignmentExpression*>(node);
+                bind(assign->symbol_, assign->depth_, assign->slot_);
+                stack_.push_back(assign->value_);
+                break;
+            }
+            case ExpressionKind::BINARY: {
+                BinaryExpression* binary = static_cast<BinaryExpression*>(node);
+                stack_.push_back(binary->right_);
+                stack_.push_back(binary->left_);
+                break;
+            }
+            case ExpressionKind::UNARY:
+                stack_.push_back(static_cast<UnaryExpression*>(node)->right_);
+                break;
+            default: // Литералы
+                break;
+        }
+    }
+}
+
+void Resolver::bind(Symbol name, uint32_t& depth, uint32_t& slot) {
+    for (size_t i = scopes_.size(); i-- > 0;) {
+        const Scope& scope = scopes_[i];
+        if (name < scope.slots.size() && scope.slots[name] != kNoSlot) {
+            depth = static_cast<uint32_t>(scopes_.size() - 1 - i);
+            slot = scope.slots[name];
+            return;
+        }
+    }
+    Scope& current = scopes_.back();
+    if (name >= current.slots.size()) current.slots.resize(name + 1, kNoSlot);
+    current.slots[name] = current.count++;
+    depth = 0;
+    slot = current.slots[name];
+}
@@ -1,14 +1,10 @@
 #include "../include/statement.hpp"
 
 // --- ExpressionStatement ---
-std::string ExpressionStatement::accept(AstVisitor& visitor) const {
-    return visitor.visitExpressionStatement(*this);
-}
-
 // #include "../include/environment.hpp" // Раскомментировать, когда Environment будет готов
 
-ExpressionStatement::ExpressionStatement(std::unique_ptr<IExpression> expr)
-    : expression_(std::move(expr)) {}
+ExpressionStatement::ExpressionStatement(IExpression* expr)
+    : IStatement(StatementKind::EXPRESSION), expression_(expr) {}
 
 void ExpressionStatement::execute(Environment& env) const {
     // Просто вычисляем выражение. Результат игнорируется, 
@@ -0,0 +1,145 @@
+#include "../include/subexpression_table.hpp"
+#include <bit>
+
+namespace {
+
+uint32_t tagOf(ExpressionKind kind, TokenType op = TokenType::_EOF) {
+    return static_cast<uint32_t>(kind) << 16 | static_cast<uint32_t>(op);
+}
+
+uint64_t address(const IExpression* node) {
+    return reinterpret_cast<uintptr_t>(node);
+}
+
+} // namespace
+
+void SubexpressionTable::reset() {
+    if (++statement_ == 0) { // Номера кончились: все записи считаем устаревшими заново
+        entries_.assign(entries_.size(), Entry{});
+        statement_ = 1;
+    }
+    count_ = 0;
+    shared_count_ = 0;
+    live_branches_.assign(1, 1); // Ветвь 0 - вся инструкция
+    branches_.assign(1, 0);
+}
+
+bool SubexpressionTable::visible(const Entry& entry) const {
+    return entry.statement == statement_ && live_branches_[entry.branch];
+}
+
+SubexpressionTable::Entry& SubexpressionTable::find(const Key& key) {
+    uint64_t hash = key.first * 0x9E3779B97F4A7C15ull ^ (key.second + key.tag) * 0xC2B2AE3D27D4EB4Full;
+    hash ^= hash >> 32;
+    size_t mask = entries_.size() - 1;
+    Entry* free = nullptr;
+    // Записи закончившихся ветвей не прерывают цепочку (в ней могут быть видимые записи
+    // дальше), но их место можно занять. Цепочка кончается на записи прошлой инструкции.
+    for (size_t i = hash & mask;; i = (i + 1) & mask) {
+        Entry& entry = entries_[i];
+        if (entry.statement != statement_) return free ? *free : entry;
+        if (!live_branches_[entry.branch]) {
+            if (!free) free = &entry;
+        } else if (entry.key == key) {
+            return entry;
+        }
+    }
+}
+
+IExpression* SubexpressionTable::reuse(Entry& entry) {
+    IExpression* node = entry.node;
+    if (node->kind() == ExpressionKind::BINARY) {
+        BinaryExpression* binary = static_cast<BinaryExpression*>(node);
+        if (binary->shared_ == kNotShared) binary->shared_ = shared_count_++;
+    } else if (node->kind() == ExpressionKind::UNARY) {
+        UnaryExpression* unary = static_cast<UnaryExpression*>(node);
+        if (unary->shared_ == kNotShared) unary->shared_ = shared_count_++;
+    }
+    return node;
+}
+
+void SubexpressionTable::insert(Entry& entry, const Key& key, IExpression* node) {
+    if (entry.statement != statement_) count_++; // Запись закончившейся ветви уже посчитана
+    entry = {key, node, statement_, branches_.back()};
+    if (count_ * 2 > entries_.size()) grow();
+}
+
+void SubexpressionTable::grow() {
+    std::vector<Entry> old(entries_.size() * 2);
+    old.swap(entries_);
+    count_ = 0;
+    for (const Entry& entry : old) {
+        if (!visible(entry)) continue;
+        Entry& slot = find(entry.key);
+        slot = entry;
+        count_++;
+    }
+}
+
+IExpression* SubexpressionTable::number(const Token& token) {
+    if (!enabled_) return arena_.make<NumericLiteral>(token);
+    // Целые - по точному значению: у больших целых одинаковый double, но разный текст
+    Key key{token.isInteger() ? static_cast<uint64_t>(token.getInteger()) : std::bit_cast<uint64_t>(token.getNumber()),
+            token.isInteger(), tagOf(ExpressionKind::NUMERIC)};
+    Entry& entry = find(key);
+    if (visible(entry)) return entry.node;
+    IExpression* node = arena_.make<NumericLiteral>(token);
+    insert(entry, key, node);
+    return node;
+}
+
+IExpression* SubexpressionTable::boolean(bool value) {
+    if (!enabled_) return arena_.make<BooleanLiteral>(value);
+    Key key{value, 0, tagOf(ExpressionKind::BOOLEAN)};
+    Entry& entry = find(key);
+    if (visible(entry)) return entry.node;
+    IExpression* node = arena_.make<BooleanLiteral>(value);
+    insert(entry, key, node);
+    return node;
+}
+
+IExpression* SubexpressionTable::identifier(const Token& token) {
+    if (!enabled_) return arena_.make<IdentifierExpression>(token, *symbols_);
+    Symbol name = token.getSymbol();
+    Key key{name, name < versions_.size() ? versions_[name] : 0u, tagOf(ExpressionKind::IDENTIFIER)};
+    Entry& entry = find(key);
+    if (visible(entry)) return entry.node;
+    IExpression* node = arena_.make<IdentifierExpression>(token, *symbols_);
+    insert(entry, key, node);
+    return node;
+}
+
+IExpression* SubexpressionTable::unary(const Token& op_token, IExpression* operand) {
+    if (!enabled_) return arena_.make<UnaryExpression>(op_token, operand);
+    Key key{address(operand), 0, tagOf(ExpressionKind::UNARY, op_token.getType())};
+    Entry& entry = find(key);
+    if (visible(entry)) return reuse(entry);
+    IExpression* node = arena_.make<UnaryExpression>(op_token, operand);
+    insert(entry, key, node);
+    return node;
+}
+
+IExpression* SubexpressionTable::binary(IExpression* left, const Token& op_token, IExpression* right) {
+    if (!enabled_) return arena_.make<BinaryExpression>(left, op_token, right);
+    Key key{address(left), address(right), tagOf(ExpressionKind::BINARY, op_token.getType())};
+    Entry& entry = find(key);
+    if (visible(entry)) return reuse(entry);
+    IExpression* node = arena_.make<BinaryExpression>(left, op_token, right);
+    insert(entry, key, node);
+    return node;
+}
+
+void SubexpressionTable::assigned(Symbol name) {
+    if (name >= versions_.size()) versions_.resize(name + 1, 0);
+    versions_[name]++;
+}
+
+void SubexpressionTable::enterBranch() {
+    branches_.push_back(static_cast<uint32_t>(live_branches_.size()));
+    live_branches_.push_back(1);
+}
+
+void SubexpressionTable::leaveBranch() {
+    live_branches_[branches_.back()] = 0;
+    branches_.pop_back();
+}
@@ -0,0 +1,112 @@
+#include "../include/type_inference.hpp"
+#include "../include/operator_table.hpp"
+
+namespace {
+
+// Тип, подходящий для обоих исходов
+StaticType join(StaticType a, StaticType b) {
+    return a == b ? a : StaticType::UNKNOWN;
+}
+
+} // namespace
+
+StaticType TypeInference::variable(Symbol name) const {
+    return name < variables_.size() ? variables_[name] : StaticType::UNKNOWN;
+}
+
+void TypeInference::assign(Symbol name, StaticType type) {
+    if (name >= variables_.size()) variables_.resize(name + 1, StaticType::UNKNOWN);
+    log_.push_back({name, variables_[name]});
+    variables_[name] = type;
+}
+
+void TypeInference::infer(IStatement& statement) {
+    switch (statement.kind()) {
+        case StatementKind::EXPRESSION: {
+            ExpressionStatement& expression_statement = static_cast<ExpressionStatement&>(statement);
+            if (expression_statement.expression_) infer(*expression_statement.expression_);
+            break;
+        }
+    }
+}
+
+void TypeInference::infer(IExpression& expression) {
+    log_.clear();
+    frames_.push_back({&expression, Step::ENTER, 0});
+    while (!frames_.empty()) {
+        Frame frame = frames_.back();
+        frames_.pop_back();
+        IExpression* node = frame.node;
+
+        switch (node->kind()) {
+            case ExpressionKind::NUMERIC:
+                types_.push_back(StaticType::NUMBER);
+                break;
+            case ExpressionKind::STRING:
+                types_.push_back(StaticType::STRING);
+                break;
+            case ExpressionKind::BOOLEAN:
+                types_.push_back(StaticType::BOOLEAN);
+                break;
+            case ExpressionKind::IDENTIFIER:
+                types_.push_back(variable(static_cast<IdentifierExpression*>(node)->symbol_));
+                break;
+            case ExpressionKind::UNARY: {
+                UnaryExpression* unary = static_cast<UnaryExpression*>(node);
+                if (frame.step == Step::ENTER) {
+                    frames_.push_back({node, Step::EXIT, 0});
+                    frames_.push_back({unary->right_, Step::ENTER, 0});
+                    break;
+                }
+                bool negate = unary->operator_token_.getType() == TokenType::OPERATOR_MINUS;
+                unary->numeric_ = negate && types_.back() == StaticType::NUMBER;
+                types_.back() = negate ? StaticType::NUMBER : StaticType::BOOLEAN;
+                break;
+            }
+            case ExpressionKind::BINARY: {
+                BinaryExpression* binary = static_cast<BinaryExpression*>(node);
+                TokenType op = binary->operator_token_.getType();
+                bool logical = operatorInfo(op).kind == OperatorKind::LOGICAL;
+                if (frame.step == Step::ENTER) {
+                    frames_.push_back({node, logical ? Step::LOGICAL_RIGHT : Step::EXIT, 0});
+                    if (!logical) frames_.push_back({binary->right_, Step::ENTER, 0});
+                    frames_.push_back({binary->left_, Step::ENTER, 0});
+                } else if (frame.step == Step::LOGICAL_RIGHT) {
+                    types_.pop_back(); // Левый операнд: результат and/or - bool в любом случае
+                    frames_.push_back({node, Step::EXIT, static_cast<uint32_t>(log_.size())});
+                    frames_.push_back({binary->right_, Step::ENTER, 0});
+                } else if (logical) {
+                    // Правый операнд мог не вычисляться: его присваивания - лишь один из исходов
+                    for (size_t i = frame.log; i < log_.size(); i++) {
+                        variables_[log_[i].name] = join(variables_[log_[i].name], log_[i].before);
+                    }
+                    binary->numeric_ = false;
+                    types_.back() = StaticType::BOOLEAN;
+                } else {
+                    StaticType right = types_.back();
+                    types_.pop_back();
+                    binary->numeric_ = types_.back() == StaticType::NUMBER && right == StaticType::NUMBER;
+                    types_.back() = binaryResultType(op, types_.back(), right);
+                }
+                break;
+            }
+            case ExpressionKind::ASSIGNMENT: {
+                AssignmentExpression* assign_node = static_cast<AssignmentExpression*>(node);
+                if (frame.step == Step::ENTER) {
+                    frames_.push_back({node, Step::EXIT, 0});
+                    frames_.push_back({assign_node->value_, Step::ENTER, 0});
+                    break;
+                }
+                TokenType op = assign_node->operator_token_.getType();
+                StaticType type = types_.back();
+                if (op != TokenType::OPERATOR_ASSIGN) {
+                    type = binaryResultType(compoundBaseOperator(op), variable(assign_node->symbol_), type);
+                }
+                assign(assign_node->symbol_, type);
+                types_.back() = type;
+                break;
+            }
+        }
+    }
+    types_.clear();
+}
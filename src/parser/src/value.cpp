@@ -0,0 +1,315 @@
+#include "../include/value.hpp"
+#include <cmath>
+#include <charconv>
+#include <atomic>
+#include <cstring>
+#include <mutex>
+#include <stdexcept>
+#include <unordered_map>
+#include <vector>
+
+// --- Строки ---
+
+// Строка в куче. Плоская строка хранит текст в text; rope хранит части left и right, а text
+// заполняется при первом чтении (после этого части отпускаются). Счетчик ссылок атомарный:
+// одну строку могут читать и копировать несколько потоков.
+struct Value::StringObject {
+    std::atomic<uint32_t> refs;
+    std::atomic<bool> flat;
+    size_t length;
+    std::string text;
+    Value left;
+    Value right;
+    StringObject* next_dead = nullptr; // Очередь освобождения в releaseString
+};
+
+namespace {
+
+// Rope строится только для длинных результатов: короткую склейку дешевле сразу скопировать
+constexpr size_t kRopeMinLength = 64;
+
+// Сборка текста rope и таблица интернирования - редкие операции, им хватает одной блокировки
+std::mutex& stringMutex() {
+    static std::mutex mutex;
+    return mutex;
+}
+
+} // namespace
+
+uint64_t Value::shortBits(std::string_view text) {
+    uint64_t bits = kShortTag | (static_cast<uint64_t>(text.size()) << 40);
+    std::memcpy(&bits, text.data(), text.size()); // Младшие байты (little-endian)
+    return bits;
+}
+
+Value::Value(std::string_view text) {
+    if (text.size() <= kShortCapacity) {
+        bits_ = shortBits(text);
+        return;
+    }
+    bits_ = kHeapTag | reinterpret_cast<uint64_t>(new StringObject{{1}, {true}, text.size(), std::string(text), {}, {}});
+}
+
+Value::Value(std::string text) {
+    if (text.size() <= kShortCapacity) {
+        bits_ = shortBits(text);
+        return;
+    }
+    size_t length = text.size();
+    bits_ = kHeapTag | reinterpret_cast<uint64_t>(new StringObject{{1}, {true}, length, std::move(text), {}, {}});
+}
+
+Value::Value(InternedString text) : bits_(text.bits_) {
+    retain();
+}
+
+Value Value::concat(const Value& left, const Value& right) {
+    size_t length = left.stringLength() + right.stringLength();
+    if (length < kRopeMinLength) {
+        // Части короче kRopeMinLength - не rope, их текст уже собран
+        std::string_view l = left.asString();
+        std::string_view r = right.asString();
+        if (length <= kShortCapacity) {
+            char buffer[kShortCapacity];
+            std::memcpy(buffer, l.data(), l.size());
+            std::memcpy(buffer + l.size(), r.data(), r.size());
+            Value result;
+            result.bits_ = shortBits({buffer, length});
+            return result;
+        }
+        std::string text;
+        text.reserve(length);
+        text.append(l).append(r);
+        return Value(std::move(text));
+    }
+    Value result;
+    result.bits_ = kHeapTag | reinterpret_cast<uint64_t>(new StringObject{{1}, {false}, length, {}, left, right});
+    return result;
+}
+
+size_t Value::heapLength() const {
+    return object()->length;
+}
+
+std::string_view Value::heapText() const {
+    StringObject* root = object();
+    if (root->flat.load(std::memory_order_acquire)) return root->text;
+
+    std::lock_guard<std::mutex> lock(stringMutex());
+    if (!root->flat.load(std::memory_order_relaxed)) {
+        // Части rope обходятся слева направо явным стеком: цепочка склеек в цикле может
+        // быть глубиной в миллионы узлов. Уже собранные части копируются целиком.
+        std::string text;
+        text.reserve(root->length);
+        std::vector<const Value*> parts{&root->right, &root->left};
+        while (!parts.empty()) {
+            const Value* part = parts.back();
+            parts.pop_back();
+            if (part->isShort()) {
+                text.append(part->asString());
+                continue;
+            }
+            StringObject* object = part->object();
+            if (object->flat.load(std::memory_order_relaxed)) {
+                text.append(object->text);
+            } else {
+                parts.push_back(&object->right);
+                parts.push_back(&object->left);
+            }
+        }
+        root->text = std::move(text);
+        root->left = Value();
+        root->right = Value();
+        root->flat.store(true, std::memory_order_release);
+    }
+    return root->text;
+}
+
+void Value::retainString() const {
+    object()->refs.fetch_add(1, std::memory_order_relaxed);
+}
+
+void Value::releaseString() {
+    StringObject* dead = object();
+    if (dead->refs.fetch_sub(1, std::memory_order_acq_rel) != 1) return;
+
+    // Освобождение без рекурсии: части rope, у которых это была последняя ссылка, ставятся
+    // в очередь вместо вложенного вызова деструктора
+    dead->next_dead = nullptr;
+    while (dead) {
+        StringObject* object = dead;
+        dead = object->next_dead;
+        for (Value* part : {&object->left, &object->right}) {
+            if (part->isHeap()) {
+                StringObject* child = part->object();
+                if (child->refs.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+                    child->next_dead = dead;
+                    dead = child;
+                }
+            }
+            part->bits_ = 0;
+        }
+        delete object;
+    }
+}
+
+InternedString InternedString::intern(std::string_view text) {
+    InternedString result;
+    if (text.size() <= Value::kShortCapacity) {
+        result.bits_ = Value::shortBits(text);
+        return result;
+    }
+    // Строки таблицы никогда не освобождаются: таблица держит свою ссылку на каждую. Сама
+    // таблица тоже не разрушается при выходе, чтобы литералы оставались верными до конца
+    static auto& table = *new std::unordered_map<std::string_view, Value::StringObject*>();
+    std::lock_guard<std::mutex> lock(stringMutex());
+    auto found = table.find(text);
+    if (found == table.end()) {
+        Value string(text);
+        found = table.emplace(string.object()->text, string.object()).first;
+        string.bits_ = 0; // Ссылка переходит таблице
+    }
+    result.bits_ = Value::kHeapTag | reinterpret_cast<uint64_t>(found->second);
+    return result;
+}
+
+bool operator==(const Value& left, const Value& right) {
+    if (left.isNumber()) return right.isNumber() && left.asNumber() == right.asNumber();
+    if (left.isString()) {
+        if (!right.isString()) return false;
+        if (left.bits_ == right.bits_) return true; // Та же строка (интернированная, короткая, общая)
+        return left.stringLength() == right.stringLength() && left.asString() == right.asString();
+    }
+    return left.bits_ == right.bits_; // bool
+}
+
+void runtimeError(uint32_t line, uint32_t column, std::string_view message) {
+    std::string text = "Runtime Error: " + std::to_string(line) + ":" + std::to_string(column) + ": ";
+    text.append(message);
+    throw std::runtime_error(text);
+}
+
+void runtimeError(const Token& where, std::string_view message) {
+    runtimeError(where.getLine(), where.getColumn(), message);
+}
+
+namespace {
+
+std::string operatorMessage(const Token& where, std::string_view what) {
+    std::string text = "Operands of '";
+    text.append(valueTT[static_cast<size_t>(where.getType())]).append("' ").append(what);
+    return text;
+}
+
+} // namespace
+
+Value applyBinary(TokenType op, const Value& left, const Value& right, const Token& where) {
+    switch (op) {
+        case TokenType::OPERATOR_EQ: return left == right;
+        case TokenType::OPERATOR_NE: return !(left == right);
+        default: break;
+    }
+
+    if (left.isNumber() && right.isNumber()) {
+        double l = left.asNumber();
+        double r = right.asNumber();
+        switch (op) {
+            case TokenType::OPERATOR_PLUS:  return l + r;
+            case TokenType::OPERATOR_MINUS: return l - r;
+            case TokenType::OPERATOR_MUL:   return l * r;
+            case TokenType::OPERATOR_DIV:   return l / r;
+            case TokenType::OPERATOR_MOD:   return std::fmod(l, r);
+            case TokenType::OPERATOR_POW:   return power(l, r);
+            case TokenType::OPERATOR_LT:    return l < r;
+            case TokenType::OPERATOR_LE:    return l <= r;
+            case TokenType::OPERATOR_GT:    return l > r;
+            case TokenType::OPERATOR_GE:    return l >= r;
+            default: break;
+        }
+    }
+
+    if (left.isString() && right.isString()) {
+        if (op == TokenType::OPERATOR_PLUS) return Value::concat(left, right); // Без чтения текста
+        std::string_view ls = left.asString();
+        std::string_view rs = right.asString();
+        switch (op) {
+            case TokenType::OPERATOR_LT:   return ls < rs;
+            case TokenType::OPERATOR_LE:   return ls <= rs;
+            case TokenType::OPERATOR_GT:   return ls > rs;
+            case TokenType::OPERATOR_GE:   return ls >= rs;
+            default: break;
+        }
+    }
+
+    switch (op) {
+        case TokenType::OPERATOR_PLUS:
+        case TokenType::OPERATOR_LT:
+        case TokenType::OPERATOR_LE:
+        case TokenType::OPERATOR_GT:
+        case TokenType::OPERATOR_GE:
+            runtimeError(where, operatorMessage(where, "must be two numbers or two strings"));
+        case TokenType::OPERATOR_MINUS:
+        case TokenType::OPERATOR_MUL:
+        case TokenType::OPERATOR_DIV:
+        case TokenType::OPERATOR_MOD:
+        case TokenType::OPERATOR_POW:
+            runtimeError(where, operatorMessage(where, "must be numbers"));
+        default:
+            runtimeError(where, "Unknown binary operator '" + std::string(where.getValue()) + "'");
+    }
+}
+
+Value applyUnary(TokenType op, const Value& operand, const Token& where) {
+    switch (op) {
+        case TokenType::OPERATOR_NOT:
+        case TokenType::KEYWORD_NOT:
+            if (operand.isBool()) return !operand.asBool();
+            runtimeError(where, "Operand for '" + std::string(where.getValue()) + "' must be a boolean");
+        case TokenType::OPERATOR_MINUS:
+            if (operand.isNumber()) return -operand.asNumber();
+            runtimeError(where, "Operand for unary '-' must be a number");
+        default:
+            runtimeError(where, "Unknown unary operator '" + std::string(where.getValue()) + "'");
+    }
+}
+
+bool logicalOperand(const Value& operand, const Token& where) {
+    if (operand.isBool()) return operand.asBool();
+    runtimeError(where, "Operands of '" + std::string(where.getValue()) + "' must be booleans");
+}
+
+std::string formatNumber(double value) {
+    if (std::isnan(value)) return "nan";
+    if (std::isinf(value)) return value < 0 ? "-inf" : "inf";
+
+    // to_chars дает те же цифры, что и поток с std::fixed/setprecision, но без stringstream
+    char buffer[400]; // Максимальный double в fixed: 309 цифр целой части + точка + 15 знаков
+    double intpart;
+    // Проверяем, является ли число целым (с некоторой точностью для чисел с плавающей запятой)
+    if (std::abs(std::modf(value, &intpart)) < 1e-9 && std::abs(value) < 9.2e18) { // Если дробная часть очень мала
+        char* end = std::to_chars(buffer, buffer + sizeof(buffer), static_cast<long long>(value)).ptr;
+        return std::string(buffer, end);
+    }
+    char* end = std::to_chars(buffer, buffer + sizeof(buffer), value, std::chars_format::fixed, 15).ptr;
+    std::string text(buffer, end);
+    if (text.find('.') != std::string::npos) {
+        text.erase(text.find_last_not_of('0') + 1, std::string::npos);
+        if (!text.empty() && text.back() == '.') text.pop_back();
+    }
+    return text;
+}
+
+std::string_view stringLiteralText(std::string_view token_text) {
+    if (!token_text.empty() && (token_text.front() == '"' || token_text.front() == '\'')) {
+        char quote = token_text.front();
+        token_text.remove_prefix(1);
+        if (!token_text.empty() && token_text.back() == quote) token_text.remove_suffix(1); // Незакрытая строка в конце файла
+    }
+    return token_text;
+}
+
+std::string formatValue(const Value& value) {
+    if (value.isNumber()) return formatNumber(value.asNumber());
+    if (value.isBool()) return value.asBool() ? "true" : "false";
+    return std::string(value.asString());
+}
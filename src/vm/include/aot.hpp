@@ -0,0 +1,53 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+// Заранее скомпилированные скрипты (--emit-c, --aot). CEmitter переводит скрипт в исходник
+// на C с функцией mathsol_main, системный компилятор собирает его в разделяемую библиотеку,
+// а mathsol загружает её через dlopen и выполняет без лексера, парсера и интерпретатора.
+//
+// Значения в сгенерированном коде - биты Value (NaN-boxing, см. value.hpp): числа и bool
+// код обрабатывает сам, остальное (строки, ошибки типов, вывод) - через функции
+// MathsolRuntime, которые реализует mathsol. Код хранит только биты, без счетчиков ссылок:
+// строки, которые вернул runtime, живут до release() в конце инструкции, а строку,
+// записанную в переменную, runtime держит через store(), пока слот не перезапишут.
+//
+// Библиотека несет штамп (mathsol_stamp) - версию mathsol и опции, с которыми ее
+// собрали. Тот же штамп с версией интерфейса лежит рядом в <library>.stamp: по нему --aot
+// решает, пересобирать ли библиотеку, не загружая ее (загрузка выполнила бы ее
+// конструкторы). Перед выполнением штамп внутри библиотеки проверяется еще раз.
+
+// Версия интерфейса между mathsol и библиотекой; библиотека с другой версией не загружается.
+// Меняется вместе с MathsolRuntime, разметкой Value и номерами TokenType.
+inline constexpr unsigned kAotAbi = 1;
+
+// Таблица функций runtime; сгенерированный исходник объявляет ту же структуру (c_emitter.cpp).
+// op - номер TokenType оператора (для x += v - OPERATOR_PLUS_EQ), line и column - его позиция. Функции,
+// возвращающие int, дают 0 при ошибке: сообщение уже выведено, скрипт должен остановиться.
+struct MathsolRuntime {
+    void* context;
+    uint64_t (*string)(void* context, const char* text, size_t length); // Строковый литерал
+    int (*binary)(void* context, int op, uint64_t left, uint64_t right, uint32_t line, uint32_t column, uint64_t* result);
+    int (*unary)(void* context, int op, uint64_t operand, uint32_t line, uint32_t column, uint64_t* result);
+    int (*logical)(void* context, int op, uint64_t operand, uint32_t line, uint32_t column); // Операнд and/or
+    void (*undefined)(void* context, const char* name, uint32_t line, uint32_t column);
+    void (*print)(void* context, uint64_t value);
+    void (*store)(void* context, uint32_t slot, uint64_t value); // В слот записана строка или слот держал строку
+    void (*release)(void* context); // Конец инструкции: ее временные строки больше не нужны
+};
+
+// Собирает исходник source в разделяемую библиотеку output компилятором из $CC (по
+// умолчанию cc) и записывает рядом output.stamp со штампом stamp; false - компилятор не
+// запустился или вернул ошибку
+bool buildSharedObject(const std::string& source, const std::string& output, std::string_view stamp);
+
+// Файл path.stamp говорит, что библиотека path собрана для этого интерфейса и со штампом
+// stamp. Библиотека не загружается
+bool sharedObjectMatches(const std::string& path, std::string_view stamp);
+
+// Загружает библиотеку path и выполняет скрипт; false - библиотеку не удалось загрузить,
+// ее штамп не stamp (сообщение в std::cerr) или скрипт остановился на ошибке
+bool runSharedObject(const std::string& path, std::string_view stamp);
@@ -0,0 +1,169 @@
+#pragma once
+
+#include <cstdint>
+#include <stdexcept>
+#include <vector>
+#include "../../lexer/include/token.hpp"
+#include "../../lexer/include/symbol_table.hpp"
+#include "../../parser/include/value.hpp"
+
+// Регистровый байткод MathSol. Инструкция - код операции и до трех 32-битных операндов
+// (регистры, индексы констант, слоты переменных, адреса переходов). Регистры - массив Value
+// виртуальной машины, переменные лежат в Environment по слотам из Resolver.
+//
+//   LOAD_CONST  a b      R[a] = K[b]
+//   LOAD_VAR    a b c    R[a] = переменная в слоте b (c - Symbol для сообщения об ошибке)
+//   STORE_VAR   a b      переменная в слоте b = R[a]
+//   MOVE        a b      R[a] = R[b] (значение общего подвыражения, см. Compiler)
+//   ADD .. POW  a b c    R[a] = R[b] op R[c]
+//   EQUAL .. GREATER_EQUAL  a b c  R[a] = R[b] op R[c]
+//   NEGATE, NOT a b      R[a] = op R[b]
+//   JUMP_IF_FALSE a b    R[a] должен быть bool; если false, переход на b (and)
+//   JUMP_IF_TRUE  a b    R[a] должен быть bool; если true, переход на b (or)
+//   CHECK_BOOL  a        R[a] должен быть bool (правый операнд and/or)
+//   RETURN      a        результат инструкции программы - R[a]
+//
+// Суперинструкции (их создает peephole-проход, см. peephole.hpp):
+//   ADD_K .. GREATER_EQUAL_K  a b c   R[a] = R[b] op K[c]            (LOAD_CONST + op)
+//   LESS_JUMP .. GREATER_EQUAL_JUMP a b c    R[a] = R[b] op R[c] и переход (сравнение +
+//   LESS_K_JUMP .. GREATER_EQUAL_K_JUMP a b c  R[a] = R[b] op K[c]      JUMP_IF_*): следующая
+//                        команда - исходный JUMP_IF_FALSE/TRUE, она хранит адрес и условие
+//                        перехода и выполняется вместе с сравнением
+//   ADD_VAR_K .. DIVIDE_VAR_K  a b c  x op= K[c] для переменной в слоте b, R[a] = новое x
+//                        (x += c, x -= c, x *= c, x /= c)
+//
+// Команды над числами без проверок типов: компилятор выбирает их для узлов numeric_, у
+// которых оба операнда заранее известны как числа (см. TypeInference):
+//   ADD_N .. GREATER_EQUAL_N      a b c   R[a] = R[b] op R[c]
+//   NEGATE_N                      a b     R[a] = -R[b]
+//   ADD_NK .. GREATER_EQUAL_NK    a b c   R[a] = R[b] op K[c]   (LOAD_CONST + OP_N)
+enum class OpCode : uint8_t {
+    LOAD_CONST,
+    LOAD_VAR,
+    STORE_VAR,
+    MOVE,
+    ADD,
+    SUBTRACT,
+    MULTIPLY,
+    DIVIDE,
+    MODULO,
+    POWER,
+    EQUAL,
+    NOT_EQUAL,
+    LESS,
+    LESS_EQUAL,
+    GREATER,
+    GREATER_EQUAL,
+    NEGATE,
+    NOT,
+    JUMP_IF_FALSE,
+    JUMP_IF_TRUE,
+    CHECK_BOOL,
+    RETURN,
+
+    // Суперинструкции
+    ADD_K,
+    SUBTRACT_K,
+    MULTIPLY_K,
+    DIVIDE_K,
+    LESS_K,
+    LESS_EQUAL_K,
+    GREATER_K,
+    GREATER_EQUAL_K,
+    LESS_JUMP,
+    LESS_EQUAL_JUMP,
+    GREATER_JUMP,
+    GREATER_EQUAL_JUMP,
+    LESS_K_JUMP,
+    LESS_EQUAL_K_JUMP,
+    GREATER_K_JUMP,
+    GREATER_EQUAL_K_JUMP,
+    ADD_VAR_K,
+    SUBTRACT_VAR_K,
+    MULTIPLY_VAR_K,
+    DIVIDE_VAR_K,
+
+    // Над числами без проверок типов
+    ADD_N,
+    SUBTRACT_N,
+    MULTIPLY_N,
+    DIVIDE_N,
+    LESS_N,
+    LESS_EQUAL_N,
+    GREATER_N,
+    GREATER_EQUAL_N,
+    NEGATE_N,
+    ADD_NK,
+    SUBTRACT_NK,
+    MULTIPLY_NK,
+    DIVIDE_NK,
+    LESS_NK,
+    LESS_EQUAL_NK,
+    GREATER_NK,
+    GREATER_EQUAL_NK
+};
+
+inline constexpr size_t kOpCodeCount = static_cast<size_t>(OpCode::GREATER_EQUAL_NK) + 1;
+
+struct Instruction {
+    OpCode op;
+    uint32_t a = 0;
+    uint32_t b = 0;
+    uint32_t c = 0;
+};
+
+// Откуда взялась инструкция: токен оператора и позиция для сообщений об ошибках
+struct SourceInfo {
+    TokenType op = TokenType::_EOF;
+    uint32_t line = 0;
+    uint32_t column = 0;
+    Symbol name = 0; // Переменная команд *_VAR_K (для "Undefined variable")
+};
+
+// Скомпилированный код одной инструкции программы: команды, пул констант и сведения
+// об исходнике (в отдельном массиве, чтобы не раздувать горячий массив команд)
+class Chunk {
+public:
+    const std::vector<Instruction>& code() const { return code_; }
+    const Value& constant(uint32_t index) const { return constants_[index]; }
+    uint32_t constantCount() const { return static_cast<uint32_t>(constants_.size()); }
+    const SourceInfo& info(size_t pc) const { return infos_[pc]; }
+    uint32_t registerCount() const { return register_count_; }
+    // Таблица, в которой интернированы Symbol команд (LOAD_VAR c, SourceInfo::name)
+    const SymbolTable& symbols() const { return *symbols_; }
+
+    // Токен оператора инструкции pc для runtimeError / applyBinary
+    Token where(size_t pc) const;
+
+    // Построение
+    size_t emit(OpCode op, uint32_t a, uint32_t b = 0, uint32_t c = 0, SourceInfo info = {});
+    uint32_t addConstant(Value value);
+    void setJumpTarget(size_t pc, size_t target) { code_[pc].b = static_cast<uint32_t>(target); }
+    void useRegisters(uint32_t count) { if (count > register_count_) register_count_ = count; }
+    void setSymbolTable(const SymbolTable& symbols) { symbols_ = &symbols; }
+    void clear(); // Память массивов сохраняется для следующей инструкции
+
+    // Подменяет код и сведения об исходнике (peephole); старые массивы возвращаются в
+    // code/infos, чтобы их память переиспользовать
+    void swapCode(std::vector<Instruction>& code, std::vector<SourceInfo>& infos);
+
+private:
+    std::vector<Instruction> code_;
+    std::vector<SourceInfo> infos_; // по команде
+    std::vector<Value> constants_;
+    uint32_t register_count_ = 0;
+    const SymbolTable* symbols_ = &SymbolTable::global();
+};
+
+// Слот переменной для команд *_VAR: они адресуют только глобальную область (глубина 0 в
+// Environment), других областей в языке пока нет. Переменная из вложенной области - ошибка
+// компиляции, а не чтение слота не той области; первой конструкции со своей областью
+// нужно будет научить команды глубине.
+inline uint32_t globalSlot(uint32_t depth, uint32_t slot) {
+    if (depth != 0) throw std::logic_error("bytecode addresses only global variables");
+    return slot;
+}
+
+// Оператор MathSol, который выполняет бинарная команда, в том числе суперинструкция
+// (ADD, ADD_K, ADD_VAR_K -> OPERATOR_PLUS, LESS_JUMP -> OPERATOR_LT, ...)
+TokenType binaryOperator(OpCode op);
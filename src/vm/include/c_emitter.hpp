@@ -0,0 +1,82 @@
+#pragma once
+
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+#include "../../parser/include/ast_visitor.hpp"
+#include "../../parser/include/expression.hpp"
+#include "../../parser/include/statement.hpp"
+
+// Перевод скрипта в исходник на C для --emit-c и --aot (см. aot.hpp). Инструкции добавляются
+// по одной, уже свернутые, разрешенные и с выведенными типами - как перед выполнением, -
+// поэтому дерево каждой можно освободить сразу после add(). finish() пишет весь файл.
+//
+// Регистры - те же, что у Compiler: выражение считается в rN, его правый операнд - в rN+1,
+// общие узлы - в r0..r(shared_-1); C-компилятор сам разложит их по регистрам процессора.
+// Поддерево из узлов numeric_ (см. TypeInference), литералов и переменных становится одним
+// выражением C над double, у остальных узлов проверка "оба числа" встроена, прочие случаи
+// уходят в runtime. Переменные - статические слоты файла; проверка "определена ли"
+// опускается после безусловного присваивания. Обход - явным стеком, посещение узла - через
+// AstVisitor.
+class CEmitter : public AstVisitor<CEmitter> {
+public:
+    // stamp - версия mathsol и опции сборки, попадает в mathsol_stamp (см. aot.hpp)
+    CEmitter(std::string_view source_name, std::string_view stamp) : source_name_(source_name), stamp_(stamp) {}
+
+    void add(const IStatement& statement);
+    void finish(std::ostream& out);
+
+    // Visit methods: шаг обхода для узла на вершине стека (frame_)
+    void visitNumericLiteral(const NumericLiteral& expr);
+    void visitStringLiteral(const StringLiteral& expr);
+    void visitBooleanLiteral(const BooleanLiteral& expr);
+    void visitIdentifierExpression(const IdentifierExpression& expr);
+    void visitBinaryExpression(const BinaryExpression& expr);
+    void visitUnaryExpression(const UnaryExpression& expr);
+    void visitAssignmentExpression(const AssignmentExpression& expr);
+    void visitExpressionStatement(const ExpressionStatement& stmt);
+
+private:
+    enum class Step : uint8_t { ENTER, LOGICAL_RIGHT, EXIT };
+    struct Frame {
+        const IExpression* node;
+        Step step;
+        uint32_t dst; // Регистр результата узла
+    };
+
+    static constexpr size_t kStatementsPerFunction = 64; // Не даем C-компилятору огромных функций
+    static constexpr size_t kMaxInlineNodes = 256;       // Общие узлы в выражении C повторяются
+
+    std::string source_name_;
+    std::string stamp_;
+    std::string body_;      // Функции part0..partN
+    std::string statement_; // Код текущей инструкции (объявление регистров известно в конце)
+    std::vector<Frame> frames_;
+    Frame frame_{};
+    uint32_t registers_ = 0;     // Регистров у текущей инструкции
+    uint32_t logical_depth_ = 0; // Вложенность правых операндов and/or: присваивание там условно
+    bool temporaries_ = false;   // В инструкции уже были вызовы runtime, которые могут вернуть строку
+    std::vector<uint8_t> shared_ready_; // По номеру shared_: значение уже в регистре
+    std::vector<std::pair<const IExpression*, bool>> inline_stack_; // numericExpression: узел, дети готовы
+    std::vector<std::string> inline_parts_;  // Тексты готовых поддеревьев
+    std::vector<std::string> inline_checks_; // Проверки "переменная определена" перед выражением
+    size_t statements_ = 0;
+
+    std::vector<std::string> variables_; // Имя по слоту
+    std::vector<uint8_t> defined_;       // По слоту: присваивание уже точно выполнено
+    std::vector<std::string> strings_;   // Литералы: k[i]
+    std::unordered_map<std::string, uint32_t> string_index_;
+
+    void emitExpression(const IExpression& root, uint32_t dst);
+    // rdst = root одним выражением C; false - в поддереве есть узлы, которым нужны проверки
+    bool numericExpression(const IExpression& root, uint32_t dst);
+    bool reuseShared(uint32_t shared, uint32_t dst);
+    void saveShared(uint32_t shared, uint32_t dst);
+    void variable(uint32_t depth, uint32_t slot, std::string_view name);
+    // rL = rL op rR для оператора op; numeric - операнды заведомо числа
+    void binary(TokenType op, uint32_t left, uint32_t right, uint32_t dst, const Token& where, bool numeric);
+    void line(std::string_view text); // Строка кода инструкции с отступом
+};
@@ -0,0 +1,43 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+#include "bytecode.hpp"
+#include "peephole.hpp"
+#include "../../parser/include/expression.hpp"
+#include "../../parser/include/statement.hpp"
+
+// Перевод дерева инструкции в регистровый байткод. Выражение вычисляется в регистр dst,
+// его правый операнд - в dst + 1, поэтому регистров нужно столько, какова глубина правых
+// вложений (а не число узлов). Обход идет явным стеком, как и остальные проходы по дереву.
+// Инструкция должна быть уже разрешена Resolver: команды переменных используют слоты из узлов.
+//
+// Общие узлы (shared_, см. SubexpressionTable) считаются один раз: первое вхождение копирует
+// значение в регистр с номером shared_, следующие берут его оттуда командой MOVE. Эти
+// регистры идут первыми, выражение вычисляется в регистры после них. Узлы numeric_ (см.
+// TypeInference) получают команды над числами без проверок типов (ADD_N и т.д.).
+class Compiler {
+public:
+    // peephole = false оставляет код без суперинструкций (для сравнения и отладки)
+    explicit Compiler(bool peephole = true) : peephole_(peephole) {}
+
+    // Заменяет содержимое chunk кодом statement; результат инструкции возвращает RETURN
+    void compile(const IStatement& statement, Chunk& chunk);
+
+private:
+    enum class Step : uint8_t { ENTER, LOGICAL_JUMP, EXIT };
+    struct Frame {
+        const IExpression* node;
+        Step step;
+        uint32_t dst;  // Регистр результата узла
+        size_t jump;   // EXIT для and/or: команда перехода, которой нужен адрес конца
+    };
+    std::vector<Frame> frames_; // Переиспользуется между инструкциями
+    std::vector<uint8_t> compiled_; // По номеру shared_: код узла уже есть, значение в регистре
+    bool peephole_;
+    PeepholeOptimizer optimizer_;
+
+    void compileExpression(const IExpression& root, uint32_t dst, Chunk& chunk);
+    bool reuseShared(uint32_t shared, uint32_t dst, Chunk& chunk); // MOVE, если значение уже есть
+    void saveShared(uint32_t shared, uint32_t dst, Chunk& chunk);
+};
@@ -0,0 +1,80 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <unordered_map>
+#include <vector>
+#include "bytecode.hpp"
+#include "../../parser/include/environment.hpp"
+
+class ExecutableMemory;
+
+// JIT-компилятор горячего числового байткода в машинный код x86-64 (MATHSOL_JIT в
+// CMakeLists.txt; на других платформах run всегда отказывается).
+//
+// Циклов в языке нет, поэтому "горячий код" - это одинаковые инструкции программы, которые
+// выполняются много раз (сгенерированные и развернутые скрипты, REPL). Код chunk вместе с
+// значениями его констант - ключ кэша: инструкция компилируется, когда её код встречается
+// kHotCount раз, и дальше каждое её повторение выполняет готовый машинный код. Счетчики
+// хранятся по полному хэшу кода и стареют поколениями: когда счетчиков становится
+// kHotTableSize, все они сбрасываются, так что код, который не повторяется, компиляции не
+// вызывает и память не копит.
+//
+// Компилируется только код, в котором все значения - числа и bool: проход по командам
+// выводит вид каждого регистра и переменной, начиная с видов переменных в момент
+// компиляции. Эти виды проверяются перед каждым запуском; если переменная не определена
+// или сменила тип, run отказывается до того, как что-то изменить, и инструкцию выполняет
+// VM - в том числе с её сообщениями об ошибках. В остальном машинный код ошибок не дает.
+//
+// Регистры байткода и переменные держатся в xmm2..xmm15 (самые используемые) или в кадре -
+// массиве double; переменные из Environment читаются в кадр перед запуском и записываются
+// обратно после. Код с вызовами (%, **) держит все в кадре: xmm не сохраняются при вызове.
+class Jit {
+public:
+    explicit Jit(Environment& env);
+    ~Jit();
+
+    // Есть ли JIT в этой сборке
+    static bool available();
+
+    // Выполняет chunk машинным кодом и кладет результат RETURN в result; false - chunk
+    // не скомпилирован (еще не горячий или не поддерживается), выполнять его должна VM
+    bool run(const Chunk& chunk, Value& result);
+
+private:
+    enum class Kind : uint8_t { UNDEFINED, NUMBER, BOOLEAN, UNKNOWN };
+
+    // Переменная скомпилированного кода; её ячейка кадра - индекс в inputs
+    struct Variable {
+        uint32_t slot;
+        Kind kind;
+    };
+
+    struct Compiled {
+        // Ключ: команды и биты констант (числа и bool) в порядке ссылок на них
+        std::vector<Instruction> code;
+        std::vector<uint64_t> constants;
+
+        double (*native)(double* frame) = nullptr; // nullptr - chunk не компилируется
+        std::vector<Variable> inputs;   // Виды в момент компиляции: проверяются перед запуском
+        std::vector<Variable> outputs;  // Присвоенные переменные: slot - индекс в inputs
+        uint32_t frame_size = 0;
+        Kind result = Kind::UNKNOWN;
+        uint8_t misses = 0; // Отказов проверки видов подряд; kHotCount - перекомпиляция
+    };
+
+    static constexpr uint8_t kHotCount = 2;
+    static constexpr size_t kHotTableSize = 4096; // Счетчиков в поколении; больше - сброс всех
+    static constexpr size_t kMaxCompiled = 4096;  // Записей или функций больше - кэш очищается целиком
+
+    Environment& env_;
+    std::unique_ptr<ExecutableMemory> memory_;
+    std::unordered_map<uint64_t, uint8_t> hot_; // По хэшу кода: сколько раз встречен до компиляции
+    std::unordered_map<uint64_t, Compiled> compiled_; // В том числе записи кода, который не компилируется
+    size_t bodies_ = 0;               // Скомпилированных функций в memory_
+    std::vector<uint64_t> constants_; // Ключ текущего chunk, переиспользуется
+    std::vector<double> frame_;       // Переиспользуется между запусками
+
+    Kind kindOf(uint32_t slot) const;
+    void compile(const Chunk& chunk, Compiled& entry);
+};
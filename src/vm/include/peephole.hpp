@@ -0,0 +1,26 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+#include "bytecode.hpp"
+
+// Peephole-проход по готовому коду: частые последовательности команд заменяются
+// суперинструкциями (см. bytecode.hpp), чтобы цикл VM делал меньше переходов по командам.
+//   LOAD_CONST r k; OP d x r                      -> OP_K d x k   (OP_N -> OP_NK)
+//   LOAD_CONST r k; LOAD_VAR r+1 s; OP r r+1 r; STORE_VAR r s  -> OP_VAR_K r s k  (x op= k)
+//   сравнение в r; JUMP_IF_FALSE/TRUE r           -> *_JUMP + исходный переход
+// Последовательность сливается, только если ни один переход не ведет внутрь нее;
+// адреса переходов пересчитываются после сжатия кода.
+class PeepholeOptimizer {
+public:
+    void optimize(Chunk& chunk);
+
+private:
+    // Переиспользуются между инструкциями
+    std::vector<uint8_t> targeted_;  // по старому адресу: на команду ведет переход
+    std::vector<uint32_t> remap_;    // старый адрес -> новый
+    std::vector<Instruction> code_;
+    std::vector<SourceInfo> infos_;
+
+    void emit(const Instruction& instruction, const SourceInfo& info);
+};
@@ -0,0 +1,136 @@
+#pragma once
+
+#include <cstdint>
+#include <fstream>
+#include <istream>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+#include "bytecode.hpp"
+#include "../../lexer/include/source_file.hpp"
+
+// Кэш скомпилированных скриптов (__mathsol_cache__, см. runFile в main.cpp): байткод всех
+// инструкций файла в порядке выполнения. Образ пишется по одной инструкции, пока они
+// выполняются, и читается так же, поэтому память ни при записи, ни при чтении не зависит
+// от длины скрипта.
+//
+// Образ (порядок байтов - little-endian, как у машины, которая его записала):
+//   Header                 магия, ключ, число инструкций, размер и контрольная сумма записей,
+//                          число слотов
+//   запись инструкции      подряд до конца файла
+// Запись инструкции, все числа - varint (LEB128):
+//   имена       сколько новых имен, затем длина и текст каждого; имена нумеруются по
+//               порядку появления во всем образе, LOAD_VAR c и SourceInfo::name - эти номера
+//   print       1 - значение печатается (выражение, а не присваивание)
+//   registers
+//   константы   число, затем каждая: тег и значение (число - 8 байт или целое varint,
+//               bool - в теге, строка - длина и текст)
+//   команды     число, затем каждая: код операции, только те операнды, которые у нее есть
+//               (см. operandKinds в script_cache.cpp), и сведения об исходнике: TokenType
+//               (_EOF - сведений нет), строка - разностью с предыдущей, колонка, номер имени
+//               у команд *_VAR_K
+// Symbol зависят от таблицы и порядка интернирования, поэтому в образе - номера имен:
+// add() берет имена из таблицы chunk, open() интернирует их в переданную таблицу.
+//
+// Ключ (scriptCacheKey) отличает и исходник, и версию mathsol с опциями компиляции: образ
+// с другим ключом не открывается. Недописанный образ не виден: запись идет во временный
+// файл, который переименовывается только в finish().
+
+// Запись образа по ходу выполнения скрипта
+class CompiledScriptWriter {
+public:
+    CompiledScriptWriter() = default;
+    ~CompiledScriptWriter(); // Образ без finish() удаляется
+
+    CompiledScriptWriter(const CompiledScriptWriter&) = delete;
+    CompiledScriptWriter& operator=(const CompiledScriptWriter&) = delete;
+
+    // Начинает образ, который finish() сохранит как path; false - файл не создать
+    bool open(const std::string& path);
+    // Добавляет инструкцию (в порядке выполнения)
+    void add(const Chunk& chunk, bool print);
+    // Дописывает заголовок и переименовывает файл в path; false - записать не удалось
+    bool finish(uint64_t key);
+
+private:
+    static constexpr size_t kFlushSize = 64 * 1024;
+
+    std::string path_;
+    std::string temporary_;
+    std::ofstream out_;
+    std::string buffer_;   // Записи, еще не отданные в out_
+    std::string body_;     // Запись без новых имен (они должны идти перед ней)
+    uint64_t statements_ = 0;
+    uint64_t payload_ = 0; // Байт записей в out_
+    uint64_t checksum_ = 0; // FNV-1a записей в out_
+    uint32_t slots_ = 0;   // Больший слот переменной + 1
+    int64_t line_ = 0;     // Строка предыдущих сведений об исходнике
+    std::unordered_map<Symbol, uint32_t> symbol_index_;
+    std::vector<Symbol> new_names_; // Имена текущей инструкции, которых еще не было
+
+    uint32_t symbolIndex(Symbol symbol);
+    void flush();
+    void discard();
+};
+
+// Чтение сохраненного образа инструкция за инструкцией из отображения в память
+class CompiledScript {
+public:
+    // Заголовок образа (его пишет и CompiledScriptWriter)
+    struct Header {
+        char magic[8];
+        uint64_t key;
+        uint64_t statements;
+        uint64_t payload;  // Байт записей после заголовка
+        uint64_t checksum; // FNV-1a записей
+        uint32_t slots;
+        uint32_t reserved;
+    };
+
+    // Отображает образ, проверяет ключ, контрольную сумму и все записи (коды операций, номера
+    // регистров, констант, слотов и имен, адреса переходов) и интернирует имена в symbols; false -
+    // файла нет, ключ другой или образ поврежден. Открытый образ выполнять безопасно.
+    bool open(const std::string& path, uint64_t key, SymbolTable& symbols);
+
+    // Заменяет содержимое chunk кодом следующей инструкции; false - инструкции кончились
+    // (или образ изменился после open(), см. damaged())
+    bool next(Chunk& chunk, bool& print);
+    bool damaged() const { return damaged_; }
+
+private:
+    // Позиция чтения в записях
+    struct Cursor {
+        const uint8_t* at;
+        const uint8_t* end;
+        bool ok = true;
+
+        uint8_t byte();
+        uint64_t varint();
+        uint32_t u32(); // varint, который должен поместиться в 32 бита
+        std::string_view bytes(uint64_t count);
+    };
+
+    static constexpr size_t kReleaseStep = 1 << 20; // Прочитанные страницы отдаются системе пачками
+
+    MappedFile mapped_;
+    Header header_{};
+    const uint8_t* payload_ = nullptr;
+    size_t offset_ = 0;        // Начало следующей записи в payload_
+    size_t released_ = 0;
+    uint64_t remaining_ = 0;   // Инструкций до конца образа
+    int64_t line_ = 0;
+    size_t names_ = 0;         // Имен прочитано при выполнении (проверка против symbols_)
+    bool damaged_ = false;
+    SymbolTable* symbol_table_ = nullptr;
+    std::vector<Symbol> symbols_; // Номер имени в образе -> Symbol в symbol_table_
+
+    // Разбирает запись в chunk с проверкой всех ссылок. intern - первый проход open():
+    // имена интернируются, константы не создаются
+    bool decode(Cursor& cursor, Chunk& chunk, bool& print, bool intern);
+    void release();
+};
+
+// Ключ кэша: FNV-1a по байтам исходника (читается блоками), версии интерпретатора и флагам
+// проходов (свертка, общие подвыражения, вывод типов), которые меняют байткод
+uint64_t scriptCacheKey(std::istream& source, std::string_view version, uint32_t options);
@@ -0,0 +1,20 @@
+#pragma once
+
+#include <vector>
+#include "bytecode.hpp"
+#include "../../parser/include/environment.hpp"
+
+// Виртуальная машина для регистрового байткода (см. bytecode.hpp).
+// Семантика та же, что у IExpression::evaluate: числа обрабатываются сразу в цикле
+// выполнения, остальные случаи и ошибки типов - общими applyBinary/applyUnary из value.hpp.
+class VirtualMachine {
+public:
+    explicit VirtualMachine(Environment& env) : env_(env) {}
+
+    // Выполняет chunk и возвращает значение его RETURN
+    Value run(const Chunk& chunk);
+
+private:
+    Environment& env_;
+    std::vector<Value> registers_; // Переиспользуются между вызовами
+};
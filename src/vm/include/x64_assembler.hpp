@@ -0,0 +1,91 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Минимальный ассемблер x86-64 для JIT (см. jit.hpp): скалярные double в регистрах SSE2,
+// операнды - регистр xmm, ячейка кадра [rbx + 8 * index] или константа из пула после кода
+// (адресация относительно rip). Кадр - массив double, его адрес функция получает в rdi и
+// держит в rbx.
+class X64Assembler {
+public:
+    struct Operand {
+        enum Kind : uint8_t { XMM, FRAME, CONSTANT };
+        Kind kind;
+        uint32_t index; // Номер xmm, ячейки кадра или константы пула
+    };
+    static Operand xmm(uint32_t index) { return {Operand::XMM, index}; }
+    static Operand frame(uint32_t index) { return {Operand::FRAME, index}; }
+
+    // Условия переходов и setcc (младшие 4 бита кода)
+    enum Condition : uint8_t {
+        BELOW = 0x2, ABOVE_EQUAL = 0x3, EQUAL = 0x4, NOT_EQUAL = 0x5,
+        ABOVE = 0x7, PARITY = 0xA, NOT_PARITY = 0xB,
+    };
+
+    // Скалярные операции SSE2 (второй байт кода 0F xx)
+    enum Sse : uint8_t { ADDSD = 0x58, MULSD = 0x59, SUBSD = 0x5C, DIVSD = 0x5E };
+
+    Operand constant(double value); // Ячейка пула с value (одинаковые значения - одна ячейка)
+
+    void prologue();                               // push rbx; mov rbx, rdi
+    void epilogue();                               // pop rbx; ret
+    void load(uint32_t dst, Operand src);          // movsd xmm, src
+    void store(Operand dst, uint32_t src);         // movsd dst, xmm
+    void arithmetic(Sse op, uint32_t dst, Operand src); // op xmm, src
+    void compare(uint32_t left, Operand right);    // ucomisd xmm, right
+    void negate(uint32_t dst, uint32_t scratch);   // смена знака через xorpd
+    void setAl(Condition condition);               // setcc al
+    void setCl(Condition condition);               // setcc cl
+    void andAlCl();
+    void orAlCl();
+    void boolFromAl(uint32_t dst);                 // xmm = al ? 1.0 : 0.0
+    void testAl();
+    void testOperand(Operand operand);             // test бит операнда (0.0 - это все нули)
+    void call(double (*function)(double, double)); // xmm0 = function(xmm0, xmm1)
+
+    // Условный переход на метку label (номер команды байткода); адрес проставит finish
+    void jump(Condition condition, uint32_t label);
+    void bind(uint32_t label);                     // Метка label - текущая позиция
+
+    // Пул констант дописывается после кода, ссылки на него и на метки пересчитываются
+    const std::vector<uint8_t>& finish();
+
+private:
+    std::vector<uint8_t> code_;
+    std::vector<uint64_t> constants_; // Биты double
+    struct Patch { size_t position; uint32_t target; };
+    std::vector<Patch> constant_patches_; // disp32 ссылок на пул
+    std::vector<Patch> jump_patches_;     // rel32 переходов на метки
+    std::vector<size_t> labels_;          // Позиция метки в коде
+
+    void byte(uint8_t value) { code_.push_back(value); }
+    void dword(uint32_t value);
+    void qword(uint64_t value);
+    // [prefix] [REX] 0F opcode ModRM: reg - регистр xmm или общий, rm - операнд
+    void instruction(uint8_t prefix, uint8_t opcode, uint32_t reg, Operand rm, bool wide = false);
+    void movRaxImmediate(uint64_t value);
+};
+
+// Исполняемая память для машинного кода: страницы из mmap, которые доступны либо на запись,
+// либо на выполнение (W^X). Код добавляется блоками и освобождается только целиком.
+class ExecutableMemory {
+public:
+    ExecutableMemory() = default;
+    ExecutableMemory(const ExecutableMemory&) = delete;
+    ExecutableMemory& operator=(const ExecutableMemory&) = delete;
+    ~ExecutableMemory() { clear(); }
+
+    // Копирует code в исполняемую память; nullptr, если память не выделилась
+    const void* add(const std::vector<uint8_t>& code);
+    void clear();
+
+private:
+    struct Region {
+        uint8_t* base;
+        size_t size;
+        size_t used;
+    };
+    std::vector<Region> regions_;
+};
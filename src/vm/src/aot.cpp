@@ -0,0 +1,199 @@
+#include "../include/aot.hpp"
+#include <cstdio>
+#include <cstdlib>
+#include <exception>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <vector>
+#include "../../parser/include/environment.hpp"
+#include "../../parser/include/operator_table.hpp"
+#include "../../parser/include/value.hpp"
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <dlfcn.h>
+#define MATHSOL_HAS_DLOPEN 1
+#endif
+
+#ifdef MATHSOL_HAS_DLOPEN
+
+namespace {
+
+// Состояние одного выполнения: строки, которые runtime отдал коду (код держит только биты)
+struct Context {
+    std::vector<Value> strings;   // Временные строки текущей инструкции
+    std::vector<Value> variables; // По слоту: последняя строка, записанная в переменную
+};
+
+Token where(int op, uint32_t line, uint32_t column) {
+    TokenType type = static_cast<TokenType>(op);
+    return Token(type, valueTT[static_cast<size_t>(type)], line, column);
+}
+
+uint64_t keep(void* context, Value value) {
+    uint64_t bits = value.raw();
+    if (value.isString()) static_cast<Context*>(context)->strings.push_back(std::move(value));
+    return bits;
+}
+
+// Ошибки выполнения выводятся так же, как в runStatements
+void report(const std::exception& e) {
+    std::cerr << e.what() << "\n";
+}
+
+uint64_t runtimeString(void*, const char* text, size_t length) {
+    return Value(InternedString::intern(std::string_view(text, length))).raw(); // Таблица живет до конца работы
+}
+
+int runtimeBinary(void* context, int op, uint64_t left, uint64_t right, uint32_t line, uint32_t column, uint64_t* result) {
+    try {
+        Token token = where(op, line, column);
+        *result = keep(context, applyBinary(compoundBaseOperator(token.getType()), Value::fromRaw(left), Value::fromRaw(right), token));
+        return 1;
+    } catch (const std::exception& e) {
+        report(e);
+        return 0;
+    }
+}
+
+int runtimeUnary(void* context, int op, uint64_t operand, uint32_t line, uint32_t column, uint64_t* result) {
+    try {
+        *result = keep(context, applyUnary(static_cast<TokenType>(op), Value::fromRaw(operand), where(op, line, column)));
+        return 1;
+    } catch (const std::exception& e) {
+        report(e);
+        return 0;
+    }
+}
+
+int runtimeLogical(void*, int op, uint64_t operand, uint32_t line, uint32_t column) {
+    try {
+        logicalOperand(Value::fromRaw(operand), where(op, line, column));
+        return 1;
+    } catch (const std::exception& e) {
+        report(e);
+        return 0;
+    }
+}
+
+void runtimeUndefined(void*, const char* name, uint32_t line, uint32_t column) {
+    try {
+        undefinedVariable(name, line, column);
+    } catch (const std::exception& e) {
+        report(e);
+    }
+}
+
+void runtimePrint(void*, uint64_t value) {
+    std::cout << formatValue(Value::fromRaw(value)) << "\n";
+}
+
+void runtimeStore(void* context, uint32_t slot, uint64_t value) {
+    std::vector<Value>& variables = static_cast<Context*>(context)->variables;
+    if (slot >= variables.size()) variables.resize(slot + 1);
+    // Своя ссылка на новую строку (временная уйдет в release); прежняя строка слота
+    // отпускается, даже если теперь в нем число или bool
+    variables[slot] = Value::fromRaw(value);
+}
+
+void runtimeRelease(void* context) {
+    static_cast<Context*>(context)->strings.clear();
+}
+
+// Библиотека собрана для этого интерфейса и со штампом stamp
+bool matches(void* library, std::string_view stamp) {
+    const unsigned* abi = static_cast<const unsigned*>(dlsym(library, "mathsol_abi"));
+    const char* built = static_cast<const char*>(dlsym(library, "mathsol_stamp"));
+    return abi && *abi == kAotAbi && built && stamp == built;
+}
+
+void* load(const std::string& path) {
+    // Путь без '/' dlopen искал бы среди системных библиотек
+    std::string file = path.find('/') == std::string::npos ? "./" + path : path;
+    return dlopen(file.c_str(), RTLD_NOW | RTLD_LOCAL);
+}
+
+// Содержимое path.stamp для библиотеки со штампом stamp
+std::string stampFile(std::string_view stamp) {
+    std::string text = "abi " + std::to_string(kAotAbi) + "\n";
+    return text.append(stamp).append("\n");
+}
+
+// Путь в одинарных кавычках для /bin/sh
+std::string shellQuoted(const std::string& text) {
+    std::string out = "'";
+    for (char c : text) {
+        if (c == '\'') out.append("'\\''");
+        else out.push_back(c);
+    }
+    out.push_back('\'');
+    return out;
+}
+
+} // namespace
+
+bool buildSharedObject(const std::string& source, const std::string& output, std::string_view stamp) {
+    std::string stampPath = output + ".stamp";
+    std::remove(stampPath.c_str()); // Старый штамп не должен пережить неудачную сборку
+    const char* compiler = std::getenv("CC");
+    std::string command = compiler && *compiler ? compiler : "cc";
+    // Без FMA: результат должен совпадать с интерпретатором до бита
+    command += " -O2 -ffp-contract=off -fPIC -shared -o " + shellQuoted(output) + " " + shellQuoted(source) + " -lm";
+    if (std::system(command.c_str()) != 0) {
+        std::cerr << "Error: C compiler failed: " << command << "\n";
+        return false;
+    }
+    // Без штампа библиотека просто соберется заново при следующем запуске
+    std::ofstream out(stampPath, std::ios::binary);
+    out << stampFile(stamp);
+    return true;
+}
+
+bool sharedObjectMatches(const std::string& path, std::string_view stamp) {
+    std::ifstream in(path + ".stamp", std::ios::binary);
+    if (!in.is_open()) return false;
+    std::string text((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+    return text == stampFile(stamp);
+}
+
+bool runSharedObject(const std::string& path, std::string_view stamp) {
+    void* library = load(path);
+    if (!library) {
+        std::cerr << "Error: cant load " << path << ": " << dlerror() << "\n";
+        return false;
+    }
+    auto entry = reinterpret_cast<int (*)(const MathsolRuntime*)>(dlsym(library, "mathsol_main"));
+    if (!matches(library, stamp) || !entry) {
+        std::cerr << "Error: " << path << " was built for another version of mathsol or other options\n";
+        dlclose(library);
+        return false;
+    }
+
+    Context context;
+    MathsolRuntime runtime{&context, runtimeString, runtimeBinary, runtimeUnary, runtimeLogical, runtimeUndefined, runtimePrint,
+                           runtimeStore, runtimeRelease};
+    bool ok = entry(&runtime) == 0;
+    std::cout.flush();
+    context.strings.clear();
+    context.variables.clear();
+    dlclose(library);
+    return ok;
+}
+
+#else // MATHSOL_HAS_DLOPEN
+
+bool buildSharedObject(const std::string&, const std::string&, std::string_view) {
+    std::cerr << "Error: native compilation of scripts is not supported on this platform\n";
+    return false;
+}
+
+bool sharedObjectMatches(const std::string&, std::string_view) {
+    return false;
+}
+
+bool runSharedObject(const std::string&, std::string_view) {
+    std::cerr << "Error: native compilation of scripts is not supported on this platform\n";
+    return false;
+}
+
+#endif // MATHSOL_HAS_DLOPEN
@@ -0,0 +1,83 @@
+#include "../include/bytecode.hpp"
+
+Token Chunk::where(size_t pc) const {
+    const SourceInfo& source = infos_[pc];
+    return Token(source.op, valueTT[static_cast<size_t>(source.op)], source.line, source.column);
+}
+
+size_t Chunk::emit(OpCode op, uint32_t a, uint32_t b, uint32_t c, SourceInfo info) {
+    code_.push_back({op, a, b, c});
+    infos_.push_back(info);
+    return code_.size() - 1;
+}
+
+uint32_t Chunk::addConstant(Value value) {
+    constants_.push_back(std::move(value));
+    return static_cast<uint32_t>(constants_.size() - 1);
+}
+
+void Chunk::clear() {
+    code_.clear();
+    infos_.clear();
+    constants_.clear();
+    register_count_ = 0;
+}
+
+void Chunk::swapCode(std::vector<Instruction>& code, std::vector<SourceInfo>& infos) {
+    code_.swap(code);
+    infos_.swap(infos);
+}
+
+TokenType binaryOperator(OpCode op) {
+    switch (op) {
+        case OpCode::ADD:
+        case OpCode::ADD_K:
+        case OpCode::ADD_VAR_K:
+        case OpCode::ADD_N:
+        case OpCode::ADD_NK:               return TokenType::OPERATOR_PLUS;
+        case OpCode::SUBTRACT:
+        case OpCode::SUBTRACT_K:
+        case OpCode::SUBTRACT_VAR_K:
+        case OpCode::SUBTRACT_N:
+        case OpCode::SUBTRACT_NK:          return TokenType::OPERATOR_MINUS;
+        case OpCode::MULTIPLY:
+        case OpCode::MULTIPLY_K:
+        case OpCode::MULTIPLY_VAR_K:
+        case OpCode::MULTIPLY_N:
+        case OpCode::MULTIPLY_NK:          return TokenType::OPERATOR_MUL;
+        case OpCode::DIVIDE:
+        case OpCode::DIVIDE_K:
+        case OpCode::DIVIDE_VAR_K:
+        case OpCode::DIVIDE_N:
+        case OpCode::DIVIDE_NK:            return TokenType::OPERATOR_DIV;
+        case OpCode::MODULO:               return TokenType::OPERATOR_MOD;
+        case OpCode::POWER:                return TokenType::OPERATOR_POW;
+        case OpCode::EQUAL:                return TokenType::OPERATOR_EQ;
+        case OpCode::NOT_EQUAL:            return TokenType::OPERATOR_NE;
+        case OpCode::LESS:
+        case OpCode::LESS_K:
+        case OpCode::LESS_JUMP:
+        case OpCode::LESS_K_JUMP:
+        case OpCode::LESS_N:
+        case OpCode::LESS_NK:              return TokenType::OPERATOR_LT;
+        case OpCode::LESS_EQUAL:
+        case OpCode::LESS_EQUAL_K:
+        case OpCode::LESS_EQUAL_JUMP:
+        case OpCode::LESS_EQUAL_K_JUMP:
+        case OpCode::LESS_EQUAL_N:
+        case OpCode::LESS_EQUAL_NK:        return TokenType::OPERATOR_LE;
+        case OpCode::GREATER:
+        case OpCode::GREATER_K:
+        case OpCode::GREATER_JUMP:
+        case OpCode::GREATER_K_JUMP:
+        case OpCode::GREATER_N:
+        case OpCode::GREATER_NK:           return TokenType::OPERATOR_GT;
+        case OpCode::GREATER_EQUAL:
+        case OpCode::GREATER_EQUAL_K:
+        case OpCode::GREATER_EQUAL_JUMP:
+        case OpCode::GREATER_EQUAL_K_JUMP:
+        case OpCode::GREATER_EQUAL_N:
+        case OpCode::GREATER_EQUAL_NK:     return TokenType::OPERATOR_GE;
+        default:                           return TokenType::_EOF;
+    }
+}
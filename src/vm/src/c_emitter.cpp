@@ -0,0 +1,415 @@
+#include "../include/c_emitter.hpp"
+#include <algorithm>
+#include <charconv>
+#include <cmath>
+#include <cstdio>
+#include "../include/aot.hpp"
+#include "../include/bytecode.hpp"
+#include "../../parser/include/operator_table.hpp"
+
+namespace {
+
+// Начало сгенерированного файла: та же таблица, что MathsolRuntime в aot.hpp, и разметка
+// Value из value.hpp (число - биты double, bool - 0xFFFD...0/1, канонический NaN)
+constexpr std::string_view kPrelude = R"(#include <math.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+struct mathsol_runtime {
+    void* context;
+    uint64_t (*string)(void* context, const char* text, size_t length);
+    int (*binary)(void* context, int op, uint64_t left, uint64_t right, uint32_t line, uint32_t column, uint64_t* result);
+    int (*unary)(void* context, int op, uint64_t operand, uint32_t line, uint32_t column, uint64_t* result);
+    int (*logical)(void* context, int op, uint64_t operand, uint32_t line, uint32_t column);
+    void (*undefined)(void* context, const char* name, uint32_t line, uint32_t column);
+    void (*print)(void* context, uint64_t value);
+    void (*store)(void* context, uint32_t slot, uint64_t value);
+    void (*release)(void* context);
+};
+
+#define MS_BOX 0xFFFC000000000000ull
+#define MS_TAG 0xFFFF000000000000ull
+#define MS_FALSE 0xFFFD000000000000ull
+#define MS_TRUE 0xFFFD000000000001ull
+#define MS_NAN 0x7FF8000000000000ull
+
+static inline int ms_is_number(uint64_t v) { return (v & MS_BOX) != MS_BOX; }
+static inline int ms_is_bool(uint64_t v) { return (v & MS_TAG) == MS_FALSE; }
+static inline int ms_is_plain(uint64_t v) { return ms_is_number(v) || ms_is_bool(v); } /* Не строка */
+static inline double ms_as(uint64_t v) { double d; memcpy(&d, &v, sizeof d); return d; }
+static inline uint64_t ms_number(double d) {
+    uint64_t v;
+    memcpy(&v, &d, sizeof v);
+    return (v & MS_BOX) == MS_BOX ? MS_NAN : v;
+}
+static inline uint64_t ms_bool(int b) { return MS_FALSE | (uint64_t)(b != 0); }
+static inline double ms_power(double base, double exponent) { return exponent == 2 ? base * base : pow(base, exponent); }
+
+static const struct mathsol_runtime* rt;
+
+#define MS_BINARY(op, l, r, line, column, dst) \
+    do { if (!rt->binary(rt->context, op, l, r, line, column, &dst)) return 1; } while (0)
+#define MS_UNARY(op, v, line, column) \
+    do { if (!rt->unary(rt->context, op, v, line, column, &v)) return 1; } while (0)
+#define MS_LOGICAL(op, v, line, column) \
+    do { if (!ms_is_bool(v) && !rt->logical(rt->context, op, v, line, column)) return 1; } while (0)
+#define MS_UNDEFINED(name, line, column) \
+    do { rt->undefined(rt->context, name, line, column); return 1; } while (0)
+
+)";
+
+// Через append: на "r" + std::to_string(...) GCC 12 дает ложное -Wrestrict
+std::string reg(uint32_t index) {
+    std::string name = "r";
+    name.append(std::to_string(index));
+    return name;
+}
+
+std::string bitsLiteral(uint64_t bits) {
+    char buffer[32];
+    std::snprintf(buffer, sizeof(buffer), "0x%016llXull", static_cast<unsigned long long>(bits));
+    return buffer;
+}
+
+// Литерал C: печатаемые ASCII как есть, остальное - восьмеричными escape
+std::string quoted(std::string_view text) {
+    std::string out = "\"";
+    for (unsigned char c : text) {
+        if (c == '"' || c == '\\') {
+            out.push_back('\\');
+            out.push_back(static_cast<char>(c));
+        } else if (c >= 0x20 && c < 0x7F && c != '?') { // '?' - без триграфов
+            out.push_back(static_cast<char>(c));
+        } else {
+            char escape[8];
+            std::snprintf(escape, sizeof(escape), "\\%03o", c);
+            out.append(escape);
+        }
+    }
+    out.push_back('"');
+    return out;
+}
+
+// Число как шестнадцатеричный литерал C (точно); false - inf или NaN
+bool doubleLiteral(double value, std::string& text) {
+    if (!std::isfinite(value)) return false;
+    char buffer[64];
+    char* end = std::to_chars(buffer, buffer + sizeof(buffer), std::fabs(value), std::chars_format::hex).ptr;
+    text.assign(std::signbit(value) ? "(-0x" : "0x").append(buffer, end);
+    if (std::signbit(value)) text.push_back(')');
+    return true;
+}
+
+std::string position(uint32_t line, uint32_t column) {
+    return std::to_string(line) + ", " + std::to_string(column);
+}
+
+std::string opNumber(TokenType op) {
+    return std::to_string(static_cast<int>(op));
+}
+
+} // namespace
+
+void CEmitter::add(const IStatement& statement) {
+    if (statements_ % kStatementsPerFunction == 0) {
+        if (statements_ > 0) body_.append("    return 0;\n}\n\n");
+        body_.append("static int part").append(std::to_string(statements_ / kStatementsPerFunction)).append("(void) {\n");
+    }
+    statements_++;
+    visit(statement);
+}
+
+void CEmitter::finish(std::ostream& out) {
+    out << "/* Generated by mathsol --emit-c from " << source_name_ << ". Do not edit. */\n";
+    out << kPrelude;
+    if (!strings_.empty()) out << "static uint64_t k[" << strings_.size() << "];\n";
+    for (size_t slot = 0; slot < variables_.size(); slot++) {
+        out << "static uint64_t v" << slot << "; static unsigned char d" << slot << "; /* " << variables_[slot] << " */\n";
+    }
+    out << "\n" << body_;
+    if (statements_ > 0) out << "    return 0;\n}\n\n";
+
+    out << "const unsigned mathsol_abi = " << kAotAbi << ";\n";
+    out << "const char mathsol_stamp[] = " << quoted(stamp_) << ";\n\n";
+    out << "int mathsol_main(const struct mathsol_runtime* runtime) {\n";
+    out << "    rt = runtime;\n";
+    for (size_t i = 0; i < strings_.size(); i++) {
+        out << "    k[" << i << "] = rt->string(rt->context, " << quoted(strings_[i]) << ", " << strings_[i].size() << ");\n";
+    }
+    size_t parts = (statements_ + kStatementsPerFunction - 1) / kStatementsPerFunction;
+    for (size_t i = 0; i < parts; i++) out << "    if (part" << i << "()) return 1;\n";
+    out << "    return 0;\n}\n";
+}
+
+void CEmitter::line(std::string_view text) {
+    statement_.append(8 + 4 * static_cast<size_t>(logical_depth_), ' ').append(text).push_back('\n');
+}
+
+void CEmitter::variable(uint32_t depth, uint32_t slot, std::string_view name) {
+    globalSlot(depth, slot); // Переменные файла - одна плоская область, как у VM
+    if (variables_.size() <= slot) {
+        variables_.resize(slot + 1);
+        defined_.resize(slot + 1, 0);
+    }
+    if (variables_[slot].empty()) variables_[slot] = name;
+}
+
+bool CEmitter::reuseShared(uint32_t shared, uint32_t dst) {
+    if (shared == kNotShared || !shared_ready_[shared]) return false;
+    line(reg(dst) + " = " + reg(shared) + ";");
+    return true;
+}
+
+void CEmitter::saveShared(uint32_t shared, uint32_t dst) {
+    if (shared == kNotShared) return;
+    line(reg(shared) + " = " + reg(dst) + ";");
+    shared_ready_[shared] = 1;
+}
+
+void CEmitter::binary(TokenType op, uint32_t left, uint32_t right, uint32_t dst, const Token& where, bool numeric) {
+    std::string l = "ms_as(" + reg(left) + ")";
+    std::string r = "ms_as(" + reg(right) + ")";
+    std::string value;
+    switch (op) {
+        case TokenType::OPERATOR_PLUS:  value = "ms_number(" + l + " + " + r + ")"; break;
+        case TokenType::OPERATOR_MINUS: value = "ms_number(" + l + " - " + r + ")"; break;
+        case TokenType::OPERATOR_MUL:   value = "ms_number(" + l + " * " + r + ")"; break;
+        case TokenType::OPERATOR_DIV:   value = "ms_number(" + l + " / " + r + ")"; break;
+        case TokenType::OPERATOR_MOD:   value = "ms_number(fmod(" + l + ", " + r + "))"; break;
+        case TokenType::OPERATOR_POW:   value = "ms_number(ms_power(" + l + ", " + r + "))"; break;
+        case TokenType::OPERATOR_EQ:    value = "ms_bool(" + l + " == " + r + ")"; break;
+        case TokenType::OPERATOR_NE:    value = "ms_bool(" + l + " != " + r + ")"; break;
+        case TokenType::OPERATOR_LT:    value = "ms_bool(" + l + " < " + r + ")"; break;
+        case TokenType::OPERATOR_LE:    value = "ms_bool(" + l + " <= " + r + ")"; break;
+        case TokenType::OPERATOR_GT:    value = "ms_bool(" + l + " > " + r + ")"; break;
+        default:                        value = "ms_bool(" + l + " >= " + r + ")"; break; // OPERATOR_GE
+    }
+    if (numeric) {
+        line(reg(dst) + " = " + value + ";");
+        return;
+    }
+    line("if (ms_is_number(" + reg(left) + ") && ms_is_number(" + reg(right) + ")) " + reg(dst) + " = " + value + ";");
+    // Runtime получает токен оператора (+= для x += v): по нему и операция, и сообщение
+    line("else MS_BINARY(" + opNumber(where.getType()) + ", " + reg(left) + ", " + reg(right) + ", " +
+         position(where.getLine(), where.getColumn()) + ", " + reg(dst) + ");");
+    temporaries_ = true;
+}
+
+bool CEmitter::numericExpression(const IExpression& root, uint32_t dst) {
+    inline_stack_.assign(1, {&root, false});
+    inline_parts_.clear();
+    inline_checks_.clear();
+    size_t nodes = 0;
+    bool comparison = false; // Сравнение допустимо только в корне: его результат - bool
+    while (!inline_stack_.empty()) {
+        auto [node, ready] = inline_stack_.back();
+        inline_stack_.pop_back();
+        if (++nodes > kMaxInlineNodes) return false;
+        switch (node->kind()) {
+            case ExpressionKind::NUMERIC: {
+                std::string text;
+                if (!doubleLiteral(static_cast<const NumericLiteral*>(node)->value_, text)) return false;
+                inline_parts_.push_back(std::move(text));
+                break;
+            }
+            case ExpressionKind::IDENTIFIER: {
+                // Операнд узла numeric_: заведомо число, если определен
+                const IdentifierExpression* id = static_cast<const IdentifierExpression*>(node);
+                variable(id->depth_, id->slot_, id->getName());
+                std::string slot = std::to_string(id->slot_);
+                if (!defined_[id->slot_]) {
+                    inline_checks_.push_back("if (!d" + slot + ") MS_UNDEFINED(" + quoted(variables_[id->slot_]) + ", " +
+                                             position(id->line_, id->column_) + ");");
+                }
+                inline_parts_.push_back("ms_as(v" + slot + ")");
+                break;
+            }
+            case ExpressionKind::UNARY: {
+                const UnaryExpression* unary = static_cast<const UnaryExpression*>(node);
+                if (!unary->numeric_) return false;
+                if (!ready) {
+                    inline_stack_.push_back({node, true});
+                    inline_stack_.push_back({unary->right_, false});
+                } else {
+                    inline_parts_.back() = "(-" + inline_parts_.back() + ")";
+                }
+                break;
+            }
+            case ExpressionKind::BINARY: {
+                const BinaryExpression* binary = static_cast<const BinaryExpression*>(node);
+                TokenType op = binary->operator_token_.getType();
+                if (!binary->numeric_) return false;
+                if (!ready) {
+                    if (operatorInfo(op).kind != OperatorKind::ARITHMETIC) {
+                        if (node != &root) return false;
+                        comparison = true;
+                    }
+                    inline_stack_.push_back({node, true});
+                    inline_stack_.push_back({binary->right_, false});
+                    inline_stack_.push_back({binary->left_, false});
+                    break;
+                }
+                std::string right = std::move(inline_parts_.back());
+                inline_parts_.pop_back();
+                std::string& left = inline_parts_.back();
+                switch (op) {
+                    case TokenType::OPERATOR_MOD: left = "fmod(" + left + ", " + right + ")"; break;
+                    case TokenType::OPERATOR_POW: left = "ms_power(" + left + ", " + right + ")"; break;
+                    default: left = "(" + left + " " + std::string(valueTT[static_cast<size_t>(op)]) + " " + right + ")"; break;
+                }
+                break;
+            }
+            default:
+                return false; // Строки, bool, присваивания
+        }
+    }
+    for (const std::string& check : inline_checks_) line(check);
+    line(reg(dst) + (comparison ? " = ms_bool(" : " = ms_number(") + inline_parts_.back() + ");");
+    return true;
+}
+
+void CEmitter::emitExpression(const IExpression& root, uint32_t dst) {
+    frames_.push_back({&root, Step::ENTER, dst});
+    while (!frames_.empty()) {
+        frame_ = frames_.back();
+        frames_.pop_back();
+        registers_ = std::max(registers_, frame_.dst + 1);
+        visit(*frame_.node);
+    }
+}
+
+// --- Statements ---
+void CEmitter::visitExpressionStatement(const ExpressionStatement& stmt) {
+    statement_.clear();
+    registers_ = 0;
+    temporaries_ = false;
+    shared_ready_.assign(stmt.shared_, 0);
+    uint32_t result = stmt.shared_; // Регистры 0..shared_-1 - общие значения
+    emitExpression(*stmt.expression_, result);
+    if (stmt.expression_->kind() != ExpressionKind::ASSIGNMENT) line("rt->print(rt->context, " + reg(result) + ");");
+    if (temporaries_) line("rt->release(rt->context);"); // Строки, которые вернул runtime
+
+    body_.append("    {\n        uint64_t ");
+    for (uint32_t i = 0; i < registers_; i++) body_.append(i ? ", " : "").append(reg(i));
+    body_.append(";\n").append(statement_).append("    }\n");
+}
+
+// --- Expressions ---
+void CEmitter::visitNumericLiteral(const NumericLiteral& expr) {
+    line(reg(frame_.dst) + " = " + bitsLiteral(Value(expr.value_).raw()) + "; /* " + formatNumber(expr.value_) + " */");
+}
+
+void CEmitter::visitStringLiteral(const StringLiteral& expr) {
+    std::string text(expr.text());
+    auto [it, inserted] = string_index_.try_emplace(text, static_cast<uint32_t>(strings_.size()));
+    if (inserted) strings_.push_back(std::move(text));
+    line(reg(frame_.dst) + " = k[" + std::to_string(it->second) + "];");
+}
+
+void CEmitter::visitBooleanLiteral(const BooleanLiteral& expr) {
+    line(reg(frame_.dst) + (expr.value_ ? " = MS_TRUE;" : " = MS_FALSE;"));
+}
+
+void CEmitter::visitIdentifierExpression(const IdentifierExpression& expr) {
+    variable(expr.depth_, expr.slot_, expr.getName());
+    std::string slot = std::to_string(expr.slot_);
+    if (!defined_[expr.slot_]) {
+        line("if (!d" + slot + ") MS_UNDEFINED(" + quoted(variables_[expr.slot_]) + ", " + position(expr.line_, expr.column_) + ");");
+    }
+    line(reg(frame_.dst) + " = v" + slot + ";");
+}
+
+void CEmitter::visitUnaryExpression(const UnaryExpression& expr) {
+    uint32_t dst = frame_.dst;
+    if (frame_.step == Step::ENTER) {
+        if (reuseShared(expr.shared_, dst)) return;
+        if (expr.numeric_ && numericExpression(expr, dst)) {
+            saveShared(expr.shared_, dst);
+            return;
+        }
+        frames_.push_back({&expr, Step::EXIT, dst});
+        frames_.push_back({expr.right_, Step::ENTER, dst});
+        return;
+    }
+    const Token& op = expr.operator_token_;
+    std::string r = reg(dst);
+    std::string slow = "MS_UNARY(" + opNumber(op.getType()) + ", " + r + ", " + position(op.getLine(), op.getColumn()) + ");";
+    switch (op.getType()) {
+        case TokenType::OPERATOR_MINUS:
+            if (expr.numeric_) line(r + " = ms_number(-ms_as(" + r + "));");
+            else line("if (ms_is_number(" + r + ")) " + r + " = ms_number(-ms_as(" + r + ")); else " + slow);
+            break;
+        case TokenType::OPERATOR_NOT:
+        case TokenType::KEYWORD_NOT:
+            line("if (ms_is_bool(" + r + ")) " + r + " ^= 1; else " + slow);
+            break;
+        default:
+            line(slow);
+            break;
+    }
+    saveShared(expr.shared_, dst);
+}
+
+void CEmitter::visitBinaryExpression(const BinaryExpression& expr) {
+    uint32_t dst = frame_.dst;
+    const Token& op = expr.operator_token_;
+    bool logical = operatorInfo(op.getType()).kind == OperatorKind::LOGICAL;
+    std::string logicalCheck = "MS_LOGICAL(" + opNumber(op.getType()) + ", " + reg(dst) + ", " + position(op.getLine(), op.getColumn()) + ");";
+    if (frame_.step == Step::ENTER) {
+        if (reuseShared(expr.shared_, dst)) return;
+        if (expr.numeric_ && !logical && numericExpression(expr, dst)) {
+            saveShared(expr.shared_, dst);
+            return;
+        }
+        if (logical) {
+            frames_.push_back({&expr, Step::LOGICAL_RIGHT, dst});
+        } else {
+            frames_.push_back({&expr, Step::EXIT, dst});
+            frames_.push_back({expr.right_, Step::ENTER, dst + 1});
+        }
+        frames_.push_back({expr.left_, Step::ENTER, dst});
+    } else if (frame_.step == Step::LOGICAL_RIGHT) {
+        // Левый операнд в dst: правый вычисляется, только если левый не решает результат
+        bool is_or = op.getType() == TokenType::KEYWORD_OR || op.getType() == TokenType::OPERATOR_OR;
+        line(logicalCheck);
+        line("if (" + reg(dst) + (is_or ? " == MS_FALSE) {" : " == MS_TRUE) {"));
+        logical_depth_++;
+        frames_.push_back({&expr, Step::EXIT, dst});
+        frames_.push_back({expr.right_, Step::ENTER, dst});
+    } else if (logical) {
+        line(logicalCheck);
+        logical_depth_--;
+        line("}");
+        saveShared(expr.shared_, dst); // Оба пути сходятся здесь
+    } else {
+        binary(op.getType(), dst, dst + 1, dst, op, expr.numeric_);
+        saveShared(expr.shared_, dst);
+    }
+}
+
+void CEmitter::visitAssignmentExpression(const AssignmentExpression& expr) {
+    uint32_t dst = frame_.dst;
+    if (frame_.step == Step::ENTER) {
+        frames_.push_back({&expr, Step::EXIT, dst});
+        frames_.push_back({expr.value_, Step::ENTER, dst});
+        return;
+    }
+    variable(expr.depth_, expr.slot_, expr.getName());
+    std::string slot = std::to_string(expr.slot_);
+    const Token& op = expr.operator_token_;
+    if (op.getType() != TokenType::OPERATOR_ASSIGN) {
+        // x += v: значение уже в dst, текущее x читается после него (как в дереве)
+        registers_ = std::max(registers_, dst + 2);
+        if (!defined_[expr.slot_]) {
+            line("if (!d" + slot + ") MS_UNDEFINED(" + quoted(variables_[expr.slot_]) + ", " + position(op.getLine(), op.getColumn()) + ");");
+        }
+        line(reg(dst + 1) + " = v" + slot + ";");
+        binary(compoundBaseOperator(op.getType()), dst + 1, dst, dst, op, false);
+    }
+    // Строку из другой переменной или временную runtime должен держать сам: код ссылок не считает.
+    // Он же отпускает строку, которую переменная держала до этого, чем бы ее ни заменили
+    line("if (!ms_is_plain(v" + slot + ") || !ms_is_plain(" + reg(dst) + ")) rt->store(rt->context, " + slot + ", " + reg(dst) + ");");
+    line("v" + slot + " = " + reg(dst) + "; d" + slot + " = 1;");
+    if (logical_depth_ == 0) defined_[expr.slot_] = 1;
+}
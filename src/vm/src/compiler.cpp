@@ -0,0 +1,162 @@
+#include "../include/compiler.hpp"
+#include "../../parser/include/operator_table.hpp"
+
+namespace {
+
+OpCode binaryOpCode(TokenType op) {
+    switch (op) {
+        case TokenType::OPERATOR_PLUS:  return OpCode::ADD;
+        case TokenType::OPERATOR_MINUS: return OpCode::SUBTRACT;
+        case TokenType::OPERATOR_MUL:   return OpCode::MULTIPLY;
+        case TokenType::OPERATOR_DIV:   return OpCode::DIVIDE;
+        case TokenType::OPERATOR_MOD:   return OpCode::MODULO;
+        case TokenType::OPERATOR_POW:   return OpCode::POWER;
+        case TokenType::OPERATOR_EQ:    return OpCode::EQUAL;
+        case TokenType::OPERATOR_NE:    return OpCode::NOT_EQUAL;
+        case TokenType::OPERATOR_LT:    return OpCode::LESS;
+        case TokenType::OPERATOR_LE:    return OpCode::LESS_EQUAL;
+        case TokenType::OPERATOR_GT:    return OpCode::GREATER;
+        default:                        return OpCode::GREATER_EQUAL; // OPERATOR_GE
+    }
+}
+
+// Команда без проверок типов для операндов-чисел (узел numeric_); OpCode::RETURN - такой нет
+OpCode numberOpCode(TokenType op) {
+    switch (op) {
+        case TokenType::OPERATOR_PLUS:  return OpCode::ADD_N;
+        case TokenType::OPERATOR_MINUS: return OpCode::SUBTRACT_N;
+        case TokenType::OPERATOR_MUL:   return OpCode::MULTIPLY_N;
+        case TokenType::OPERATOR_DIV:   return OpCode::DIVIDE_N;
+        case TokenType::OPERATOR_LT:    return OpCode::LESS_N;
+        case TokenType::OPERATOR_LE:    return OpCode::LESS_EQUAL_N;
+        case TokenType::OPERATOR_GT:    return OpCode::GREATER_N;
+        case TokenType::OPERATOR_GE:    return OpCode::GREATER_EQUAL_N;
+        default:                        return OpCode::RETURN;
+    }
+}
+
+SourceInfo sourceOf(const Token& token) {
+    return {token.getType(), token.getLine(), token.getColumn()};
+}
+
+} // namespace
+
+void Compiler::compile(const IStatement& statement, Chunk& chunk) {
+    chunk.clear();
+    uint32_t result = 0;
+    switch (statement.kind()) {
+        case StatementKind::EXPRESSION: {
+            const ExpressionStatement& expression_statement = static_cast<const ExpressionStatement&>(statement);
+            result = expression_statement.shared_; // Регистры 0..shared_-1 - общие значения
+            compiled_.assign(expression_statement.shared_, 0);
+            compileExpression(*expression_statement.expression_, result, chunk);
+            break;
+        }
+    }
+    chunk.emit(OpCode::RETURN, result);
+    if (peephole_) optimizer_.optimize(chunk);
+}
+
+bool Compiler::reuseShared(uint32_t shared, uint32_t dst, Chunk& chunk) {
+    if (shared == kNotShared || !compiled_[shared]) return false;
+    chunk.emit(OpCode::MOVE, dst, shared);
+    return true;
+}
+
+void Compiler::saveShared(uint32_t shared, uint32_t dst, Chunk& chunk) {
+    if (shared == kNotShared) return;
+    chunk.emit(OpCode::MOVE, shared, dst);
+    compiled_[shared] = 1;
+}
+
+void Compiler::compileExpression(const IExpression& root, uint32_t dst, Chunk& chunk) {
+    frames_.push_back({&root, Step::ENTER, dst, 0});
+    while (!frames_.empty()) {
+        Frame frame = frames_.back();
+        frames_.pop_back();
+        const IExpression* node = frame.node;
+        uint32_t dst = frame.dst;
+        chunk.useRegisters(dst + 1);
+
+        switch (node->kind()) {
+            case ExpressionKind::NUMERIC:
+                chunk.emit(OpCode::LOAD_CONST, dst, chunk.addConstant(static_cast<const NumericLiteral*>(node)->value_));
+                break;
+            case ExpressionKind::STRING:
+                chunk.emit(OpCode::LOAD_CONST, dst, chunk.addConstant(static_cast<const StringLiteral*>(node)->string_));
+                break;
+            case ExpressionKind::BOOLEAN:
+                chunk.emit(OpCode::LOAD_CONST, dst, chunk.addConstant(static_cast<const BooleanLiteral*>(node)->value_));
+                break;
+            case ExpressionKind::IDENTIFIER: {
+                const IdentifierExpression* id = static_cast<const IdentifierExpression*>(node);
+                chunk.setSymbolTable(*id->symbols_);
+                chunk.emit(OpCode::LOAD_VAR, dst, globalSlot(id->depth_, id->slot_), id->symbol_, {TokenType::IDENTIFIER, id->line_, id->column_});
+                break;
+            }
+            case ExpressionKind::UNARY: {
+                const UnaryExpression* unary = static_cast<const UnaryExpression*>(node);
+                if (frame.step == Step::ENTER) {
+                    if (reuseShared(unary->shared_, dst, chunk)) break;
+                    frames_.push_back({node, Step::EXIT, dst, 0});
+                    frames_.push_back({unary->right_, Step::ENTER, dst, 0});
+                } else {
+                    const Token& op = unary->operator_token_;
+                    OpCode code = op.getType() == TokenType::OPERATOR_MINUS ? (unary->numeric_ ? OpCode::NEGATE_N : OpCode::NEGATE) : OpCode::NOT;
+                    chunk.emit(code, dst, dst, 0, sourceOf(op));
+                    saveShared(unary->shared_, dst, chunk);
+                }
+                break;
+            }
+            case ExpressionKind::BINARY: {
+                const BinaryExpression* binary = static_cast<const BinaryExpression*>(node);
+                const Token& op = binary->operator_token_;
+                bool logical = operatorInfo(op.getType()).kind == OperatorKind::LOGICAL;
+                if (frame.step == Step::ENTER) {
+                    if (reuseShared(binary->shared_, dst, chunk)) break;
+                    if (logical) {
+                        frames_.push_back({node, Step::LOGICAL_JUMP, dst, 0});
+                    } else {
+                        frames_.push_back({node, Step::EXIT, dst, 0});
+                        frames_.push_back({binary->right_, Step::ENTER, dst + 1, 0});
+                    }
+                    frames_.push_back({binary->left_, Step::ENTER, dst, 0});
+                } else if (frame.step == Step::LOGICAL_JUMP) {
+                    // Левый операнд в dst: если он уже решает результат, правый пропускается
+                    bool is_or = op.getType() == TokenType::KEYWORD_OR || op.getType() == TokenType::OPERATOR_OR;
+                    size_t jump = chunk.emit(is_or ? OpCode::JUMP_IF_TRUE : OpCode::JUMP_IF_FALSE, dst, 0, 0, sourceOf(op));
+                    frames_.push_back({node, Step::EXIT, dst, jump});
+                    frames_.push_back({binary->right_, Step::ENTER, dst, 0});
+                } else if (logical) {
+                    chunk.emit(OpCode::CHECK_BOOL, dst, 0, 0, sourceOf(op));
+                    chunk.setJumpTarget(frame.jump, chunk.code().size());
+                    saveShared(binary->shared_, dst, chunk); // Оба пути сходятся здесь
+                } else {
+                    OpCode code = binary->numeric_ ? numberOpCode(op.getType()) : OpCode::RETURN;
+                    if (code == OpCode::RETURN) code = binaryOpCode(op.getType()); // % ** == != - общие команды
+                    chunk.emit(code, dst, dst, dst + 1, sourceOf(op));
+                    saveShared(binary->shared_, dst, chunk);
+                }
+                break;
+            }
+            case ExpressionKind::ASSIGNMENT: {
+                const AssignmentExpression* assign = static_cast<const AssignmentExpression*>(node);
+                if (frame.step == Step::ENTER) {
+                    frames_.push_back({node, Step::EXIT, dst, 0});
+                    frames_.push_back({assign->value_, Step::ENTER, dst, 0});
+                    break;
+                }
+                const Token& op = assign->operator_token_;
+                if (op.getType() != TokenType::OPERATOR_ASSIGN) {
+                    chunk.setSymbolTable(*assign->symbols_);
+                    // x += v: значение уже в dst, текущее x читается после него (как в дереве)
+                    chunk.useRegisters(dst + 2);
+                    chunk.emit(OpCode::LOAD_VAR, dst + 1, globalSlot(assign->depth_, assign->slot_), assign->symbol_, sourceOf(op));
+                    chunk.emit(binaryOpCode(compoundBaseOperator(op.getType())), dst, dst + 1, dst, sourceOf(op));
+                }
+                chunk.emit(OpCode::STORE_VAR, dst, globalSlot(assign->depth_, assign->slot_));
+                break;
+            }
+        }
+    }
+}
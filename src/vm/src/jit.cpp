@@ -0,0 +1,490 @@
+#include "../include/jit.hpp"
+
+#ifdef MATHSOL_JIT
+
+#include <algorithm>
+#include <bit>
+#include <cmath>
+#include "../include/x64_assembler.hpp"
+
+namespace {
+
+constexpr uint32_t kFirstXmm = 2;  // xmm0 и xmm1 - рабочие регистры команд
+constexpr uint32_t kXmmCount = 14;
+constexpr uint32_t kNone = UINT32_MAX;
+
+// bool в ключе кэша: NaN, которого нет среди чисел Value (они приводятся к каноническому)
+constexpr uint64_t kFalseBits = 0xFFF4000000000000;
+
+bool between(OpCode op, OpCode first, OpCode last) {
+    return op >= first && op <= last;
+}
+
+// Правый операнд бинарной команды - константа K[c]
+bool constantRight(OpCode op) {
+    return between(op, OpCode::ADD_K, OpCode::GREATER_EQUAL_K) ||
+           between(op, OpCode::LESS_K_JUMP, OpCode::GREATER_EQUAL_K_JUMP) ||
+           between(op, OpCode::ADD_VAR_K, OpCode::DIVIDE_VAR_K) ||
+           between(op, OpCode::ADD_NK, OpCode::GREATER_EQUAL_NK);
+}
+
+// Левый операнд и результат - переменная в слоте b (x op= K[c])
+bool variableLeft(OpCode op) {
+    return between(op, OpCode::ADD_VAR_K, OpCode::DIVIDE_VAR_K);
+}
+
+// Биты константы для ключа; false - не число и не bool (такой код не компилируется)
+bool constantBits(const Value& value, uint64_t& bits) {
+    if (value.isNumber()) bits = std::bit_cast<uint64_t>(value.asNumber());
+    else if (value.isBool()) bits = kFalseBits | static_cast<uint64_t>(value.asBool());
+    else return false;
+    return true;
+}
+
+// Ключ chunk: константы в порядке ссылок на них; false - среди них есть строка
+bool keyConstants(const Chunk& chunk, std::vector<uint64_t>& constants) {
+    constants.clear();
+    for (const Instruction& in : chunk.code()) {
+        uint32_t index;
+        if (in.op == OpCode::LOAD_CONST) index = in.b;
+        else if (constantRight(in.op)) index = in.c;
+        else continue;
+        uint64_t bits;
+        if (!constantBits(chunk.constant(index), bits)) return false;
+        constants.push_back(bits);
+    }
+    return true;
+}
+
+// FNV-1a по командам и константам
+uint64_t hashKey(const std::vector<Instruction>& code, const std::vector<uint64_t>& constants) {
+    uint64_t hash = 0xCBF29CE484222325;
+    auto mix = [&hash](uint64_t value) {
+        hash ^= value;
+        hash *= 0x100000001B3;
+    };
+    for (const Instruction& in : code) {
+        mix(static_cast<uint64_t>(in.op) << 32 | in.a);
+        mix(static_cast<uint64_t>(in.b) << 32 | in.c);
+    }
+    for (uint64_t bits : constants) mix(bits);
+    return hash;
+}
+
+bool sameCode(const std::vector<Instruction>& left, const std::vector<Instruction>& right) {
+    return std::equal(left.begin(), left.end(), right.begin(), right.end(),
+                      [](const Instruction& l, const Instruction& r) {
+                          return l.op == r.op && l.a == r.a && l.b == r.b && l.c == r.c;
+                      });
+}
+
+// Функции для команд с вызовом: их адрес зашивается в код
+double moduloOf(double l, double r) { return std::fmod(l, r); }
+double powerOf(double l, double r) { return power(l, r); }
+
+// Команда байткода в виде, общем для всех её вариантов (OP, OP_K, OP_N, OP_NK, OP_VAR_K,
+// *_JUMP): операнды - места (регистр r или registerCount + номер переменной) или константы
+struct Source {
+    bool constant;  // index - номер константы chunk, иначе место
+    uint32_t index;
+};
+
+struct Step {
+    enum Form : uint8_t { COPY, ARITHMETIC, CALL, EQUALITY, COMPARE, NEGATE, NOT, JUMP, CHECK, RETURN };
+    Form form;
+    TokenType op = TokenType::_EOF;
+    uint32_t dst = kNone;
+    Source left{false, 0};
+    Source right{false, 0};
+    uint32_t also = kNone;  // OP_VAR_K: результат пишется и в переменную
+    bool mixed = false;     // EQUALITY: операнды разных видов, результат известен заранее
+};
+
+Step::Form binaryForm(TokenType op) {
+    switch (op) {
+        case TokenType::OPERATOR_PLUS:
+        case TokenType::OPERATOR_MINUS:
+        case TokenType::OPERATOR_MUL:
+        case TokenType::OPERATOR_DIV: return Step::ARITHMETIC;
+        case TokenType::OPERATOR_MOD:
+        case TokenType::OPERATOR_POW: return Step::CALL;
+        case TokenType::OPERATOR_EQ:
+        case TokenType::OPERATOR_NE:  return Step::EQUALITY;
+        default:                      return Step::COMPARE;
+    }
+}
+
+X64Assembler::Sse sseOf(TokenType op) {
+    switch (op) {
+        case TokenType::OPERATOR_PLUS:  return X64Assembler::ADDSD;
+        case TokenType::OPERATOR_MINUS: return X64Assembler::SUBSD;
+        case TokenType::OPERATOR_MUL:   return X64Assembler::MULSD;
+        default:                        return X64Assembler::DIVSD; // OPERATOR_DIV
+    }
+}
+
+} // namespace
+
+Jit::Jit(Environment& env) : env_(env), memory_(std::make_unique<ExecutableMemory>()) {}
+
+Jit::~Jit() = default;
+
+bool Jit::available() {
+    return true;
+}
+
+Jit::Kind Jit::kindOf(uint32_t slot) const {
+    if (!env_.isDefined(0, slot)) return Kind::UNDEFINED;
+    const Value& value = env_.value(0, slot);
+    if (value.isNumber()) return Kind::NUMBER;
+    if (value.isBool()) return Kind::BOOLEAN;
+    return Kind::UNKNOWN;
+}
+
+bool Jit::run(const Chunk& chunk, Value& result) {
+    if (!keyConstants(chunk, constants_)) return false;
+    if (bodies_ >= kMaxCompiled || compiled_.size() >= kMaxCompiled) {
+        compiled_.clear();
+        memory_->clear();
+        bodies_ = 0;
+    }
+
+    uint64_t hash = hashKey(chunk.code(), constants_);
+    auto found = compiled_.find(hash);
+    if (found == compiled_.end()) {
+        if (hot_.size() >= kHotTableSize) hot_.clear(); // Новое поколение
+        uint8_t& count = hot_[hash];
+        if (++count < kHotCount) return false;
+        hot_.erase(hash);
+        found = compiled_.emplace(hash, Compiled{}).first;
+        found->second.code = chunk.code();
+        found->second.constants = constants_;
+        compile(chunk, found->second);
+    } else if (!sameCode(found->second.code, chunk.code()) || found->second.constants != constants_) {
+        return false; // Другой код с тем же хэшем
+    }
+    Compiled& entry = found->second;
+
+    // Виды переменных должны совпасть с теми, для которых собран код; иначе после
+    // kHotCount отказов подряд код собирается заново под новые виды
+    for (const Variable& input : entry.inputs) {
+        if (kindOf(input.slot) != input.kind) {
+            if (++entry.misses >= kHotCount) compile(chunk, entry);
+            return false;
+        }
+    }
+    entry.misses = 0;
+    if (!entry.native) return false;
+
+    if (frame_.size() < entry.frame_size) frame_.resize(entry.frame_size);
+    double* frame = frame_.data();
+    for (size_t i = 0; i < entry.inputs.size(); i++) {
+        const Variable& input = entry.inputs[i];
+        if (input.kind == Kind::NUMBER) frame[i] = env_.value(0, input.slot).asNumber();
+        else if (input.kind == Kind::BOOLEAN) frame[i] = env_.value(0, input.slot).asBool();
+    }
+    double value = entry.native(frame);
+    for (const Variable& output : entry.outputs) {
+        double cell = frame[output.slot];
+        uint32_t slot = entry.inputs[output.slot].slot;
+        if (output.kind == Kind::NUMBER) env_.assign(0, slot, Value(cell));
+        else env_.assign(0, slot, Value(cell != 0));
+    }
+    result = entry.result == Kind::NUMBER ? Value(value) : Value(value != 0);
+    return true;
+}
+
+void Jit::compile(const Chunk& chunk, Compiled& entry) {
+    entry.native = nullptr;
+    entry.inputs.clear();
+    entry.outputs.clear();
+    entry.result = Kind::UNKNOWN;
+    entry.misses = 0;
+
+    const std::vector<Instruction>& code = chunk.code();
+    const uint32_t registers = chunk.registerCount();
+
+    // Места переменных: registers + индекс в inputs (по первому упоминанию)
+    auto variable = [&](uint32_t slot) {
+        for (uint32_t i = 0; i < entry.inputs.size(); i++) {
+            if (entry.inputs[i].slot == slot) return registers + i;
+        }
+        entry.inputs.push_back({slot, kindOf(slot)});
+        return registers + static_cast<uint32_t>(entry.inputs.size() - 1);
+    };
+
+    std::vector<Step> steps;
+    steps.reserve(code.size());
+    for (const Instruction& in : code) {
+        Step step{Step::COPY};
+        switch (in.op) {
+            case OpCode::LOAD_CONST: step.dst = in.a; step.left = {true, in.b}; break;
+            case OpCode::LOAD_VAR:   step.dst = in.a; step.left = {false, variable(in.b)}; break;
+            case OpCode::STORE_VAR:  step.dst = variable(in.b); step.left = {false, in.a}; break;
+            case OpCode::MOVE:       step.dst = in.a; step.left = {false, in.b}; break;
+            case OpCode::NEGATE:
+            case OpCode::NEGATE_N:   step = {Step::NEGATE, TokenType::_EOF, in.a, {false, in.b}}; break;
+            case OpCode::NOT:        step = {Step::NOT, TokenType::_EOF, in.a, {false, in.b}}; break;
+            case OpCode::JUMP_IF_FALSE:
+            case OpCode::JUMP_IF_TRUE:
+                // dst - адрес перехода, op - переход по true (OPERATOR_OR) или false
+                step = {Step::JUMP, in.op == OpCode::JUMP_IF_TRUE ? TokenType::OPERATOR_OR : TokenType::OPERATOR_AND,
+                        in.b, {false, in.a}};
+                break;
+            case OpCode::CHECK_BOOL: step = {Step::CHECK, TokenType::_EOF, kNone, {false, in.a}}; break;
+            case OpCode::RETURN:     step = {Step::RETURN, TokenType::_EOF, kNone, {false, in.a}}; break;
+            default:
+                // Бинарные команды; у *_JUMP переход - следующая команда, она компилируется отдельно
+                step.op = binaryOperator(in.op);
+                step.form = binaryForm(step.op);
+                step.dst = in.a;
+                step.left = {false, variableLeft(in.op) ? variable(in.b) : in.b};
+                step.right = {constantRight(in.op), in.c};
+                if (variableLeft(in.op)) step.also = step.left.index;
+                break;
+        }
+        steps.push_back(step);
+    }
+    const uint32_t places = registers + static_cast<uint32_t>(entry.inputs.size());
+
+    // Вывод видов: переходы только вперед, поэтому хватает одного прохода, в котором
+    // состояние в начале команды - слияние всех путей к ней (разные виды дают UNKNOWN)
+    auto constantKind = [&](uint32_t index) {
+        const Value& value = chunk.constant(index);
+        return value.isNumber() ? Kind::NUMBER : value.isBool() ? Kind::BOOLEAN : Kind::UNKNOWN;
+    };
+    auto isValue = [](Kind kind) { return kind == Kind::NUMBER || kind == Kind::BOOLEAN; };
+    auto merge = [](std::vector<Kind>& into, const std::vector<Kind>& from) {
+        for (size_t i = 0; i < into.size(); i++) {
+            if (into[i] != from[i]) into[i] = Kind::UNKNOWN;
+        }
+    };
+
+    std::vector<Kind> state(places, Kind::UNDEFINED);
+    for (size_t i = 0; i < entry.inputs.size(); i++) state[registers + i] = entry.inputs[i].kind;
+    std::vector<std::vector<Kind>> incoming(steps.size());
+    std::vector<uint8_t> stored(entry.inputs.size(), 0);
+    std::vector<uint32_t> uses(places, 0);
+    bool reachable = true;
+    bool calls = false;
+    bool returned = false;
+
+    for (size_t pc = 0; pc < steps.size(); pc++) {
+        Step& step = steps[pc];
+        if (!incoming[pc].empty()) {
+            if (reachable) merge(state, incoming[pc]);
+            else state = incoming[pc];
+            reachable = true;
+        }
+        if (!reachable) continue;
+
+        Kind left = step.left.constant ? constantKind(step.left.index) : state[step.left.index];
+        Kind right = step.right.constant ? constantKind(step.right.index) : state[step.right.index];
+        if (!step.left.constant) uses[step.left.index]++;
+        if (step.dst != kNone && step.form != Step::JUMP) uses[step.dst]++;
+
+        Kind kind = Kind::UNKNOWN; // Вид результата
+        switch (step.form) {
+            case Step::COPY:
+                if (!isValue(left)) return;
+                kind = left;
+                break;
+            case Step::CALL:
+                calls = true;
+                [[fallthrough]];
+            case Step::ARITHMETIC:
+            case Step::COMPARE:
+                if (left != Kind::NUMBER || right != Kind::NUMBER) return;
+                kind = step.form == Step::COMPARE ? Kind::BOOLEAN : Kind::NUMBER;
+                break;
+            case Step::EQUALITY:
+                if (!isValue(left) || !isValue(right)) return;
+                step.mixed = left != right;
+                kind = Kind::BOOLEAN;
+                break;
+            case Step::NEGATE:
+                if (left != Kind::NUMBER) return;
+                kind = Kind::NUMBER;
+                break;
+            case Step::NOT:
+                if (left != Kind::BOOLEAN) return;
+                kind = Kind::BOOLEAN;
+                break;
+            case Step::JUMP:
+                if (left != Kind::BOOLEAN || step.dst <= pc || step.dst >= steps.size()) return;
+                if (incoming[step.dst].empty()) incoming[step.dst] = state;
+                else merge(incoming[step.dst], state);
+                continue;
+            case Step::CHECK:
+                if (left != Kind::BOOLEAN) return;
+                continue;
+            case Step::RETURN: {
+                // Все RETURN должны давать одинаковые виды результата и присвоенных переменных
+                if (!isValue(left) || (returned && left != entry.result)) return;
+                entry.result = left;
+                size_t output = 0;
+                for (uint32_t i = 0; i < stored.size(); i++) {
+                    if (!stored[i]) continue;
+                    Variable assigned{i, state[registers + i]};
+                    if (!isValue(assigned.kind)) return;
+                    if (!returned) entry.outputs.push_back(assigned);
+                    else if (output >= entry.outputs.size() || entry.outputs[output].slot != i ||
+                             entry.outputs[output].kind != assigned.kind) return;
+                    output++;
+                }
+                if (output != entry.outputs.size()) return;
+                returned = true;
+                reachable = false;
+                continue;
+            }
+        }
+        if (!step.right.constant && step.form != Step::COPY && step.form != Step::NEGATE && step.form != Step::NOT) {
+            uses[step.right.index]++;
+        }
+        state[step.dst] = kind;
+        if (step.dst >= registers) stored[step.dst - registers] = 1;
+        if (step.also != kNone) {
+            state[step.also] = kind;
+            stored[step.also - registers] = 1;
+        }
+    }
+    if (!returned) return;
+
+    // Размещение: самые используемые места - в xmm2..xmm15, остальные - в кадре. Переменные
+    // всегда имеют ячейку кадра (индекс в inputs): через неё они читаются и записываются
+    std::vector<uint32_t> order(places);
+    for (uint32_t i = 0; i < places; i++) order[i] = i;
+    std::stable_sort(order.begin(), order.end(), [&uses](uint32_t l, uint32_t r) { return uses[l] > uses[r]; });
+    std::vector<X64Assembler::Operand> home(places);
+    std::vector<uint8_t> in_xmm(places, 0);
+    uint32_t xmm = 0;
+    uint32_t cells = static_cast<uint32_t>(entry.inputs.size());
+    for (uint32_t place : order) {
+        if (!calls && xmm < kXmmCount && uses[place] > 0) {
+            home[place] = X64Assembler::xmm(kFirstXmm + xmm++);
+            in_xmm[place] = 1;
+        } else if (place >= registers) {
+            home[place] = X64Assembler::frame(place - registers);
+        } else {
+            home[place] = X64Assembler::frame(cells++);
+        }
+    }
+    entry.frame_size = cells;
+
+    X64Assembler a;
+    auto source = [&](const Source& s) {
+        if (!s.constant) return home[s.index];
+        const Value& value = chunk.constant(s.index);
+        return a.constant(value.isNumber() ? value.asNumber() : value.asBool() ? 1.0 : 0.0);
+    };
+    // dst = src; через xmm0, если оба в памяти
+    auto copy = [&](X64Assembler::Operand dst, X64Assembler::Operand src) {
+        if (dst.kind == X64Assembler::Operand::XMM) a.load(dst.index, src);
+        else if (src.kind == X64Assembler::Operand::XMM) a.store(dst, src.index);
+        else {
+            a.load(0, src);
+            a.store(dst, 0);
+        }
+    };
+
+    a.prologue();
+    for (uint32_t i = 0; i < entry.inputs.size(); i++) {
+        uint32_t place = registers + i;
+        if (in_xmm[place] && isValue(entry.inputs[i].kind)) a.load(home[place].index, X64Assembler::frame(i));
+    }
+    for (uint32_t pc = 0; pc < steps.size(); pc++) {
+        const Step& step = steps[pc];
+        a.bind(pc);
+        switch (step.form) {
+            case Step::COPY:
+                copy(home[step.dst], source(step.left));
+                continue;
+            case Step::ARITHMETIC:
+                a.load(0, source(step.left));
+                a.arithmetic(sseOf(step.op), 0, source(step.right));
+                break;
+            case Step::CALL:
+                a.load(0, source(step.left));
+                a.load(1, source(step.right));
+                a.call(step.op == TokenType::OPERATOR_MOD ? moduloOf : powerOf);
+                break;
+            case Step::EQUALITY:
+                if (step.mixed) {
+                    a.load(0, a.constant(step.op == TokenType::OPERATOR_NE ? 1.0 : 0.0));
+                    break;
+                }
+                // ucomisd: неупорядоченные (NaN) дают ZF = PF = 1
+                a.load(0, source(step.left));
+                a.compare(0, source(step.right));
+                if (step.op == TokenType::OPERATOR_EQ) {
+                    a.setAl(X64Assembler::EQUAL);
+                    a.setCl(X64Assembler::NOT_PARITY);
+                    a.andAlCl();
+                } else {
+                    a.setAl(X64Assembler::NOT_EQUAL);
+                    a.setCl(X64Assembler::PARITY);
+                    a.orAlCl();
+                }
+                a.boolFromAl(0);
+                break;
+            case Step::COMPARE: {
+                // l < r считается как r > l: above/above_equal ложны для NaN
+                bool swap = step.op == TokenType::OPERATOR_LT || step.op == TokenType::OPERATOR_LE;
+                a.load(0, source(swap ? step.right : step.left));
+                a.compare(0, source(swap ? step.left : step.right));
+                bool strict = step.op == TokenType::OPERATOR_LT || step.op == TokenType::OPERATOR_GT;
+                a.setAl(strict ? X64Assembler::ABOVE : X64Assembler::ABOVE_EQUAL);
+                a.boolFromAl(0);
+                break;
+            }
+            case Step::NEGATE:
+                a.load(0, source(step.left));
+                a.negate(0, 1);
+                break;
+            case Step::NOT:
+                a.load(0, a.constant(1.0));
+                a.arithmetic(X64Assembler::SUBSD, 0, source(step.left));
+                break;
+            case Step::JUMP:
+                a.testOperand(source(step.left));
+                a.jump(step.op == TokenType::OPERATOR_OR ? X64Assembler::NOT_EQUAL : X64Assembler::EQUAL, step.dst);
+                continue;
+            case Step::CHECK:
+                continue;
+            case Step::RETURN:
+                a.load(0, source(step.left));
+                for (const Variable& output : entry.outputs) {
+                    uint32_t place = registers + output.slot;
+                    if (in_xmm[place]) a.store(X64Assembler::frame(output.slot), home[place].index);
+                }
+                a.epilogue();
+                continue;
+        }
+        a.store(home[step.dst], 0);
+        if (step.also != kNone) a.store(home[step.also], 0);
+    }
+
+    const void* native = memory_->add(a.finish());
+    if (!native) return;
+    entry.native = reinterpret_cast<double (*)(double*)>(const_cast<void*>(native));
+    bodies_++;
+}
+
+#else // MATHSOL_JIT
+
+// Сборка без JIT: run всегда отказывается, код выполняет VM
+class ExecutableMemory {};
+
+Jit::Jit(Environment& env) : env_(env) {}
+
+Jit::~Jit() = default;
+
+bool Jit::available() {
+    return false;
+}
+
+bool Jit::run(const Chunk&, Value&) {
+    return false;
+}
+
+#endif // MATHSOL_JIT
@@ -0,0 +1,150 @@
+#include "../include/peephole.hpp"
+
+namespace {
+
+bool isJump(OpCode op) {
+    return op == OpCode::JUMP_IF_FALSE || op == OpCode::JUMP_IF_TRUE;
+}
+
+// Бинарная команда с константой вместо правого регистра (OP -> OP_K)
+bool constantForm(OpCode op, OpCode& fused) {
+    switch (op) {
+        case OpCode::ADD:           fused = OpCode::ADD_K; return true;
+        case OpCode::SUBTRACT:      fused = OpCode::SUBTRACT_K; return true;
+        case OpCode::MULTIPLY:      fused = OpCode::MULTIPLY_K; return true;
+        case OpCode::DIVIDE:        fused = OpCode::DIVIDE_K; return true;
+        case OpCode::LESS:          fused = OpCode::LESS_K; return true;
+        case OpCode::LESS_EQUAL:    fused = OpCode::LESS_EQUAL_K; return true;
+        case OpCode::GREATER:       fused = OpCode::GREATER_K; return true;
+        case OpCode::GREATER_EQUAL: fused = OpCode::GREATER_EQUAL_K; return true;
+        case OpCode::ADD_N:           fused = OpCode::ADD_NK; return true;
+        case OpCode::SUBTRACT_N:      fused = OpCode::SUBTRACT_NK; return true;
+        case OpCode::MULTIPLY_N:      fused = OpCode::MULTIPLY_NK; return true;
+        case OpCode::DIVIDE_N:        fused = OpCode::DIVIDE_NK; return true;
+        case OpCode::LESS_N:          fused = OpCode::LESS_NK; return true;
+        case OpCode::LESS_EQUAL_N:    fused = OpCode::LESS_EQUAL_NK; return true;
+        case OpCode::GREATER_N:       fused = OpCode::GREATER_NK; return true;
+        case OpCode::GREATER_EQUAL_N: fused = OpCode::GREATER_EQUAL_NK; return true;
+        default:                    return false;
+    }
+}
+
+// Сравнение, за которым сразу идет условный переход (OP -> OP_JUMP). У сравнений чисел
+// без проверок (OP_N) отдельного варианта нет: переход в одной команде выгоднее
+bool jumpForm(OpCode op, OpCode& fused) {
+    switch (op) {
+        case OpCode::LESS:
+        case OpCode::LESS_N:           fused = OpCode::LESS_JUMP; return true;
+        case OpCode::LESS_EQUAL:
+        case OpCode::LESS_EQUAL_N:     fused = OpCode::LESS_EQUAL_JUMP; return true;
+        case OpCode::GREATER:
+        case OpCode::GREATER_N:        fused = OpCode::GREATER_JUMP; return true;
+        case OpCode::GREATER_EQUAL:
+        case OpCode::GREATER_EQUAL_N:  fused = OpCode::GREATER_EQUAL_JUMP; return true;
+        case OpCode::LESS_K:
+        case OpCode::LESS_NK:          fused = OpCode::LESS_K_JUMP; return true;
+        case OpCode::LESS_EQUAL_K:
+        case OpCode::LESS_EQUAL_NK:    fused = OpCode::LESS_EQUAL_K_JUMP; return true;
+        case OpCode::GREATER_K:
+        case OpCode::GREATER_NK:       fused = OpCode::GREATER_K_JUMP; return true;
+        case OpCode::GREATER_EQUAL_K:
+        case OpCode::GREATER_EQUAL_NK: fused = OpCode::GREATER_EQUAL_K_JUMP; return true;
+        default:                      return false;
+    }
+}
+
+// x op= k (OP -> OP_VAR_K)
+bool variableForm(OpCode op, OpCode& fused) {
+    switch (op) {
+        case OpCode::ADD:      fused = OpCode::ADD_VAR_K; return true;
+        case OpCode::SUBTRACT: fused = OpCode::SUBTRACT_VAR_K; return true;
+        case OpCode::MULTIPLY: fused = OpCode::MULTIPLY_VAR_K; return true;
+        case OpCode::DIVIDE:   fused = OpCode::DIVIDE_VAR_K; return true;
+        default:               return false;
+    }
+}
+
+} // namespace
+
+void PeepholeOptimizer::emit(const Instruction& instruction, const SourceInfo& info) {
+    code_.push_back(instruction);
+    infos_.push_back(info);
+}
+
+void PeepholeOptimizer::optimize(Chunk& chunk) {
+    const std::vector<Instruction>& code = chunk.code();
+    size_t size = code.size();
+
+    targeted_.assign(size + 1, 0);
+    bool has_jumps = false;
+    for (const Instruction& in : code) {
+        if (isJump(in.op)) {
+            targeted_[in.b] = 1;
+            has_jumps = true;
+        }
+    }
+
+    // Внутрь последовательности [pc, pc + length) не ведет ни один переход
+    auto straight = [&](size_t pc, size_t length) {
+        for (size_t i = pc + 1; i < pc + length; i++) {
+            if (targeted_[i]) return false;
+        }
+        return true;
+    };
+
+    code_.clear();
+    infos_.clear();
+    remap_.resize(size + 1);
+    size_t pc = 0;
+    while (pc < size) {
+        const Instruction& in = code[pc];
+        uint32_t at = static_cast<uint32_t>(code_.size());
+        remap_[pc] = at;
+        OpCode fused;
+
+        if (in.op == OpCode::LOAD_CONST && pc + 3 < size && straight(pc, 4)) {
+            // x op= k: LOAD_CONST r k; LOAD_VAR r+1 s; OP r r+1 r; STORE_VAR r s
+            const Instruction& load = code[pc + 1];
+            const Instruction& op = code[pc + 2];
+            const Instruction& store = code[pc + 3];
+            if (load.op == OpCode::LOAD_VAR && load.a == in.a + 1 &&
+                variableForm(op.op, fused) && op.a == in.a && op.b == load.a && op.c == in.a &&
+                store.op == OpCode::STORE_VAR && store.a == in.a && store.b == load.b) {
+                SourceInfo info = chunk.info(pc + 2);
+                info.name = load.c;
+                emit({fused, in.a, load.b, in.b}, info);
+                pc += 4;
+                continue;
+            }
+        }
+
+        Instruction current = in;
+        SourceInfo info = chunk.info(pc);
+        size_t next = pc + 1;
+        if (in.op == OpCode::LOAD_CONST && next < size && straight(pc, 2)) {
+            // LOAD_CONST r k; OP d x r
+            const Instruction& op = code[next];
+            if (constantForm(op.op, fused) && op.c == in.a && op.b != in.a) {
+                current = {fused, op.a, op.b, in.b};
+                info = chunk.info(next);
+                remap_[next] = at;
+                next++;
+            }
+        }
+        if (has_jumps && next < size && jumpForm(current.op, fused) && !targeted_[next]) {
+            // Сравнение в r; JUMP_IF_* r: переход остается следующей командой
+            const Instruction& jump = code[next];
+            if (isJump(jump.op) && jump.a == current.a) current.op = fused;
+        }
+        emit(current, info);
+        pc = next;
+    }
+    remap_[size] = static_cast<uint32_t>(code_.size());
+
+    if (has_jumps) {
+        for (Instruction& in : code_) {
+            if (isJump(in.op)) in.b = remap_[in.b];
+        }
+    }
+    chunk.swapCode(code_, infos_);
+}
@@ -0,0 +1,475 @@
+#include "../include/script_cache.hpp"
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cmath>
+#include <cstring>
+#include <filesystem>
+#include <random>
+
+namespace {
+
+constexpr char kMagic[8] = {'M', 'S', 'O', 'L', 'B', 'C', '0', '1'};
+
+constexpr uint64_t kFnvOffset = 14695981039346656037ull;
+constexpr uint64_t kFnvPrime = 1099511628211ull;
+
+// Тег сведений об исходнике: у команды SourceInfo{} (op больше ERROR не бывает)
+constexpr uint8_t kNoSource = 0xFF;
+static_assert(static_cast<uint8_t>(TokenType::ERROR) < kNoSource);
+
+// Теги констант
+enum ConstantTag : uint8_t { NUMBER, FALSE, TRUE, INTEGER, STRING };
+
+uint64_t fnv(uint64_t hash, const void* data, size_t size) {
+    const unsigned char* bytes = static_cast<const unsigned char*>(data);
+    for (size_t i = 0; i < size; ++i) {
+        hash ^= bytes[i];
+        hash *= kFnvPrime;
+    }
+    return hash;
+}
+
+// Что означает операнд команды (см. таблицу в bytecode.hpp)
+enum class Operand : uint8_t { NONE, REGISTER, CONSTANT, SLOT, TARGET, NAME };
+using Operands = std::array<Operand, 3>;
+
+Operands operandKinds(OpCode op) {
+    constexpr Operand N = Operand::NONE, R = Operand::REGISTER, K = Operand::CONSTANT;
+    constexpr Operand S = Operand::SLOT, T = Operand::TARGET, I = Operand::NAME;
+    switch (op) {
+        case OpCode::LOAD_CONST:    return {R, K, N};
+        case OpCode::LOAD_VAR:      return {R, S, I};
+        case OpCode::STORE_VAR:     return {R, S, N};
+        case OpCode::MOVE:
+        case OpCode::NEGATE:
+        case OpCode::NOT:
+        case OpCode::NEGATE_N:      return {R, R, N};
+        case OpCode::JUMP_IF_FALSE:
+        case OpCode::JUMP_IF_TRUE:  return {R, T, N};
+        case OpCode::CHECK_BOOL:
+        case OpCode::RETURN:        return {R, N, N};
+        case OpCode::ADD_K:
+        case OpCode::SUBTRACT_K:
+        case OpCode::MULTIPLY_K:
+        case OpCode::DIVIDE_K:
+        case OpCode::LESS_K:
+        case OpCode::LESS_EQUAL_K:
+        case OpCode::GREATER_K:
+        case OpCode::GREATER_EQUAL_K:
+        case OpCode::LESS_K_JUMP:
+        case OpCode::LESS_EQUAL_K_JUMP:
+        case OpCode::GREATER_K_JUMP:
+        case OpCode::GREATER_EQUAL_K_JUMP:
+        case OpCode::ADD_NK:
+        case OpCode::SUBTRACT_NK:
+        case OpCode::MULTIPLY_NK:
+        case OpCode::DIVIDE_NK:
+        case OpCode::LESS_NK:
+        case OpCode::LESS_EQUAL_NK:
+        case OpCode::GREATER_NK:
+        case OpCode::GREATER_EQUAL_NK: return {R, R, K};
+        case OpCode::ADD_VAR_K:
+        case OpCode::SUBTRACT_VAR_K:
+        case OpCode::MULTIPLY_VAR_K:
+        case OpCode::DIVIDE_VAR_K:  return {R, S, K};
+        default:                    return {R, R, R}; // Бинарные, *_JUMP и *_N
+    }
+}
+
+bool isVarK(OpCode op) {
+    return op >= OpCode::ADD_VAR_K && op <= OpCode::DIVIDE_VAR_K;
+}
+
+// Сравнения, которые выполняются вместе со следующей командой JUMP_IF_*
+bool isFusedJump(OpCode op) {
+    return op >= OpCode::LESS_JUMP && op <= OpCode::GREATER_EQUAL_K_JUMP;
+}
+
+void putVarint(std::string& out, uint64_t value) {
+    while (value >= 0x80) {
+        out.push_back(static_cast<char>(value | 0x80));
+        value >>= 7;
+    }
+    out.push_back(static_cast<char>(value));
+}
+
+uint64_t zigzag(int64_t value) {
+    return (static_cast<uint64_t>(value) << 1) ^ static_cast<uint64_t>(value >> 63);
+}
+
+int64_t unzigzag(uint64_t value) {
+    return static_cast<int64_t>(value >> 1) ^ -static_cast<int64_t>(value & 1);
+}
+
+void putText(std::string& out, std::string_view text) {
+    putVarint(out, text.size());
+    out.append(text);
+}
+
+// Целые числа (счетчики, большинство литералов) короче восьми байт double
+bool isSmallInteger(double number) {
+    return std::trunc(number) == number && std::fabs(number) < 9007199254740992.0 &&
+           !(number == 0 && std::signbit(number));
+}
+
+} // namespace
+
+uint64_t scriptCacheKey(std::istream& source, std::string_view version, uint32_t options) {
+    uint64_t hash = kFnvOffset;
+    char block[64 * 1024];
+    while (source.read(block, sizeof(block)) || source.gcount() > 0) {
+        hash = fnv(hash, block, static_cast<size_t>(source.gcount()));
+    }
+    hash = fnv(hash, version.data(), version.size());
+    hash = fnv(hash, kMagic, sizeof(kMagic));
+    return fnv(hash, &options, sizeof(options));
+}
+
+// ---- Запись ----
+
+CompiledScriptWriter::~CompiledScriptWriter() {
+    discard();
+}
+
+bool CompiledScriptWriter::open(const std::string& path) {
+    path_ = path;
+    checksum_ = kFnvOffset;
+    temporary_ = path + ".tmp" + std::to_string(std::random_device{}());
+    out_.open(temporary_, std::ios::binary | std::ios::trunc);
+    if (!out_.is_open()) {
+        temporary_.clear();
+        return false;
+    }
+    // Место под заголовок; finish() запишет его, когда будут известны размеры
+    CompiledScript::Header header{};
+    out_.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    return static_cast<bool>(out_);
+}
+
+uint32_t CompiledScriptWriter::symbolIndex(Symbol symbol) {
+    auto [it, inserted] = symbol_index_.try_emplace(symbol, static_cast<uint32_t>(symbol_index_.size()));
+    if (inserted) new_names_.push_back(symbol);
+    return it->second;
+}
+
+void CompiledScriptWriter::add(const Chunk& chunk, bool print) {
+    if (temporary_.empty()) return;
+    const std::vector<Instruction>& code = chunk.code();
+
+    body_.clear();
+    putVarint(body_, print ? 1 : 0);
+    putVarint(body_, chunk.registerCount());
+    putVarint(body_, chunk.constantCount());
+    for (uint32_t i = 0; i < chunk.constantCount(); ++i) {
+        const Value& value = chunk.constant(i);
+        if (value.isString()) {
+            body_.push_back(STRING);
+            putText(body_, value.asString());
+        } else if (value.isBool()) {
+            body_.push_back(value.asBool() ? TRUE : FALSE);
+        } else if (isSmallInteger(value.asNumber())) {
+            body_.push_back(INTEGER);
+            putVarint(body_, zigzag(static_cast<int64_t>(value.asNumber())));
+        } else {
+            body_.push_back(NUMBER);
+            uint64_t bits = value.raw();
+            body_.append(reinterpret_cast<const char*>(&bits), sizeof(bits));
+        }
+    }
+    putVarint(body_, code.size());
+    for (size_t pc = 0; pc < code.size(); ++pc) {
+        const Instruction& instruction = code[pc];
+        body_.push_back(static_cast<char>(instruction.op));
+        Operands kinds = operandKinds(instruction.op);
+        const uint32_t operands[3] = {instruction.a, instruction.b, instruction.c};
+        for (int i = 0; i < 3; ++i) {
+            if (kinds[i] == Operand::NONE) continue;
+            uint32_t operand = operands[i];
+            if (kinds[i] == Operand::NAME) operand = symbolIndex(operand);
+            if (kinds[i] == Operand::SLOT && operand >= slots_) slots_ = operand + 1;
+            putVarint(body_, operand);
+        }
+
+        const SourceInfo& info = chunk.info(pc);
+        if (info.op == TokenType::_EOF && info.line == 0 && info.column == 0) {
+            body_.push_back(static_cast<char>(kNoSource));
+        } else {
+            body_.push_back(static_cast<char>(info.op));
+            putVarint(body_, zigzag(static_cast<int64_t>(info.line) - line_));
+            putVarint(body_, info.column);
+            line_ = info.line;
+        }
+        if (isVarK(instruction.op)) putVarint(body_, symbolIndex(info.name));
+    }
+
+    putVarint(buffer_, new_names_.size());
+    for (Symbol symbol : new_names_) putText(buffer_, chunk.symbols().name(symbol));
+    new_names_.clear();
+    buffer_.append(body_);
+    ++statements_;
+    if (buffer_.size() >= kFlushSize) flush();
+}
+
+void CompiledScriptWriter::flush() {
+    checksum_ = fnv(checksum_, buffer_.data(), buffer_.size());
+    out_.write(buffer_.data(), static_cast<std::streamsize>(buffer_.size()));
+    payload_ += buffer_.size();
+    buffer_.clear();
+}
+
+bool CompiledScriptWriter::finish(uint64_t key) {
+    if (temporary_.empty()) return false;
+    flush();
+    CompiledScript::Header header{};
+    std::memcpy(header.magic, kMagic, sizeof(kMagic));
+    header.key = key;
+    header.statements = statements_;
+    header.payload = payload_;
+    header.checksum = checksum_;
+    header.slots = slots_;
+    out_.seekp(0);
+    out_.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    out_.close();
+    if (!out_) {
+        discard();
+        return false;
+    }
+    std::error_code error;
+    std::filesystem::rename(temporary_, path_, error);
+    if (error) {
+        discard();
+        return false;
+    }
+    temporary_.clear();
+    return true;
+}
+
+void CompiledScriptWriter::discard() {
+    if (temporary_.empty()) return;
+    if (out_.is_open()) out_.close();
+    std::error_code ignored;
+    std::filesystem::remove(temporary_, ignored);
+    temporary_.clear();
+}
+
+// ---- Чтение ----
+
+uint8_t CompiledScript::Cursor::byte() {
+    if (at == end) {
+        ok = false;
+        return 0;
+    }
+    return *at++;
+}
+
+uint64_t CompiledScript::Cursor::varint() {
+    uint64_t value = 0;
+    for (int shift = 0; shift < 64; shift += 7) {
+        uint8_t next = byte();
+        value |= static_cast<uint64_t>(next & 0x7F) << shift;
+        if (!(next & 0x80)) return value;
+    }
+    ok = false;
+    return 0;
+}
+
+uint32_t CompiledScript::Cursor::u32() {
+    uint64_t value = varint();
+    if (value > UINT32_MAX) ok = false;
+    return static_cast<uint32_t>(value);
+}
+
+std::string_view CompiledScript::Cursor::bytes(uint64_t count) {
+    if (count > static_cast<uint64_t>(end - at)) {
+        ok = false;
+        return {};
+    }
+    std::string_view text(reinterpret_cast<const char*>(at), count);
+    at += count;
+    return text;
+}
+
+bool CompiledScript::open(const std::string& path, uint64_t key, SymbolTable& symbols) {
+    if (!mapped_.open(path)) return false;
+    std::string_view view = mapped_.view();
+    if (view.size() < sizeof(Header)) return false;
+    std::memcpy(&header_, view.data(), sizeof(header_));
+    if (std::memcmp(header_.magic, kMagic, sizeof(kMagic)) != 0 || header_.key != key ||
+        header_.payload != view.size() - sizeof(Header) || header_.slots > header_.payload) {
+        mapped_.close();
+        return false;
+    }
+    payload_ = reinterpret_cast<const uint8_t*>(view.data()) + sizeof(Header);
+    symbol_table_ = &symbols;
+    symbols_.clear();
+
+    uint64_t checksum = kFnvOffset;
+    for (size_t at = 0; at < header_.payload; at += kReleaseStep) {
+        size_t size = std::min<size_t>(kReleaseStep, header_.payload - at);
+        checksum = fnv(checksum, payload_ + at, size);
+        mapped_.release(sizeof(Header) + at + size);
+    }
+    if (checksum != header_.checksum) {
+        mapped_.close();
+        return false;
+    }
+
+    // Все записи разбираются разбираются с проверками, имена интернируются
+    Cursor cursor{payload_, payload_ + header_.payload};
+    Chunk scratch;
+    bool print = false;
+    line_ = 0;
+    for (uint64_t i = 0; i < header_.statements; ++i) {
+        if (!decode(cursor, scratch, print, true)) {
+            mapped_.close();
+            return false;
+        }
+        offset_ = static_cast<size_t>(cursor.at - payload_);
+        release();
+    }
+    if (cursor.at != cursor.end) {
+        mapped_.close();
+        return false;
+    }
+
+    offset_ = 0;
+    released_ = 0;
+    remaining_ = header_.statements;
+    line_ = 0;
+    names_ = 0;
+    damaged_ = false;
+    return true;
+}
+
+bool CompiledScript::next(Chunk& chunk, bool& print) {
+    if (remaining_ == 0 || damaged_) return false;
+    Cursor cursor{payload_ + offset_, payload_ + header_.payload};
+    if (!decode(cursor, chunk, print, false)) {
+        damaged_ = true;
+        return false;
+    }
+    offset_ = static_cast<size_t>(cursor.at - payload_);
+    --remaining_;
+    release();
+    return true;
+}
+
+void CompiledScript::release() {
+    if (offset_ - released_ < kReleaseStep) return;
+    mapped_.release(sizeof(Header) + offset_);
+    released_ = offset_;
+}
+
+bool CompiledScript::decode(Cursor& cursor, Chunk& chunk, bool& print, bool intern) {
+    // Новые имена. При выполнении они уже интернированы первым проходом: сверяются
+    // только их номера
+    uint64_t name_count = cursor.varint();
+    if (name_count > static_cast<uint64_t>(cursor.end - cursor.at)) return false;
+    for (uint64_t i = 0; i < name_count; ++i) {
+        std::string_view name = cursor.bytes(cursor.varint());
+        if (!cursor.ok) return false;
+        if (intern) symbols_.push_back(symbol_table_->intern(name));
+    }
+    if (!intern) {
+        names_ += name_count;
+        if (names_ > symbols_.size()) return false;
+    }
+    size_t known_names = intern ? symbols_.size() : names_;
+
+    chunk.clear();
+    uint64_t flags = cursor.varint();
+    if (flags > 1) return false;
+    print = flags != 0;
+    uint64_t registers = cursor.varint();
+
+    uint64_t constant_count = cursor.varint();
+    if (!cursor.ok || constant_count > static_cast<uint64_t>(cursor.end - cursor.at)) return false;
+    for (uint64_t i = 0; i < constant_count; ++i) {
+        uint8_t tag = cursor.byte();
+        Value value;
+        switch (tag) {
+            case NUMBER: {
+                std::string_view bytes = cursor.bytes(sizeof(uint64_t));
+                uint64_t bits = 0;
+                if (cursor.ok) std::memcpy(&bits, bytes.data(), sizeof(bits));
+                value = Value(std::bit_cast<double>(bits)); // Value(double) не даст NaN стать ссылкой
+                break;
+            }
+            case FALSE:   value = Value(false); break;
+            case TRUE:    value = Value(true); break;
+            case INTEGER: value = Value(static_cast<double>(unzigzag(cursor.varint()))); break;
+            case STRING: {
+                std::string_view text = cursor.bytes(cursor.varint());
+                if (cursor.ok && !intern) value = Value(InternedString::intern(text));
+                break;
+            }
+            default: return false;
+        }
+        if (!cursor.ok) return false;
+        if (!intern) chunk.addConstant(std::move(value));
+    }
+
+    uint64_t code_count = cursor.varint();
+    if (!cursor.ok || code_count == 0 || code_count > static_cast<uint64_t>(cursor.end - cursor.at) ||
+        registers == 0 || registers > 3 * code_count + 1) {
+        return false;
+    }
+    for (uint64_t pc = 0; pc < code_count; ++pc) {
+        uint8_t op_byte = cursor.byte();
+        if (op_byte >= kOpCodeCount) return false;
+        OpCode op = static_cast<OpCode>(op_byte);
+        Operands kinds = operandKinds(op);
+        uint32_t operands[3] = {0, 0, 0};
+        for (int i = 0; i < 3; ++i) {
+            if (kinds[i] == Operand::NONE) continue;
+            uint32_t operand = cursor.u32();
+            switch (kinds[i]) {
+                case Operand::REGISTER: if (operand >= registers) return false; break;
+                case Operand::CONSTANT: if (operand >= constant_count) return false; break;
+                case Operand::SLOT:     if (operand >= header_.slots) return false; break;
+                case Operand::TARGET:   if (operand >= code_count) return false; break;
+                case Operand::NAME:
+                    if (operand >= known_names) return false;
+                    operand = symbols_[operand];
+                    break;
+                case Operand::NONE:     break;
+            }
+            operands[i] = operand;
+        }
+
+        SourceInfo info;
+        uint8_t token = cursor.byte();
+        if (token != kNoSource) {
+            if (token > static_cast<uint8_t>(TokenType::ERROR)) return false;
+            int64_t line = line_ + unzigzag(cursor.varint());
+            uint64_t column = cursor.varint();
+            if (line < 0 || line > UINT32_MAX || column > UINT32_MAX) return false;
+            info.op = static_cast<TokenType>(token);
+            info.line = static_cast<uint32_t>(line);
+            info.column = static_cast<uint32_t>(column);
+            line_ = line;
+        }
+        if (isVarK(op)) {
+            uint32_t name = cursor.u32();
+            if (name >= known_names) return false;
+            info.name = symbols_[name];
+        }
+        if (!cursor.ok) return false;
+        chunk.emit(op, operands[0], operands[1], operands[2], info);
+    }
+
+    // Сравнение *_JUMP выполняет и следующую за ним команду перехода; код кончается RETURN
+    const std::vector<Instruction>& code = chunk.code();
+    for (size_t pc = 0; pc < code.size(); ++pc) {
+        if (!isFusedJump(code[pc].op)) continue;
+        if (pc + 1 == code.size()) return false;
+        OpCode jump = code[pc + 1].op;
+        if (jump != OpCode::JUMP_IF_FALSE && jump != OpCode::JUMP_IF_TRUE) return false;
+    }
+    if (code.back().op != OpCode::RETURN) return false;
+
+    chunk.useRegisters(static_cast<uint32_t>(registers));
+    chunk.setSymbolTable(*symbol_table_);
+    return true;
+}
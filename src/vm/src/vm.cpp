@@ -0,0 +1,241 @@
+#include "../include/vm.hpp"
+#include <cmath>
+
+// Два способа выбора обработчика команды (см. MATHSOL_COMPUTED_GOTO в CMakeLists.txt):
+//  - computed goto (расширение GCC/Clang): каждый обработчик сам прыгает на следующий по
+//    таблице адресов меток, так что у каждой команды своя точка косвенного перехода и
+//    предсказатель переходов учится на парах "команда -> следующая команда";
+//  - переносимый switch в цикле: одна общая точка выбора для всех команд.
+// Обработчики одинаковы для обоих способов и записаны через макросы VM_*.
+#ifdef MATHSOL_COMPUTED_GOTO
+#define VM_OP(opcode) op_##opcode
+#define VM_DISPATCH() goto *labels[static_cast<size_t>(in->op)]
+#else
+#define VM_OP(opcode) case OpCode::opcode
+#define VM_DISPATCH() goto dispatch
+#endif
+#define VM_NEXT() do { in++; VM_DISPATCH(); } while (0)
+
+namespace {
+
+// Оба операнда - числа: результат считается без вызова applyBinary
+bool numbers(const Value& left, const Value& right, double& l, double& r) {
+    if (!left.isNumber() || !right.isNumber()) return false;
+    l = left.asNumber();
+    r = right.asNumber();
+    return true;
+}
+
+// Медленные пути вынесены из цикла, чтобы не раздувать обработчики
+
+[[gnu::noinline]] Value binarySlow(const Chunk& chunk, size_t pc, const Value& left, const Value& right) {
+    return applyBinary(binaryOperator(chunk.code()[pc].op), left, right, chunk.where(pc));
+}
+
+[[gnu::noinline]] Value unarySlow(const Chunk& chunk, size_t pc, const Value& operand) {
+    return applyUnary(chunk.info(pc).op, operand, chunk.where(pc));
+}
+
+// Сравнение + переход (*_JUMP): результат сравнения проверяет команда перехода pc + 1
+[[gnu::noinline]] bool compareJumpSlow(const Chunk& chunk, size_t pc, Value& dst, const Value& left, const Value& right) {
+    dst = binarySlow(chunk, pc, left, right);
+    return logicalOperand(dst, chunk.where(pc + 1));
+}
+
+} // namespace
+
+Value VirtualMachine::run(const Chunk& chunk) {
+    if (registers_.size() < chunk.registerCount()) registers_.resize(chunk.registerCount());
+    Value* R = registers_.data();
+    const Instruction* code = chunk.code().data();
+    const Instruction* in = code;
+
+#ifdef MATHSOL_COMPUTED_GOTO
+    // В порядке OpCode
+    static void* const labels[] = {
+        &&op_LOAD_CONST, &&op_LOAD_VAR, &&op_STORE_VAR, &&op_MOVE,
+        &&op_ADD, &&op_SUBTRACT, &&op_MULTIPLY, &&op_DIVIDE, &&op_MODULO, &&op_POWER,
+        &&op_EQUAL, &&op_NOT_EQUAL, &&op_LESS, &&op_LESS_EQUAL, &&op_GREATER, &&op_GREATER_EQUAL,
+        &&op_NEGATE, &&op_NOT, &&op_JUMP_IF_FALSE, &&op_JUMP_IF_TRUE, &&op_CHECK_BOOL, &&op_RETURN,
+        &&op_ADD_K, &&op_SUBTRACT_K, &&op_MULTIPLY_K, &&op_DIVIDE_K,
+        &&op_LESS_K, &&op_LESS_EQUAL_K, &&op_GREATER_K, &&op_GREATER_EQUAL_K,
+        &&op_LESS_JUMP, &&op_LESS_EQUAL_JUMP, &&op_GREATER_JUMP, &&op_GREATER_EQUAL_JUMP,
+        &&op_LESS_K_JUMP, &&op_LESS_EQUAL_K_JUMP, &&op_GREATER_K_JUMP, &&op_GREATER_EQUAL_K_JUMP,
+        &&op_ADD_VAR_K, &&op_SUBTRACT_VAR_K, &&op_MULTIPLY_VAR_K, &&op_DIVIDE_VAR_K,
+        &&op_ADD_N, &&op_SUBTRACT_N, &&op_MULTIPLY_N, &&op_DIVIDE_N,
+        &&op_LESS_N, &&op_LESS_EQUAL_N, &&op_GREATER_N, &&op_GREATER_EQUAL_N, &&op_NEGATE_N,
+        &&op_ADD_NK, &&op_SUBTRACT_NK, &&op_MULTIPLY_NK, &&op_DIVIDE_NK,
+        &&op_LESS_NK, &&op_LESS_EQUAL_NK, &&op_GREATER_NK, &&op_GREATER_EQUAL_NK,
+    };
+    static_assert(sizeof(labels) / sizeof(labels[0]) == kOpCodeCount, "labels must cover every OpCode");
+    VM_DISPATCH();
+#else
+dispatch:
+    switch (in->op) {
+#endif
+
+// R[a] = R[b] op R[c]; для двух чисел - expr, иначе applyBinary
+#define VM_BINARY(opcode, expr)                                                    \
+    VM_OP(opcode): {                                                               \
+        double l, r;                                                             \
+        if (numbers(R[in->b], R[in->c], l, r)) R[in->a] = (expr);                \
+        else R[in->a] = binarySlow(chunk, in - code, R[in->b], R[in->c]);        \
+        VM_NEXT();                                                               \
+    }
+// R[a] = R[b] op K[c]
+#define VM_BINARY_K(opcode, expr)                                                  \
+    VM_OP(opcode): {                                                               \
+        double l, r;                                                             \
+        const Value& k = chunk.constant(in->c);                                  \
+        if (numbers(R[in->b], k, l, r)) R[in->a] = (expr);                       \
+        else R[in->a] = binarySlow(chunk, in - code, R[in->b], k);               \
+        VM_NEXT();                                                               \
+    }
+// Сравнение и переход по следующей команде JUMP_IF_FALSE/TRUE (правый операнд - right)
+#define VM_COMPARE_JUMP(opcode, right, expr)                                       \
+    VM_OP(opcode): {                                                               \
+        double l, r;                                                             \
+        const Value& rv = (right);                                               \
+        bool result;                                                             \
+        if (numbers(R[in->b], rv, l, r)) R[in->a] = result = (expr);             \
+        else result = compareJumpSlow(chunk, in - code, R[in->a], R[in->b], rv); \
+        const Instruction* jump = in + 1;                                        \
+        if (result == (jump->op == OpCode::JUMP_IF_TRUE)) in = code + jump->b;   \
+        else in += 2;                                                            \
+        VM_DISPATCH();                                                           \
+    }
+// x op= K[c] для переменной в слоте b: сначала значение x, затем операция (как в дереве)
+#define VM_VAR_K(opcode, expr)                                                     \
+    VM_OP(opcode): {                                                               \
+        const SourceInfo& source = chunk.info(in - code);                        \
+        const Value& x = env_.get(0, in->b, chunk.symbols(), source.name, source.line, source.column); \
+        const Value& k = chunk.constant(in->c);                                  \
+        double l, r;                                                             \
+        if (numbers(x, k, l, r)) R[in->a] = (expr);                              \
+        else R[in->a] = binarySlow(chunk, in - code, x, k);                      \
+        env_.assign(0, in->b, R[in->a]);                                         \
+        VM_NEXT();                                                               \
+    }
+// Операнды - заведомо числа (OP_N, OP_NK): без проверок типов
+#define VM_NUMBER(opcode, expr)                                                    \
+    VM_OP(opcode): {                                                               \
+        double l = R[in->b].asNumber(), r = R[in->c].asNumber();                 \
+        R[in->a] = (expr);                                                       \
+        VM_NEXT();                                                               \
+    }
+#define VM_NUMBER_K(opcode, expr)                                                  \
+    VM_OP(opcode): {                                                               \
+        double l = R[in->b].asNumber(), r = chunk.constant(in->c).asNumber();    \
+        R[in->a] = (expr);                                                       \
+        VM_NEXT();                                                               \
+    }
+
+    VM_OP(LOAD_CONST):
+        R[in->a] = chunk.constant(in->b);
+        VM_NEXT();
+    VM_OP(LOAD_VAR): {
+        const SourceInfo& source = chunk.info(in - code);
+        R[in->a] = env_.get(0, in->b, chunk.symbols(), in->c, source.line, source.column);
+        VM_NEXT();
+    }
+    VM_OP(STORE_VAR):
+        env_.assign(0, in->b, R[in->a]);
+        VM_NEXT();
+    VM_OP(MOVE):
+        R[in->a] = R[in->b];
+        VM_NEXT();
+
+    // Арифметика и сравнения: быстрый путь для двух чисел
+    VM_BINARY(ADD, l + r)
+    VM_BINARY(SUBTRACT, l - r)
+    VM_BINARY(MULTIPLY, l * r)
+    VM_BINARY(DIVIDE, l / r)
+    VM_BINARY(MODULO, std::fmod(l, r))
+    VM_BINARY(POWER, power(l, r))
+    VM_BINARY(LESS, l < r)
+    VM_BINARY(LESS_EQUAL, l <= r)
+    VM_BINARY(GREATER, l > r)
+    VM_BINARY(GREATER_EQUAL, l >= r)
+    VM_OP(EQUAL):
+    VM_OP(NOT_EQUAL):
+        R[in->a] = binarySlow(chunk, in - code, R[in->b], R[in->c]);
+        VM_NEXT();
+
+    VM_OP(NEGATE):
+        if (R[in->b].isNumber()) R[in->a] = -R[in->b].asNumber();
+        else R[in->a] = unarySlow(chunk, in - code, R[in->b]);
+        VM_NEXT();
+    VM_OP(NOT):
+        R[in->a] = unarySlow(chunk, in - code, R[in->b]);
+        VM_NEXT();
+
+    VM_OP(JUMP_IF_FALSE):
+        if (!logicalOperand(R[in->a], chunk.where(in - code))) in = code + in->b;
+        else in++;
+        VM_DISPATCH();
+    VM_OP(JUMP_IF_TRUE):
+        if (logicalOperand(R[in->a], chunk.where(in - code))) in = code + in->b;
+        else in++;
+        VM_DISPATCH();
+    VM_OP(CHECK_BOOL):
+        logicalOperand(R[in->a], chunk.where(in - code));
+        VM_NEXT();
+
+    VM_OP(RETURN):
+        return std::move(R[in->a]);
+
+    // Суперинструкции
+    VM_BINARY_K(ADD_K, l + r)
+    VM_BINARY_K(SUBTRACT_K, l - r)
+    VM_BINARY_K(MULTIPLY_K, l * r)
+    VM_BINARY_K(DIVIDE_K, l / r)
+    VM_BINARY_K(LESS_K, l < r)
+    VM_BINARY_K(LESS_EQUAL_K, l <= r)
+    VM_BINARY_K(GREATER_K, l > r)
+    VM_BINARY_K(GREATER_EQUAL_K, l >= r)
+    VM_COMPARE_JUMP(LESS_JUMP, R[in->c], l < r)
+    VM_COMPARE_JUMP(LESS_EQUAL_JUMP, R[in->c], l <= r)
+    VM_COMPARE_JUMP(GREATER_JUMP, R[in->c], l > r)
+    VM_COMPARE_JUMP(GREATER_EQUAL_JUMP, R[in->c], l >= r)
+    VM_COMPARE_JUMP(LESS_K_JUMP, chunk.constant(in->c), l < r)
+    VM_COMPARE_JUMP(LESS_EQUAL_K_JUMP, chunk.constant(in->c), l <= r)
+    VM_COMPARE_JUMP(GREATER_K_JUMP, chunk.constant(in->c), l > r)
+    VM_COMPARE_JUMP(GREATER_EQUAL_K_JUMP, chunk.constant(in->c), l >= r)
+    VM_VAR_K(ADD_VAR_K, l + r)
+    VM_VAR_K(SUBTRACT_VAR_K, l - r)
+    VM_VAR_K(MULTIPLY_VAR_K, l * r)
+    VM_VAR_K(DIVIDE_VAR_K, l / r)
+
+    // Над числами без проверок типов
+    VM_NUMBER(ADD_N, l + r)
+    VM_NUMBER(SUBTRACT_N, l - r)
+    VM_NUMBER(MULTIPLY_N, l * r)
+    VM_NUMBER(DIVIDE_N, l / r)
+    VM_NUMBER(LESS_N, l < r)
+    VM_NUMBER(LESS_EQUAL_N, l <= r)
+    VM_NUMBER(GREATER_N, l > r)
+    VM_NUMBER(GREATER_EQUAL_N, l >= r)
+    VM_OP(NEGATE_N):
+        R[in->a] = -R[in->b].asNumber();
+        VM_NEXT();
+    VM_NUMBER_K(ADD_NK, l + r)
+    VM_NUMBER_K(SUBTRACT_NK, l - r)
+    VM_NUMBER_K(MULTIPLY_NK, l * r)
+    VM_NUMBER_K(DIVIDE_NK, l / r)
+    VM_NUMBER_K(LESS_NK, l < r)
+    VM_NUMBER_K(LESS_EQUAL_NK, l <= r)
+    VM_NUMBER_K(GREATER_NK, l > r)
+    VM_NUMBER_K(GREATER_EQUAL_NK, l >= r)
+
+#ifndef MATHSOL_COMPUTED_GOTO
+    }
+    return Value(); // Недостижимо: код всегда заканчивается RETURN
+#endif
+
+#undef VM_BINARY
+#undef VM_BINARY_K
+#undef VM_COMPARE_JUMP
+#undef VM_VAR_K
+#undef VM_NUMBER
+#undef VM_NUMBER_K
+}
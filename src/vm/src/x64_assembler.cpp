@@ -0,0 +1,213 @@
+#include "../include/x64_assembler.hpp"
+#include <bit>
+#include <cstring>
+#include <sys/mman.h>
+
+X64Assembler::Operand X64Assembler::constant(double value) {
+    uint64_t bits = std::bit_cast<uint64_t>(value);
+    for (size_t i = 0; i < constants_.size(); i++) {
+        if (constants_[i] == bits) return {Operand::CONSTANT, static_cast<uint32_t>(i)};
+    }
+    constants_.push_back(bits);
+    return {Operand::CONSTANT, static_cast<uint32_t>(constants_.size() - 1)};
+}
+
+void X64Assembler::dword(uint32_t value) {
+    for (int i = 0; i < 4; i++) byte(static_cast<uint8_t>(value >> (8 * i)));
+}
+
+void X64Assembler::qword(uint64_t value) {
+    for (int i = 0; i < 8; i++) byte(static_cast<uint8_t>(value >> (8 * i)));
+}
+
+void X64Assembler::instruction(uint8_t prefix, uint8_t opcode, uint32_t reg, Operand rm, bool wide) {
+    if (prefix) byte(prefix);
+    uint8_t rex = 0x40 | (wide ? 0x08 : 0) | (reg >= 8 ? 0x04 : 0);
+    if (rm.kind == Operand::XMM && rm.index >= 8) rex |= 0x01;
+    if (rex != 0x40) byte(rex);
+    byte(0x0F);
+    byte(opcode);
+    uint8_t r = static_cast<uint8_t>((reg & 7) << 3);
+    switch (rm.kind) {
+        case Operand::XMM:
+            byte(0xC0 | r | (rm.index & 7));
+            break;
+        case Operand::FRAME: {
+            uint32_t displacement = rm.index * 8;
+            if (displacement < 128) {
+                byte(0x43 | r); // [rbx + disp8]
+                byte(static_cast<uint8_t>(displacement));
+            } else {
+                byte(0x83 | r); // [rbx + disp32]
+                dword(displacement);
+            }
+            break;
+        }
+        case Operand::CONSTANT:
+            byte(0x05 | r); // [rip + disp32]
+            constant_patches_.push_back({code_.size(), rm.index});
+            dword(0);
+            break;
+    }
+}
+
+void X64Assembler::movRaxImmediate(uint64_t value) {
+    byte(0x48); // mov rax, imm64
+    byte(0xB8);
+    qword(value);
+}
+
+void X64Assembler::prologue() {
+    byte(0x53); // push rbx: заодно выравнивает стек на 16 для вызовов
+    byte(0x48); // mov rbx, rdi
+    byte(0x89);
+    byte(0xFB);
+}
+
+void X64Assembler::epilogue() {
+    byte(0x5B); // pop rbx
+    byte(0xC3); // ret
+}
+
+void X64Assembler::load(uint32_t dst, Operand src) {
+    if (src.kind == Operand::XMM && src.index == dst) return;
+    instruction(0xF2, 0x10, dst, src);
+}
+
+void X64Assembler::store(Operand dst, uint32_t src) {
+    if (dst.kind == Operand::XMM) {
+        load(dst.index, xmm(src));
+        return;
+    }
+    instruction(0xF2, 0x11, src, dst);
+}
+
+void X64Assembler::arithmetic(Sse op, uint32_t dst, Operand src) {
+    instruction(0xF2, op, dst, src);
+}
+
+void X64Assembler::compare(uint32_t left, Operand right) {
+    instruction(0x66, 0x2E, left, right);
+}
+
+void X64Assembler::negate(uint32_t dst, uint32_t scratch) {
+    movRaxImmediate(0x8000000000000000ull);
+    instruction(0x66, 0x6E, scratch, xmm(0), true); // movq scratch, rax
+    instruction(0x66, 0x57, dst, xmm(scratch));     // xorpd
+}
+
+void X64Assembler::setAl(Condition condition) {
+    byte(0x0F);
+    byte(0x90 | condition);
+    byte(0xC0);
+}
+
+void X64Assembler::setCl(Condition condition) {
+    byte(0x0F);
+    byte(0x90 | condition);
+    byte(0xC1);
+}
+
+void X64Assembler::andAlCl() {
+    byte(0x20);
+    byte(0xC8);
+}
+
+void X64Assembler::orAlCl() {
+    byte(0x08);
+    byte(0xC8);
+}
+
+void X64Assembler::boolFromAl(uint32_t dst) {
+    byte(0x0F); // movzx eax, al
+    byte(0xB6);
+    byte(0xC0);
+    instruction(0xF2, 0x2A, dst, xmm(0)); // cvtsi2sd xmm, eax
+}
+
+void X64Assembler::testAl() {
+    byte(0x84);
+    byte(0xC0);
+}
+
+void X64Assembler::testOperand(Operand operand) {
+    if (operand.kind == Operand::XMM) {
+        instruction(0x66, 0x7E, operand.index, xmm(0), true); // movq rax, xmm
+    } else {
+        // mov rax, [rbx + disp] - без префикса 0F, поэтому кодируется отдельно
+        uint32_t displacement = operand.index * 8;
+        byte(0x48);
+        byte(0x8B);
+        if (displacement < 128) {
+            byte(0x43);
+            byte(static_cast<uint8_t>(displacement));
+        } else {
+            byte(0x83);
+            dword(displacement);
+        }
+    }
+    byte(0x48); // test rax, rax
+    byte(0x85);
+    byte(0xC0);
+}
+
+void X64Assembler::call(double (*function)(double, double)) {
+    movRaxImmediate(reinterpret_cast<uint64_t>(function));
+    byte(0xFF); // call rax
+    byte(0xD0);
+}
+
+void X64Assembler::jump(Condition condition, uint32_t label) {
+    byte(0x0F);
+    byte(0x80 | condition);
+    jump_patches_.push_back({code_.size(), label});
+    dword(0);
+}
+
+void X64Assembler::bind(uint32_t label) {
+    if (labels_.size() <= label) labels_.resize(label + 1, 0);
+    labels_[label] = code_.size();
+}
+
+const std::vector<uint8_t>& X64Assembler::finish() {
+    // Смещения отсчитываются от конца инструкции, а disp32/rel32 у нас всегда последние
+    auto patch = [this](size_t position, size_t target) {
+        uint32_t relative = static_cast<uint32_t>(static_cast<int64_t>(target) - static_cast<int64_t>(position + 4));
+        std::memcpy(code_.data() + position, &relative, 4);
+    };
+    for (const Patch& jump : jump_patches_) patch(jump.position, labels_[jump.target]);
+    while (code_.size() % 8 != 0) byte(0xCC); // int3: выравнивание пула
+    size_t pool = code_.size();
+    for (uint64_t bits : constants_) qword(bits);
+    for (const Patch& reference : constant_patches_) patch(reference.position, pool + 8 * reference.target);
+    return code_;
+}
+
+namespace {
+
+constexpr size_t kRegionSize = 64 * 1024;
+
+} // namespace
+
+const void* ExecutableMemory::add(const std::vector<uint8_t>& code) {
+    size_t size = (code.size() + 15) & ~size_t(15);
+    if (regions_.empty() || regions_.back().size - regions_.back().used < size) {
+        size_t region = size > kRegionSize ? (size + 4095) & ~size_t(4095) : kRegionSize;
+        void* base = mmap(nullptr, region, PROT_READ | PROT_EXEC, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (base == MAP_FAILED) return nullptr;
+        regions_.push_back({static_cast<uint8_t*>(base), region, 0});
+    }
+    Region& region = regions_.back();
+    // Страницы региона открываются на запись только на время копирования
+    if (mprotect(region.base, region.size, PROT_READ | PROT_WRITE) != 0) return nullptr;
+    uint8_t* target = region.base + region.used;
+    std::memcpy(target, code.data(), code.size());
+    region.used += size;
+    if (mprotect(region.base, region.size, PROT_READ | PROT_EXEC) != 0) return nullptr;
+    return target;
+}
+
+void ExecutableMemory::clear() {
+    for (const Region& region : regions_) munmap(region.base, region.size);
+    regions_.clear();
+}
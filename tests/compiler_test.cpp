@@ -0,0 +1,71 @@
+// Bytecode variable instructions address only the global scope, so a variable the Resolver
+// bound to an enclosing scope (depth != 0) must make Compiler::compile throw instead of
+// silently reading a slot of the wrong scope.
+//
+//   mathsol_test_compiler
+#include <cstdio>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include "compiler.hpp"
+#include "lexer.hpp"
+#include "parser.hpp"
+#include "resolver.hpp"
+
+namespace {
+
+IStatement* parse(const std::string& source, AstArena& arena) {
+  Lexer lex;
+  std::vector<Token> tokens = lex.tokenizeAll(source + "\n");
+  Parser parser(tokens, arena);
+  IStatement* statement = parser.parseNext();
+  return parser.hasError() ? nullptr : statement;
+}
+
+// Compiles `source` after `x = 1` was resolved in the global scope, with `scopes` nested
+// scopes opened in between; returns whether the compiler accepted it
+bool compiles(const std::string& source, int scopes) {
+  AstArena arena;
+  Resolver resolver;
+  IStatement* global = parse("x = 1", arena);
+  IStatement* statement = parse(source, arena);
+  if (!global || !statement) {
+    std::fprintf(stderr, "'%s': parse error\n", source.c_str());
+    return false;
+  }
+  resolver.resolve(*global);
+  for (int i = 0; i < scopes; ++i) resolver.pushScope();
+  resolver.resolve(*statement);
+
+  Compiler compiler;
+  Chunk chunk;
+  try {
+    compiler.compile(*statement, chunk);
+  } catch (const std::logic_error&) {
+    return false;
+  }
+  return true;
+}
+
+} // namespace
+
+int main() {
+  bool ok = true;
+  for (const char* source : {"x + 1", "x += 1", "x = 2"}) {
+    if (!compiles(source, 0)) {
+      std::fprintf(stderr, "'%s' in the global scope: rejected\n", source);
+      ok = false;
+    }
+  }
+  // x is found one and two scopes up; "x = 2" would declare a new x in the nested scope
+  for (const char* source : {"x + 1", "x += 1"}) {
+    for (int scopes : {1, 2}) {
+      if (compiles(source, scopes)) {
+        std::fprintf(stderr, "'%s' from %d nested scope(s): compiled\n", source, scopes);
+        ok = false;
+      }
+    }
+  }
+  std::printf("%s\n", ok ? "ok" : "FAILED");
+  return ok ? 0 : 1;
+}
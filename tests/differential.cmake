@@ -0,0 +1,102 @@
+# Дифференциальный тест: выполняет одну программу всеми способами и сравнивает вывод (stdout,
+# stderr и код возврата) с эталоном - обходом дерева (--engine=tree).
+#
+#   cmake -DMATHSOL=<mathsol> -DWORK_DIR=<каталог> -DSCRIPT=<file.msol> -P differential.cmake
+#   cmake -DMATHSOL=<mathsol> -DWORK_DIR=<каталог> -DGENERATOR=<mathsol_generate> -DSEED=<N>
+#         [-DSTATEMENTS=<N>] -P differential.cmake
+#
+# JIT=ON добавляет --jit, AOT=ON - --aot (нужен cc). Программа копируется в WORK_DIR, поэтому
+# __mathsol_cache__ и файлы --aot не попадают в исходники; VM выполняется дважды, чтобы
+# второй запуск прочитал байткод из кэша.
+
+if(NOT MATHSOL OR NOT WORK_DIR)
+    message(FATAL_ERROR "MATHSOL and WORK_DIR are required")
+endif()
+
+file(REMOVE_RECURSE "${WORK_DIR}")
+file(MAKE_DIRECTORY "${WORK_DIR}")
+
+if(SCRIPT)
+    get_filename_component(name "${SCRIPT}" NAME)
+    set(program "${WORK_DIR}/${name}")
+    configure_file("${SCRIPT}" "${program}" COPYONLY)
+elseif(GENERATOR)
+    if(NOT STATEMENTS)
+        set(STATEMENTS 400)
+    endif()
+    set(name "generated_${SEED}.msol")
+    set(program "${WORK_DIR}/${name}")
+    execute_process(COMMAND "${GENERATOR}" "${SEED}" "${STATEMENTS}"
+                    OUTPUT_FILE "${program}" RESULT_VARIABLE status)
+    if(NOT status EQUAL 0)
+        message(FATAL_ERROR "${GENERATOR} failed: ${status}")
+    endif()
+else()
+    message(FATAL_ERROR "SCRIPT or GENERATOR is required")
+endif()
+
+# Выполняет программу с опциями options (строка через пробел) в out, err и rc
+function(run options)
+    separate_arguments(arguments UNIX_COMMAND "${options}")
+    execute_process(COMMAND "${MATHSOL}" ${arguments} "${name}"
+                    WORKING_DIRECTORY "${WORK_DIR}"
+                    OUTPUT_VARIABLE output ERROR_VARIABLE error RESULT_VARIABLE status)
+    set(out "${output}" PARENT_SCOPE)
+    set(err "${error}" PARENT_SCOPE)
+    set(rc "${status}" PARENT_SCOPE)
+endfunction()
+
+run("--engine=tree")
+if(NOT rc MATCHES "^[01]$")
+    message(FATAL_ERROR "${MATHSOL} did not run ${name}: ${rc}\n${err}")
+endif()
+set(expected_out "${out}")
+set(expected_err "${err}")
+set(expected_rc "${rc}")
+
+set(modes
+    "--engine=tree --no-fold"
+    "--engine=tree --no-cse"
+    "--engine=tree --no-infer"
+    "--engine=tree --jobs=4"
+    "--engine=flat"
+    "--engine=flat --no-infer"
+    "--engine=vm --no-cache"
+    "--engine=vm --no-cache --no-infer"
+    "--engine=vm"
+    "--engine=vm")
+if(JIT)
+    list(APPEND modes "--jit --no-cache" "--jit")
+endif()
+
+foreach(mode IN LISTS modes)
+    run("${mode}")
+    if(NOT rc STREQUAL expected_rc OR NOT out STREQUAL expected_out OR NOT err STREQUAL expected_err)
+        message(FATAL_ERROR "${name}: ${mode} differs from --engine=tree\n"
+                            "--- --engine=tree (exit ${expected_rc})\n${expected_out}${expected_err}"
+                            "--- ${mode} (exit ${rc})\n${out}${err}")
+    endif()
+endforeach()
+
+# Программа, которая выполнилась без ошибок, должна остаться в кэше (второй запуск VM выше
+# читал именно его)
+if(expected_rc EQUAL 0 AND NOT EXISTS "${WORK_DIR}/__mathsol_cache__/${name}.msc")
+    message(FATAL_ERROR "${name}: --engine=vm did not cache the bytecode")
+endif()
+
+# --aot разбирает файл целиком до выполнения, поэтому об ошибке разбора сообщает раньше
+# эталона: у программ с ошибкой сравнивается только то, что она не выполнилась. Второй
+# запуск берет готовую библиотеку, третий должен пересобрать ее по штампу с другой опцией.
+if(AOT)
+    foreach(mode "--aot" "--aot" "--aot --no-infer")
+        run("${mode}")
+        if(expected_rc EQUAL 0)
+            if(NOT rc EQUAL 0 OR NOT out STREQUAL expected_out)
+                message(FATAL_ERROR "${name}: ${mode} differs from --engine=tree\n"
+                                    "--- --engine=tree\n${expected_out}--- ${mode} (exit ${rc})\n${out}${err}")
+            endif()
+        elseif(rc EQUAL 0)
+            message(FATAL_ERROR "${name}: ${mode} succeeded, --engine=tree failed with\n${expected_err}")
+        endif()
+    endforeach()
+endif()
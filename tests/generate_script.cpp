@@ -0,0 +1,157 @@
+#include <cstdint>
+#include <cstdlib>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+// Генератор программ для дифференциального теста (differential.cmake):
+//   mathsol_generate SEED [STATEMENTS]
+// печатает случайную программу, которую все способы выполнения должны выполнить одинаково.
+// Программа корректна по типам (числа, bool и строки в своих переменных), поэтому ошибка
+// времени выполнения не обрывает ее на первых строках и проверяются все инструкции.
+// Часть инструкций повторяется, чтобы они стали горячими для --jit.
+
+namespace {
+
+class Generator {
+public:
+    explicit Generator(uint32_t seed) : random_(seed) {}
+
+    std::string statement() {
+        int kind = below(100);
+        if (kind < 12 && !hot_.empty()) return hot_[below(static_cast<int>(hot_.size()))];
+        if (kind < 20) {
+            std::string target = pick(kNumbers) + " = "; // nan и inf не должны остаться навсегда
+            return target + literal();
+        }
+        if (kind < 40) {
+            std::string target = pick(kNumbers) + " " + pick(kAssignments) + " ";
+            std::string line = target + number(3);
+            if (kind < 25) remember(line);
+            return line;
+        }
+        if (kind < 47) {
+            std::string target = pick(kBools) + " = ";
+            return target + boolean(2);
+        }
+        if (kind < 50) {
+            std::string target = pick(kStrings) + " = " + (kind % 2 ? pick(kStrings) + " + " : "");
+            return target + text();
+        }
+        if (kind < 52) return "s += \"x\"";
+        if (kind < 70) return boolean(3);
+        if (kind < 74) return string(2);
+        std::string line = number(4);
+        if (kind < 80) remember(line);
+        return line;
+    }
+
+    // Начальные значения всех переменных
+    static std::string prologue() {
+        return "a = 1.5\nb = 2\nc = 0\nd = -3\np = true\nq = false\ns = \"ab\"\nt = \"b\"\n";
+    }
+
+private:
+    static inline const std::vector<std::string> kNumbers = {"a", "b", "c", "d"};
+    static inline const std::vector<std::string> kBools = {"p", "q"};
+    static inline const std::vector<std::string> kStrings = {"s", "t"};
+    static inline const std::vector<std::string> kAssignments = {"=", "=", "+=", "-=", "*=", "/="};
+    static inline const std::vector<std::string> kArithmetic = {"+", "+", "-", "-", "*", "*", "/", "%"};
+    static inline const std::vector<std::string> kComparisons = {"<", "<=", ">", ">=", "==", "!="};
+    static inline const std::vector<std::string> kLogic = {"and", "or", "&&", "||"};
+    static constexpr size_t kHotStatements = 16;
+
+    std::mt19937 random_;
+    std::vector<std::string> hot_; // Инструкции над числами для повторения
+
+    int below(int bound) {
+        return static_cast<int>(random_() % static_cast<uint32_t>(bound));
+    }
+
+    const std::string& pick(const std::vector<std::string>& items) {
+        return items[below(static_cast<int>(items.size()))];
+    }
+
+    void remember(const std::string& line) {
+        if (hot_.size() < kHotStatements) hot_.push_back(line);
+        else hot_[below(static_cast<int>(hot_.size()))] = line;
+    }
+
+    std::string literal() {
+        if (below(2)) return std::to_string(below(10));
+        int hundredths = below(100);
+        std::string text = std::to_string(below(10));
+        text.append(hundredths < 10 ? ".0" : ".");
+        return text.append(std::to_string(hundredths));
+    }
+
+    std::string number(int depth) {
+        int kind = below(100);
+        if (depth == 0 || kind < 30) return kind % 2 ? pick(kNumbers) : literal();
+        if (kind < 40) return wrap("-(", number(depth - 1), ")");
+        if (kind < 45) return binary({number(depth - 1), "**", std::to_string(below(4))});
+        return binary({number(depth - 1), pick(kArithmetic), number(depth - 1)});
+    }
+
+    std::string boolean(int depth) {
+        int kind = below(100);
+        if (depth == 0 || kind < 15) {
+            if (kind % 3 == 0) return kind % 2 ? "true" : "false";
+            return pick(kBools);
+        }
+        if (kind < 45) return comparison({number(2), pick(kComparisons), number(2)});
+        if (kind < 55) return comparison({string(1), pick(kComparisons), string(1)});
+        if (kind < 65) return wrap(kind % 2 ? "not (" : "!(", boolean(depth - 1), ")");
+        return binary({boolean(depth - 1), pick(kLogic), boolean(depth - 1)});
+    }
+
+    std::string text() {
+        size_t length = 1 + below(4);
+        return wrap("\"", std::string(length, static_cast<char>('a' + below(3))), "\"");
+    }
+
+    // Присваивания строк удлиняют их не больше чем на литерал, чтобы длина росла линейно
+    std::string string(int depth) {
+        int kind = below(100);
+        if (depth == 0 || kind < 50) return kind % 3 ? pick(kStrings) : text();
+        return binary({string(depth - 1), "+", string(depth - 1)});
+    }
+
+    // Части операции. Элементы {...} вычисляются слева направо, а аргументы функции - в
+    // незаданном порядке; программа для SEED не должна зависеть от компилятора
+    struct Operation {
+        std::string left, op, right;
+    };
+
+    static std::string binary(const Operation& operation) {
+        return wrap("(", comparison(operation), ")");
+    }
+
+    static std::string comparison(const Operation& operation) {
+        std::string text = operation.left;
+        return text.append(" ").append(operation.op).append(" ").append(operation.right);
+    }
+
+    // Склейка через append: на "..." + std::string и insert GCC 12 выдает ложное -Wrestrict
+    static std::string wrap(const char* open, const std::string& inner, const char* close) {
+        std::string text = open;
+        return text.append(inner).append(close);
+    }
+};
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    if (argc < 2) {
+        std::cerr << "Usage: mathsol_generate SEED [STATEMENTS]\n";
+        return 2;
+    }
+    uint32_t seed = static_cast<uint32_t>(std::strtoul(argv[1], nullptr, 10));
+    unsigned long statements = argc > 2 ? std::strtoul(argv[2], nullptr, 10) : 400;
+
+    Generator generator(seed);
+    std::cout << Generator::prologue();
+    for (unsigned long i = 0; i < statements; ++i) std::cout << generator.statement() << "\n";
+    return 0;
+}
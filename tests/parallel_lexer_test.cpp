@@ -0,0 +1,84 @@
+// Lexer::tokenizeParallel must produce exactly the tokens of tokenizeAll.
+//
+//   mathsol_test_parallel_lexer
+//
+// Real scripts need megabytes before they are split (Lexer::kMinParallelSegment), so the
+// script here is lexed with segments of a few hundred bytes, cut inside comments and
+// inside strings that span one or several segments, with an unterminated string at the end.
+#include <cstdio>
+#include <string>
+#include <vector>
+#include "lexer.hpp"
+#include "thread_pool.hpp"
+
+namespace {
+
+std::string script() {
+  std::string text;
+  for (int i = 0; i < 2000; ++i) {
+    std::string n = std::to_string(i);
+    switch (i % 7) {
+      case 0: text += "name_" + n + " = " + n + ".25 * (other - 3) # comment " + n + " with \"quotes\n"; break;
+      case 1: text += "s = \"a string over\n\nseveral lines " + n + "\"\n"; break;
+      case 2: text += "# only a comment, long enough to hold a cut: " + std::string(i % 200, '#') + "\n"; break;
+      case 3: text += "flag = not true and x_" + n + " >= 18446744073709551616\n"; break;
+      case 4: text += "t = \"" + std::string(i % 300, 'x') + "\n" + std::string(i % 500, 'y') + "\"\n"; break;
+      case 5: text += "\n\n"; break;
+      default: text += "y" + n + " += \"one line\" + 'single " + n + "'\n"; break;
+    }
+    if (i == 1000) text += "big = \"" + std::string(5000, '\n') + "\"\n"; // spans many segments
+  }
+  return text + "tail = \"never closed\n";
+}
+
+bool sameTokens(const std::vector<Token>& expected, const SymbolTable& expectedSymbols,
+                const std::vector<Token>& actual, const SymbolTable& actualSymbols, size_t minSegment) {
+  if (expected.size() != actual.size()) {
+    std::fprintf(stderr, "segments of %zu: %zu tokens, expected %zu\n", minSegment, actual.size(), expected.size());
+    return false;
+  }
+  for (size_t i = 0; i < expected.size(); ++i) {
+    const Token& e = expected[i];
+    const Token& a = actual[i];
+    bool same = e.getType() == a.getType() && e.getValue() == a.getValue() &&
+                e.getLine() == a.getLine() && e.getColumn() == a.getColumn() &&
+                e.getError() == a.getError();
+    if (same && e.getType() == TokenType::IDENTIFIER) {
+      same = expectedSymbols.name(e.getSymbol()) == actualSymbols.name(a.getSymbol());
+    }
+    if (same && e.getType() == TokenType::CONSTANT_NUM) {
+      same = e.isInteger() == a.isInteger() && e.getNumber() == a.getNumber();
+    }
+    if (!same) {
+      std::fprintf(stderr, "segments of %zu: token %zu differs: %u:%u '%.*s', expected %u:%u '%.*s'\n",
+                   minSegment, i, a.getLine(), a.getColumn(), static_cast<int>(a.getValue().size()),
+                   a.getValue().data(), e.getLine(), e.getColumn(),
+                   static_cast<int>(e.getValue().size()), e.getValue().data());
+      return false;
+    }
+  }
+  return true;
+}
+
+} // namespace
+
+int main() {
+  std::string source = script();
+  SymbolTable expectedSymbols;
+  Lexer reference;
+  reference.setSymbolTable(expectedSymbols);
+  std::vector<Token> expected = reference.tokenizeAll(source);
+
+  bool ok = true;
+  for (size_t threads : {2, 4}) {
+    ThreadPool pool(threads);
+    for (size_t minSegment : {64, 300, 4096, 65536}) {
+      SymbolTable symbols;
+      Lexer lex;
+      lex.setSymbolTable(symbols);
+      ok = sameTokens(expected, expectedSymbols, lex.tokenizeParallel(source, pool, minSegment), symbols, minSegment) && ok;
+    }
+  }
+  std::printf("%zu bytes, %zu tokens: %s\n", source.size(), expected.size(), ok ? "same" : "DIFFERENT");
+  return ok ? 0 : 1;
+}